@@ -1,35 +1,11 @@
 #include <iostream>
+#include <string>
+#include "cstar_runtime.h"
 
 int main() {
-
-    int count;
-    
-    int result;
-    
-    float pi;
-    
     std::string helloWorld;
-    
-    bool myBool;
-    
-    char bleh;
-    
-    double d;
-    
-    count = 10;
-    
-    pi = 3.140000;
-    
+    helloWorld = "";
     helloWorld = "Hello, World!";
-    
-    myBool = true;
-    
-    std::cout << helloWorld << std::endl;
-    
-    std::cout << myBool << std::endl;
-    
-    std::cout << pi << std::endl;
-    
-    std::cout << count << std::endl;
+    cstar::print(helloWorld, "\n1\n", 3.14f, "\n10\n");
     return 0;
 }
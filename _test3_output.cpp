@@ -1,23 +1,32 @@
 #include <iostream>
+#include <string>
+#include "cstar_runtime.h"
 
 int main() {
-
-    int count = 0;
-    
-    while ((count <= 20)) {
-        if ((((count % 3) == 0) && ((count % 5) == 0))) {
-            std::cout << "FizzBuzz" << std::endl;
-        }
-        else         if (((count % 3) == 0)) {
-            std::cout << "Fizz" << std::endl;
-        }
-        else         if (((count % 5) == 0)) {
-            std::cout << "Buzz" << std::endl;
-        }
-        else {
-            std::cout << count << std::endl;
-        }
-        count = (count + 1);
-    }
+    int count;
+    bool _cse1;
+    bool _cse0;
+    count = 0;
+L1:
+    if (!(count <= 20)) goto L10;
+    _cse1 = ((count % 3) == 0);
+    _cse0 = ((count % 5) == 0);
+    if (!(_cse1 && _cse0)) goto L4;
+    cstar::print("FizzBuzz\n");
+    goto L9;
+L4:
+    if (!_cse1) goto L6;
+    cstar::print("Fizz\n");
+    goto L9;
+L6:
+    if (!_cse0) goto L8;
+    cstar::print("Buzz\n");
+    goto L9;
+L8:
+    cstar::println(count);
+L9:
+    count = (count + 1);
+    goto L1;
+L10:
     return 0;
 }
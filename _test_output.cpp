@@ -1,42 +1,16 @@
 #include <iostream>
+#include <string>
+#include "cstar_runtime.h"
 
 int main() {
-
     int count;
-    
-    int result;
-    
-    float pi;
-    
-    std::string helloWorld;
-    
-    bool myBool;
-    
-    char bleh;
-    
-    double d;
-    
+    count = 0;
     count = 10;
-    
-    pi = 3.140000;
-    
-    helloWorld = "Hello, World!";
-    
-    myBool = true;
-    
-    if ((count >= 10)) {
-        count = (count + 1);
-        bleh = 'S';
-    }
-    else {
-        count = (count - 1);
-    }
-    
-    result = 5;
-    
-    if ((result == 5)) {
-    }
-    
-    d = 0.500000;
+    if (!(count >= 10)) goto L2;
+    count = (count + 1);
+    goto L3;
+L2:
+    count = (count - 1);
+L3:
     return 0;
 }
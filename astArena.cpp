@@ -0,0 +1,72 @@
+#include <cstdlib>
+#include "astArena.h"
+
+AstArena::AstArena(size_t blockSize) : blockSize(blockSize)
+{
+}
+
+AstArena::~AstArena()
+{
+    reset();
+}
+
+void *AstArena::allocate(size_t bytes, size_t align)
+{
+    size_t pad = (align - reinterpret_cast<size_t>(cursor) % align) % align;
+    if (cursor == nullptr || pad + bytes > static_cast<size_t>(limit - cursor))
+    {
+        newBlock(bytes + align);
+        pad = (align - reinterpret_cast<size_t>(cursor) % align) % align;
+    }
+
+    char *result = cursor + pad;
+    cursor = result + bytes;
+    counters.objects++;
+    counters.bytesRequested += pad + bytes;
+    return result;
+}
+
+// Oversized requests get a block of their own
+void AstArena::newBlock(size_t minBytes)
+{
+    size_t size = sizeof(Block) + (minBytes > blockSize ? minBytes : blockSize);
+    Block *block = static_cast<Block *>(std::malloc(size));
+    if (block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    block->next = blocks;
+    block->size = size;
+    blocks = block;
+
+    cursor = reinterpret_cast<char *>(block + 1);
+    limit = reinterpret_cast<char *>(block) + size;
+    counters.blocks++;
+    counters.bytesReserved += size;
+}
+
+void AstArena::reset()
+{
+    // Newest objects first, mirroring normal destruction order
+    for (DtorRecord *rec = dtors; rec != nullptr; rec = rec->next)
+    {
+        rec->destroy(rec->object);
+    }
+    dtors = nullptr;
+
+    while (blocks != nullptr)
+    {
+        Block *next = blocks->next;
+        std::free(blocks);
+        blocks = next;
+    }
+    cursor = nullptr;
+    limit = nullptr;
+}
+
+void AstArena::printStats(std::ostream &out) const
+{
+    out << "AST arena: " << counters.objects << " objects, "
+        << counters.bytesRequested << " bytes in "
+        << counters.blocks << " block(s) (" << counters.bytesReserved << " bytes reserved)\n";
+}
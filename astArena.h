@@ -0,0 +1,133 @@
+#ifndef ASTARENA_H
+#define ASTARENA_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <iostream>
+
+template <typename T>
+class ArenaAllocator;
+
+// True if T's destructor releases nothing, so the arena can skip it.
+// Specialize for classes that are only non-trivial through a virtual destructor
+template <typename T>
+struct ArenaSkipsDestructor : std::is_trivially_destructible<T>
+{
+};
+
+// Bump allocator that owns every AST node of one compilation.
+// Nodes are carved out of large blocks and released together when the
+// arena is reset or destroyed, instead of one heap allocation per node.
+class AstArena
+{
+public:
+	// Counters for checking how much work the arena saved
+	struct Stats
+	{
+		size_t objects = 0;       // objects handed out (nodes, list buffers)
+		size_t bytesRequested = 0; // bytes handed out, including padding
+		size_t blocks = 0;        // blocks requested from the system
+		size_t bytesReserved = 0; // total size of those blocks
+	};
+
+	explicit AstArena(size_t blockSize = 64 * 1024);
+	~AstArena();
+
+	AstArena(const AstArena &) = delete;
+	AstArena &operator=(const AstArena &) = delete;
+
+	// Raw, aligned storage; never freed individually
+	void *allocate(size_t bytes, size_t align);
+
+	// Construct a T in the arena; its destructor runs when the arena is reset
+	template <typename T, typename... Args>
+	T *make(Args &&...args)
+	{
+		if (ArenaSkipsDestructor<T>::value)
+		{
+			return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		// Destructor record sits in front of the object
+		size_t header = (sizeof(DtorRecord) + alignof(T) - 1) / alignof(T) * alignof(T);
+		size_t align = alignof(T) > alignof(DtorRecord) ? alignof(T) : alignof(DtorRecord);
+		char *mem = static_cast<char *>(allocate(header + sizeof(T), align)) + header;
+		T *object = new (mem) T(std::forward<Args>(args)...);
+
+		DtorRecord *rec = reinterpret_cast<DtorRecord *>(mem) - 1;
+		rec->destroy = [](void *p) { static_cast<T *>(p)->~T(); };
+		rec->object = object;
+		rec->next = dtors;
+		dtors = rec;
+		return object;
+	}
+
+	// Empty vector whose buffer is allocated from this arena
+	template <typename T>
+	std::vector<T, ArenaAllocator<T>> list();
+
+	// Run all destructors and return every block to the system
+	void reset();
+
+	const Stats &stats() const { return counters; }
+	void printStats(std::ostream &out) const;
+
+private:
+	struct Block
+	{
+		Block *next;
+		size_t size;
+	};
+
+	struct DtorRecord
+	{
+		void (*destroy)(void *);
+		void *object;
+		DtorRecord *next;
+	};
+
+	size_t blockSize;
+	Block *blocks = nullptr;
+	char *cursor = nullptr;
+	char *limit = nullptr;
+	DtorRecord *dtors = nullptr;
+	Stats counters;
+
+	void newBlock(size_t minBytes);
+};
+
+// std allocator adapter so child lists live in the arena too
+template <typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+
+	AstArena *arena;
+
+	explicit ArenaAllocator(AstArena *arena) : arena(arena) {}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+	T *allocate(size_t n) { return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T))); }
+	void deallocate(T *, size_t) {} // released with the arena
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+template <typename T>
+ArenaVector<T> AstArena::list()
+{
+	return ArenaVector<T>(ArenaAllocator<T>(this));
+}
+
+#endif // ASTARENA_H
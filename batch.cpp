@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "batch.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+struct FileResult
+{
+    std::string out;
+    std::string diagnostics;
+    int status = 0;
+    double ms = 0;
+    bool done = false;
+};
+
+// '*' matches any run of characters, '?' any single one
+bool wildcardMatch(const char *pattern, const char *text)
+{
+    if (*pattern == '\0')
+        return *text == '\0';
+    if (*pattern == '*')
+        return wildcardMatch(pattern + 1, text) || (*text != '\0' && wildcardMatch(pattern, text + 1));
+    if (*text == '\0')
+        return false;
+    return (*pattern == '?' || *pattern == *text) && wildcardMatch(pattern + 1, text + 1);
+}
+
+// Matches of one directory, sorted so the batch order never depends on the filesystem
+std::vector<std::string> listDirectory(const fs::path &dir, const std::string &pattern)
+{
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (const fs::directory_entry &entry : fs::directory_iterator(dir.empty() ? fs::path(".") : dir, ec))
+    {
+        std::string name = entry.path().filename().string();
+        if (entry.is_regular_file(ec) && wildcardMatch(pattern.c_str(), name.c_str()))
+            files.push_back((dir / name).string());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::vector<std::string> expandInputs(const std::vector<std::string> &inputs)
+{
+    std::vector<std::string> files;
+    for (const std::string &input : inputs)
+    {
+        std::error_code ec;
+        fs::path path(input);
+        std::string name = path.filename().string();
+        std::vector<std::string> matches;
+        if (name.find_first_of("*?") != std::string::npos)
+            matches = listDirectory(path.parent_path(), name);
+        else if (fs::is_directory(path, ec))
+            matches = listDirectory(path, "*.cstar");
+        else
+            matches.push_back(input); // a missing file is reported by the pipeline itself
+
+        if (matches.empty())
+            std::cerr << "No .cstar files match: " << input << "\n";
+        files.insert(files.end(), matches.begin(), matches.end());
+    }
+    return files;
+}
+
+} // namespace
+
+int runBatch(const std::vector<std::string> &inputs, const CompileOptions &options, unsigned jobs)
+{
+    auto batchStart = std::chrono::steady_clock::now();
+
+    std::vector<std::string> files = expandInputs(inputs);
+    if (files.empty())
+    {
+        std::cerr << "No input files for --batch\n";
+        return 1;
+    }
+
+    std::vector<FileResult> results(files.size());
+    std::atomic<size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    // Each worker claims the next unstarted file; nothing but the result slot is shared
+    auto worker = [&]()
+    {
+        for (size_t i = next.fetch_add(1); i < files.size(); i = next.fetch_add(1))
+        {
+            std::ostringstream out, diagnostics;
+            auto start = std::chrono::steady_clock::now();
+            int status = compileFile(files[i], options, out, diagnostics);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            results[i].out = out.str();
+            results[i].diagnostics = diagnostics.str();
+            results[i].status = status;
+            results[i].ms = ms;
+            results[i].done = true;
+            finished.notify_all();
+        }
+    };
+
+    jobs = std::max(1u, std::min<unsigned>(jobs, static_cast<unsigned>(files.size())));
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < jobs; i++)
+        pool.emplace_back(worker);
+
+    // Print in input order as soon as each file (and every file before it) is done
+    int failures = 0;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&]() { return results[i].done; });
+        lock.unlock();
+
+        std::cout << "===== " << files[i] << " =====\n" << results[i].out;
+        std::cout.flush();
+        std::cerr << results[i].diagnostics;
+        std::cerr.flush();
+        if (results[i].status != 0)
+            failures++;
+    }
+
+    for (std::thread &thread : pool)
+        thread.join();
+
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - batchStart).count();
+    double cpuMs = 0;
+    size_t width = 4;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        cpuMs += results[i].ms;
+        width = std::max(width, files[i].size());
+    }
+
+    std::ios::fmtflags flags = std::cout.flags();
+    std::cout << "\n===== BATCH SUMMARY =====\n" << std::fixed << std::setprecision(3);
+    std::cout << std::left << std::setw(static_cast<int>(width)) << "File" << std::right
+              << std::setw(12) << "Time (ms)" << "  Status\n";
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        std::cout << std::left << std::setw(static_cast<int>(width)) << files[i] << std::right
+                  << std::setw(12) << results[i].ms << "  "
+                  << (results[i].status == 0 ? "ok" : "failed (" + std::to_string(results[i].status) + ")") << "\n";
+    }
+    std::cout << files.size() << " files, " << failures << " failed, " << jobs << " jobs: "
+              << wallMs << " ms wall, " << cpuMs << " ms summed per file\n";
+    std::cout.flags(flags);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,15 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+#include "pipeline.h"
+
+// --batch: compile many files in one process on a pool of worker threads.
+// Inputs may be files, directories (every *.cstar inside) or simple
+// wildcards such as tests/*.cstar. Each file's output and diagnostics are
+// buffered and printed in input order, followed by a timing summary.
+// Returns 0 if every file compiled, 1 otherwise.
+int runBatch(const std::vector<std::string> &inputs, const CompileOptions &options, unsigned jobs);
+
+#endif // BATCH_H
@@ -0,0 +1,18 @@
+@echo off
+:: Builds the benchmarks into the repo root. Run from the repo root.
+
+echo Building lexer_bench...
+g++ -O2 -std=c++17 -I. bench/lexer_bench.cpp tokenizer.cpp stringInterner.cpp -o lexer_bench
+if errorlevel 1 (
+    echo Build failed!
+    exit /b 1
+)
+
+echo Building cstar_bench...
+g++ -O2 -std=c++17 -I. bench/cstar_bench.cpp tokenizer.cpp parser.cpp astArena.cpp semanticAnalyzer.cpp optimizer.cpp ir.cpp codegenerator.cpp stringInterner.cpp types.cpp -o cstar_bench
+if errorlevel 1 (
+    echo Build failed!
+    exit /b 1
+)
+
+echo Done. Run cstar_bench.exe for all sweeps; options are listed at the top of bench\cstar_bench.cpp.
@@ -0,0 +1,458 @@
+// Whole-compiler benchmark on synthetic programs.
+// Generates large, deterministic C* programs and times every phase
+// (tokenize, parse, semantic, optimize, codegen incl. IR) separately and end to end.
+// Each sweep varies one generator parameter and reports the cost per
+// token of every phase, which stays flat for linear phases.
+//
+// Build from the repo root (or run bench\build_bench.bat):
+//   g++ -O2 -std=c++17 -I. bench/cstar_bench.cpp tokenizer.cpp parser.cpp astArena.cpp
+//       semanticAnalyzer.cpp optimizer.cpp ir.cpp codegenerator.cpp stringInterner.cpp types.cpp
+//       -o cstar_bench
+//
+// Usage:
+//   cstar_bench [--sweep all|statements|expr|depth|fanout|identifiers]
+//               [--statements N] [--depth D] [--expr-length L] [--identifiers I]
+//               [--switch-fanout F] [--seed S] [--reps R] [--no-opt]
+//   cstar_bench --emit program.cstar [generator options]   (write one program and exit)
+//
+// Exits with 2 if any phase's cost per token more than doubles across a sweep.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "tokenizer.h"
+#include "parser.h"
+#include "semanticAnalyzer.h"
+#include "optimizer.h"
+#include "ir.h"
+#include "codegenerator.h"
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct WorkloadParams
+{
+    int statements = 2000;  // statements in total, nested ones included
+    int depth = 3;          // deepest if/while/switch nesting
+    int exprLength = 4;     // operands per arithmetic expression
+    int identifiers = 64;   // distinct variables
+    int switchFanout = 4;   // cases per switch (plus a default)
+    uint32_t seed = 1;
+};
+
+// Same parameters and seed always give the same program, on every platform
+class ProgramGenerator
+{
+public:
+    explicit ProgramGenerator(const WorkloadParams &params) : params(params), state(params.seed * 2654435761u + 1) {}
+
+    std::string generate()
+    {
+        out.clear();
+        remaining = params.statements;
+        for (int i = 0; i < params.identifiers; i++)
+            out += "int v" + std::to_string(i) + " = " + std::to_string(i % 10) + ";\n";
+        while (remaining > 0)
+            statement(0);
+        return out;
+    }
+
+    int deepestNesting() const { return deepest; }
+
+private:
+    const WorkloadParams &params;
+    uint32_t state;
+    std::string out;
+    int remaining = 0;
+    int deepest = 0;
+
+    // xorshift32: tiny, fast and identical everywhere (unlike std distributions)
+    uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    int below(int n) { return static_cast<int>(next() % static_cast<uint32_t>(n)); }
+
+    std::string variable() { return "v" + std::to_string(below(params.identifiers)); }
+
+    void indent(int depth) { out.append(depth * 4, ' '); }
+
+    void expression()
+    {
+        static const char *const OPS[] = {" + ", " - ", " * "};
+        for (int i = 0; i < params.exprLength; i++)
+        {
+            if (i > 0)
+                out += OPS[below(3)];
+            if (below(3) == 0)
+                out += std::to_string(below(100));
+            else
+                out += variable();
+        }
+    }
+
+    void condition()
+    {
+        static const char *const COMPARE[] = {" < ", " <= ", " > ", " >= ", " = ", " != "};
+        out += variable() + COMPARE[below(6)];
+        expression();
+        if (below(4) == 0)
+            out += " && " + variable() + " != 0";
+    }
+
+    void block(int depth)
+    {
+        out += " {\n";
+        int count = 1 + below(3);
+        for (int i = 0; i < count && remaining > 0; i++)
+            statement(depth + 1);
+        indent(depth);
+        out += "}";
+    }
+
+    void statement(int depth)
+    {
+        remaining--;
+        deepest = std::max(deepest, depth);
+        indent(depth);
+
+        int kind = depth < params.depth ? below(20) : below(12);
+        if (kind < 10)
+        {
+            out += "set " + variable() + " = ";
+            expression();
+            out += ";\n";
+        }
+        else if (kind < 12)
+        {
+            out += "print(" + variable() + ");\n";
+        }
+        else if (kind < 15)
+        {
+            out += "if (";
+            condition();
+            out += ")";
+            block(depth);
+            if (below(2) == 0)
+            {
+                out += "\n";
+                indent(depth);
+                out += "elif (";
+                condition();
+                out += ")";
+                block(depth);
+            }
+            out += "\n";
+            indent(depth);
+            out += "else";
+            block(depth);
+            out += "\n";
+        }
+        else if (kind < 17)
+        {
+            std::string counter = variable();
+            out += "while (" + counter + " < " + std::to_string(below(100)) + ")";
+            block(depth);
+            out += "\n";
+        }
+        else
+        {
+            out += "switch (" + variable() + ") {\n";
+            for (int c = 0; c < params.switchFanout; c++)
+            {
+                indent(depth);
+                out += "    case (" + std::to_string(c) + "):\n";
+                if (remaining > 0)
+                    statement(depth + 2);
+                indent(depth + 2);
+                out += "break;\n";
+            }
+            indent(depth);
+            out += "    default:\n";
+            if (remaining > 0)
+                statement(depth + 2);
+            indent(depth);
+            out += "}\n";
+        }
+    }
+};
+
+// Best-of-reps time for every phase of one program
+struct Sample
+{
+    size_t bytes = 0;
+    size_t tokens = 0;
+    size_t nodes = 0;
+    size_t emitted = 0;
+    size_t diagnostics = 0; // bytes written to std::cerr; generated programs should be clean
+    double tokenize = 1e30;
+    double parse = 1e30;
+    double semantic = 1e30;
+    double optimize = 1e30;
+    double codegen = 1e30;
+    double total = 1e30;
+};
+
+Sample measure(const std::string &src, int reps, bool optimize)
+{
+    Sample s;
+    s.bytes = src.size();
+
+    std::ostringstream diagnostics;
+    std::streambuf *cerrBuf = std::cerr.rdbuf(diagnostics.rdbuf());
+    for (int r = 0; r < reps; r++)
+    {
+        Clock::time_point pipelineStart = Clock::now();
+
+        Clock::time_point start = Clock::now();
+        std::vector<Token> tokens;
+        StringInterner names;
+        Tokenizer tokenizer(src.data(), src.size(), names, std::cerr);
+        Token token;
+        do
+        {
+            token = tokenizer.getNextToken();
+            tokens.push_back(token);
+        } while (token.type != TokenType::END_OF_FILE);
+        s.tokenize = std::min(s.tokenize, msSince(start));
+
+        start = Clock::now();
+        AstArena arena;
+        Parser parser(tokens, arena);
+        std::vector<ParserNode *> program = parser.parse();
+        s.parse = std::min(s.parse, msSince(start));
+
+        start = Clock::now();
+        SemanticAnalyzer sem;
+        sem.analyze(program);
+        s.semantic = std::min(s.semantic, msSince(start));
+
+        s.nodes = arena.stats().objects;
+        if (optimize)
+        {
+            start = Clock::now();
+            ConstantFolder folder(arena);
+            folder.run(program);
+            DeadCodeEliminator eliminator(arena);
+            eliminator.run(program);
+            CommonSubexpressionEliminator cse(arena, names, sem);
+            cse.run(program);
+            s.optimize = std::min(s.optimize, msSince(start));
+        }
+        else
+        {
+            s.optimize = 0;
+        }
+
+        start = Clock::now();
+        std::ostringstream generated;
+        IrProgram ir;
+        IrBuilder irBuilder(diagnostics);
+        irBuilder.build(program, ir);
+        CodeEmitter emitter(generated);
+        emitter.emitProgram(ir);
+        s.codegen = std::min(s.codegen, msSince(start));
+
+        s.total = std::min(s.total, msSince(pipelineStart));
+        s.tokens = tokens.size();
+        s.emitted = static_cast<size_t>(generated.tellp());
+    }
+    std::cerr.rdbuf(cerrBuf);
+    s.diagnostics = diagnostics.str().size();
+    return s;
+}
+
+struct Sweep
+{
+    std::string name;
+    std::vector<int> values;
+    int WorkloadParams::*param;
+};
+
+bool runSweep(const Sweep &sweep, const WorkloadParams &base, int reps, bool optimize)
+{
+    std::cout << "\n=== sweep: " << sweep.name << " ===\n";
+    std::cout << std::left << std::setw(8) << sweep.name.substr(0, 7) << std::right
+              << std::setw(10) << "bytes" << std::setw(9) << "tokens" << std::setw(9) << "nodes"
+              << std::setw(10) << "lex ms" << std::setw(10) << "parse ms" << std::setw(10) << "sema ms"
+              << std::setw(10) << "opt ms" << std::setw(10) << "emit ms" << std::setw(10) << "total ms"
+              << std::setw(10) << "Mtok/s" << std::setw(10) << "Mnode/s" << "\n";
+
+    std::vector<Sample> samples;
+    bool superlinear = false;
+    for (int value : sweep.values)
+    {
+        WorkloadParams params = base;
+        params.*sweep.param = value;
+        ProgramGenerator generator(params);
+        std::string src = generator.generate();
+        Sample s = measure(src, reps, optimize);
+        samples.push_back(s);
+
+        std::cout << std::left << std::setw(8) << value << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << s.bytes << std::setw(9) << s.tokens << std::setw(9) << s.nodes
+                  << std::setw(10) << s.tokenize << std::setw(10) << s.parse << std::setw(10) << s.semantic
+                  << std::setw(10) << s.optimize << std::setw(10) << s.codegen << std::setw(10) << s.total
+                  << std::setw(10) << s.tokens / s.tokenize / 1e3
+                  << std::setw(10) << s.nodes / (s.parse + s.semantic) / 1e3 << "\n";
+        if (s.diagnostics > 0)
+            std::cout << "  warning: program produced " << s.diagnostics << " bytes of diagnostics\n";
+    }
+
+    // Cost per token should stay flat if a phase is linear in program size.
+    // The swept parameter may not change the token count (depth, fanout),
+    // so compare per-token cost rather than raw time.
+    const char *names[] = {"lex", "parse", "sema", "opt", "emit", "total"};
+    auto phaseMs = [](const Sample &s, int p)
+    {
+        const double times[] = {s.tokenize, s.parse, s.semantic, s.optimize, s.codegen, s.total};
+        return times[p];
+    };
+    std::cout << "ns/token    ";
+    for (const char *name : names)
+        std::cout << std::setw(9) << name;
+    std::cout << "\n";
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        std::cout << std::left << std::setw(12) << sweep.values[i] << std::right;
+        for (int p = 0; p < 6; p++)
+            std::cout << std::setw(9) << std::setprecision(1) << phaseMs(samples[i], p) * 1e6 / samples[i].tokens;
+        std::cout << "\n";
+    }
+
+    // Small programs are noisy; only flag a clear rise on timings that matter
+    const Sample &first = samples.front();
+    const Sample &last = samples.back();
+    for (int p = 0; p < 6; p++)
+    {
+        double before = phaseMs(first, p) / first.tokens;
+        double after = phaseMs(last, p) / last.tokens;
+        if (before > 0 && after > 2.0 * before && phaseMs(last, p) > 5.0)
+        {
+            std::cout << "SUPERLINEAR: " << names[p] << " cost per token grew "
+                      << std::setprecision(1) << after / before << "x across this sweep\n";
+            superlinear = true;
+        }
+    }
+    return !superlinear;
+}
+
+int intArg(const std::string &text, const std::string &flag)
+{
+    try
+    {
+        return std::stoi(text);
+    }
+    catch (...)
+    {
+        std::cerr << "Invalid value for " << flag << ": " << text << "\n";
+        std::exit(1);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    WorkloadParams base;
+    std::string sweepName = "all";
+    std::string emitPath;
+    int reps = 3;
+    bool optimize = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << "\n";
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--sweep")
+            sweepName = value();
+        else if (arg == "--statements")
+            base.statements = intArg(value(), arg);
+        else if (arg == "--depth")
+            base.depth = intArg(value(), arg);
+        else if (arg == "--expr-length")
+            base.exprLength = intArg(value(), arg);
+        else if (arg == "--identifiers")
+            base.identifiers = intArg(value(), arg);
+        else if (arg == "--switch-fanout")
+            base.switchFanout = intArg(value(), arg);
+        else if (arg == "--seed")
+            base.seed = static_cast<uint32_t>(intArg(value(), arg));
+        else if (arg == "--reps")
+            reps = intArg(value(), arg);
+        else if (arg == "--emit")
+            emitPath = value();
+        else if (arg == "--no-opt")
+            optimize = false;
+        else
+        {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+    if (base.statements < 1 || base.exprLength < 1 || base.identifiers < 1 || base.depth < 0 ||
+        base.switchFanout < 0 || reps < 1)
+    {
+        std::cerr << "Generator parameters must be positive\n";
+        return 1;
+    }
+
+    if (!emitPath.empty())
+    {
+        ProgramGenerator generator(base);
+        std::ofstream file(emitPath);
+        file << generator.generate();
+        std::cout << "wrote " << emitPath << " (nesting depth " << generator.deepestNesting() << ")\n";
+        return file ? 0 : 1;
+    }
+
+    int n = base.statements;
+    std::vector<Sweep> sweeps = {
+        {"statements", {n, 2 * n, 4 * n, 8 * n}, &WorkloadParams::statements},
+        {"expr", {4, 16, 64, 256}, &WorkloadParams::exprLength},
+        {"depth", {1, 4, 16, 64}, &WorkloadParams::depth},
+        {"fanout", {2, 8, 32, 128}, &WorkloadParams::switchFanout},
+        {"identifiers", {16, 256, 4096}, &WorkloadParams::identifiers}};
+
+    bool clean = true;
+    bool ran = false;
+    for (const Sweep &sweep : sweeps)
+    {
+        if (sweepName != "all" && sweepName != sweep.name)
+            continue;
+        ran = true;
+        clean = runSweep(sweep, base, reps, optimize) && clean;
+    }
+    if (!ran)
+    {
+        std::cerr << "Unknown sweep: " << sweepName << "\n";
+        return 1;
+    }
+    return clean ? 0 : 2;
+}
@@ -0,0 +1,126 @@
+// Lexer microbenchmark.
+// Measures Tokenizer throughput on a synthetic program and compares the
+// table-driven word/operator classification against the std::set lookups
+// it replaced.
+//
+// Build from the repo root:
+//   g++ -O2 -std=c++17 -I. bench/lexer_bench.cpp tokenizer.cpp stringInterner.cpp -o lexer_bench
+
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "tokenizer.h"
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Deterministic mix of declarations, loops, conditions and prints
+std::string makeSource(int statements)
+{
+    std::string src;
+    for (int i = 0; i < statements; i++)
+    {
+        std::string v = "value_" + std::to_string(i % 97);
+        switch (i % 4)
+        {
+        case 0:
+            src += "int " + v + "_" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+            break;
+        case 1:
+            src += "set " + v + " = " + v + " * 3 + (count % 5) - 1;\n";
+            break;
+        case 2:
+            src += "if (" + v + " >= 10 && flag != false) { print(\"hello\"); } else { print('x'); }\n";
+            break;
+        default:
+            src += "while (count <= 20) { set count = count + 1; } // loop\n";
+            break;
+        }
+    }
+    return src;
+}
+
+// The previous implementation, kept here only as a baseline
+const std::set<std::string> OLD_KEYWORDS = {
+    "if", "elif", "else", "switch", "case", "default",
+    "while", "for", "break", "continue", "return", "set",
+    "class", "struct", "interface", "private", "protected",
+    "public", "static", "true", "false", "const",
+    "int", "float", "double", "char", "bool", "void",
+    "string", "new", "base", "extends", "print"};
+const std::set<std::string> OLD_DATA_TYPES = {"int", "float", "double", "char", "bool", "void", "string"};
+
+TokenType oldClassifyWord(const std::string &text)
+{
+    if (OLD_KEYWORDS.count(text))
+    {
+        if (OLD_DATA_TYPES.count(text))
+            return TokenType::DATA_TYPE;
+        if (text == "true" || text == "false")
+            return TokenType::BOOL_LITERAL;
+        return TokenType::KEYWORD;
+    }
+    return TokenType::IDENTIFIER;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int statements = argc > 1 ? std::stoi(argv[1]) : 200000;
+    const int rounds = 5;
+    std::string src = makeSource(statements);
+
+    // Full tokenizer throughput
+    size_t tokens = 0;
+    double best = 1e30;
+    std::vector<std::string_view> words;
+    for (int r = 0; r < rounds; r++)
+    {
+        Clock::time_point start = Clock::now();
+        Tokenizer tokenizer(src.data(), src.size());
+        size_t count = 0;
+        Token token;
+        do
+        {
+            token = tokenizer.getNextToken();
+            count++;
+            if (r == 0 && (token.type == TokenType::IDENTIFIER || token.type == TokenType::KEYWORD ||
+                           token.type == TokenType::DATA_TYPE || token.type == TokenType::BOOL_LITERAL))
+                words.push_back(token.text);
+        } while (token.type != TokenType::END_OF_FILE);
+        best = std::min(best, secondsSince(start));
+        tokens = count;
+    }
+    std::cout << "source: " << src.size() << " bytes, " << tokens << " tokens\n";
+    std::cout << "tokenize: " << best * 1e3 << " ms, " << tokens / best / 1e6 << " M tokens/s\n";
+
+    // Word classification alone, old vs new
+    size_t checksum = 0;
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < rounds; r++)
+        for (std::string_view w : words)
+            checksum += static_cast<size_t>(oldClassifyWord(std::string(w)));
+    double oldTime = secondsSince(start);
+
+    start = Clock::now();
+    for (int r = 0; r < rounds; r++)
+        for (std::string_view w : words)
+            checksum -= static_cast<size_t>(classifyWord(w));
+    double newTime = secondsSince(start);
+
+    double lookups = static_cast<double>(words.size()) * rounds;
+    std::cout << "classify (std::set):      " << lookups / oldTime / 1e6 << " M words/s\n";
+    std::cout << "classify (perfect hash):  " << lookups / newTime / 1e6 << " M words/s\n";
+    std::cout << "speedup: " << oldTime / newTime << "x" << (checksum == 0 ? "" : " (MISMATCH)") << "\n";
+    return checksum == 0 ? 0 : 1;
+}
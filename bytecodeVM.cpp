@@ -0,0 +1,733 @@
+#include <chrono>
+#include <iostream>
+#include "bytecodeVM.h"
+#include "types.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CSTAR_COMPUTED_GOTO 1
+#endif
+
+namespace
+{
+
+// Opcode for an operator on a given operand type; HALT if there is none
+Opcode binaryOpcode(OperatorType op, ValueType t)
+{
+    static const Opcode intOps[] = {Opcode::ADD_I, Opcode::SUB_I, Opcode::MUL_I, Opcode::DIV_I, Opcode::MOD_I};
+    static const Opcode floatOps[] = {Opcode::ADD_F, Opcode::SUB_F, Opcode::MUL_F, Opcode::DIV_F, Opcode::HALT};
+    static const Opcode doubleOps[] = {Opcode::ADD_D, Opcode::SUB_D, Opcode::MUL_D, Opcode::DIV_D, Opcode::HALT};
+    static const Opcode intCmp[] = {Opcode::EQ_I, Opcode::NE_I, Opcode::LT_I, Opcode::LE_I, Opcode::GT_I, Opcode::GE_I};
+    static const Opcode floatCmp[] = {Opcode::EQ_F, Opcode::NE_F, Opcode::LT_F, Opcode::LE_F, Opcode::GT_F, Opcode::GE_F};
+    static const Opcode doubleCmp[] = {Opcode::EQ_D, Opcode::NE_D, Opcode::LT_D, Opcode::LE_D, Opcode::GT_D, Opcode::GE_D};
+
+    if (op >= Add && op <= Modulus)
+    {
+        int i = op - Add;
+        if (t == ValueType::Double) return doubleOps[i];
+        if (t == ValueType::Float) return floatOps[i];
+        return intOps[i];
+    }
+    if (op >= Equal && op <= GreaterThanEqualTo)
+    {
+        // OperatorType order is Equal, NotEqual, LessThan, LessThanEqualTo, GreaterThan, GreaterThanEqualTo
+        int i = op - Equal;
+        if (t == ValueType::String)
+        {
+            if (op == Equal) return Opcode::EQ_S;
+            if (op == NotEqual) return Opcode::NE_S;
+            return Opcode::HALT;
+        }
+        if (t == ValueType::Double) return doubleCmp[i];
+        if (t == ValueType::Float) return floatCmp[i];
+        return intCmp[i];
+    }
+    return Opcode::HALT;
+}
+
+} // namespace
+
+// ===== Lowering =====
+
+bool BytecodeCompiler::compile(const std::vector<ParserNode*> &program, BytecodeProgram &out)
+{
+    prog = &out;
+    ok = true;
+    nextReg = 0;
+    scopes.clear();
+    scopeBases.clear();
+    breakPatches.clear();
+
+    enterScope(); // global
+    for (auto stmt : program)
+    {
+        compileStatement(stmt);
+    }
+    emit(Opcode::HALT);
+    exitScope();
+    return ok;
+}
+
+void BytecodeCompiler::error(const std::string &message)
+{
+    diagnostics << "Run error: " << message << "\n";
+    ok = false;
+}
+
+size_t BytecodeCompiler::emit(Opcode op, int a, int b, int c)
+{
+    prog->code.push_back({op, a, b, c});
+    return prog->code.size() - 1;
+}
+
+// Point an already emitted jump at target
+void BytecodeCompiler::patch(size_t at, size_t target)
+{
+    Instruction &jump = prog->code[at];
+    if (jump.op == Opcode::JMP)
+        jump.a = static_cast<int32_t>(target);
+    else
+        jump.b = static_cast<int32_t>(target);
+}
+
+// Temporaries live above the variables and are released per statement
+int BytecodeCompiler::newTemp()
+{
+    int reg = nextReg++;
+    if (nextReg > prog->registerCount)
+        prog->registerCount = nextReg;
+    return reg;
+}
+
+int BytecodeCompiler::constant(Value v)
+{
+    prog->constants.push_back(v);
+    return static_cast<int>(prog->constants.size() - 1);
+}
+
+// 'text' is the literal as written, escapes included
+int BytecodeCompiler::stringConstant(std::string_view text)
+{
+    prog->strings.push_back(decodeEscapes(text));
+    Value v;
+    v.s = &prog->strings.back();
+    return constant(v);
+}
+
+void BytecodeCompiler::enterScope()
+{
+    scopes.emplace_back();
+    scopeBases.push_back(nextReg);
+}
+
+// Variables of the scope die here, so their slots are reused
+void BytecodeCompiler::exitScope()
+{
+    scopes.pop_back();
+    nextReg = scopeBases.back();
+    scopeBases.pop_back();
+}
+
+const BytecodeCompiler::Slot *BytecodeCompiler::lookup(SymbolId id) const
+{
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    {
+        auto found = it->find(id);
+        if (found != it->end())
+            return &found->second;
+    }
+    return nullptr;
+}
+
+void BytecodeCompiler::compileBlock(const NodeList &statements)
+{
+    enterScope();
+    for (auto stmt : statements)
+    {
+        compileStatement(stmt);
+    }
+    exitScope();
+}
+
+void BytecodeCompiler::compileStatement(ParserNode *node)
+{
+    if (node == nullptr)
+    {
+        error("statement failed to parse");
+        return;
+    }
+
+    int mark = nextReg;
+    switch (node->kind)
+    {
+    case NodeKind::Declaration: {
+        auto decl = static_cast<DeclarationNode*>(node);
+        Slot slot;
+        if (!irTypeOf(types::fromName(decl->type), slot.type))
+        {
+            error("unsupported variable type '" + decl->type + "'");
+            return;
+        }
+        slot.reg = newTemp();
+        if (decl->value != nullptr)
+        {
+            compileStore(slot, decl->value);
+        }
+        else
+        {
+            // Uninitialized C++ locals are indeterminate; start from zero
+            Value zero;
+            if (slot.type == ValueType::String)
+                zero.s = &prog->strings.emplace_back();
+            else
+                zero.d = 0;
+            emit(Opcode::LOADK, slot.reg, constant(zero));
+        }
+        scopes.back()[decl->id] = slot;
+        nextReg = slot.reg + 1; // Keep the variable, drop initializer temps
+        return;
+    }
+    case NodeKind::Assignment: {
+        auto assign = static_cast<AssignmentNode*>(node);
+        const Slot *slot = lookup(assign->var->id);
+        if (slot == nullptr)
+            error("use of undeclared variable '" + std::string(assign->var->name) + "'");
+        else
+            compileStore(*slot, assign->value);
+        break;
+    }
+    case NodeKind::If:
+        compileIf(static_cast<IfNode*>(node));
+        break;
+    case NodeKind::WhileLoop:
+        compileWhile(static_cast<WhileLoopNode*>(node));
+        break;
+    case NodeKind::Switch:
+        compileSwitch(static_cast<SwitchNode*>(node));
+        break;
+    case NodeKind::Print:
+        compilePrint(static_cast<PrintNode*>(node));
+        break;
+    case NodeKind::Break:
+        if (breakPatches.empty())
+            error("'break' outside of a loop or switch");
+        else
+            breakPatches.back().push_back(emit(Opcode::JMP));
+        break;
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::FunctionCall:
+        error("functions are not supported");
+        break;
+    // bare expressions have no effect
+    case NodeKind::Variable:
+    case NodeKind::Boolean:
+    case NodeKind::Operator:
+    case NodeKind::BinOp:
+    case NodeKind::Unary:
+    case NodeKind::String:
+    case NodeKind::Char:
+    case NodeKind::Number:
+    case NodeKind::Case:
+        break;
+    }
+    nextReg = mark;
+}
+
+void BytecodeCompiler::compileStore(const Slot &slot, ParserNode *value)
+{
+    convert(slot.reg, compileExpression(value), slot.type);
+}
+
+// Leaves a truth value (non-zero = true) in reg
+void BytecodeCompiler::compileCondition(ParserNode *condition, int reg)
+{
+    convert(reg, compileExpression(condition), ValueType::Bool);
+}
+
+void BytecodeCompiler::compileIf(IfNode *ifNode)
+{
+    int cond = newTemp();
+    compileCondition(ifNode->condition, cond);
+    size_t skipThen = emit(Opcode::JMPF, cond);
+    compileBlock(ifNode->thenBranch);
+
+    if (ifNode->elseBranch.empty())
+    {
+        patch(skipThen, prog->code.size());
+        return;
+    }
+    size_t skipElse = emit(Opcode::JMP);
+    patch(skipThen, prog->code.size());
+    compileBlock(ifNode->elseBranch);
+    patch(skipElse, prog->code.size());
+}
+
+void BytecodeCompiler::compileWhile(WhileLoopNode *whileNode)
+{
+    size_t loopStart = prog->code.size();
+    int cond = newTemp();
+    compileCondition(whileNode->condition, cond);
+    size_t exit = emit(Opcode::JMPF, cond);
+
+    breakPatches.emplace_back();
+    compileBlock(whileNode->statements);
+    emit(Opcode::JMP, static_cast<int>(loopStart));
+
+    size_t end = prog->code.size();
+    patch(exit, end);
+    for (size_t jump : breakPatches.back())
+        patch(jump, end);
+    breakPatches.pop_back();
+}
+
+// Compare chain first, then the case bodies. Generated C++ never falls
+// through (a break is added to every case without one), so neither do we.
+void BytecodeCompiler::compileSwitch(SwitchNode *switchNode)
+{
+    int mark = nextReg;
+    Operand cond = compileExpression(switchNode->condition);
+    if (!isIntLike(cond.type))
+        error("switch condition must be int, char or bool");
+
+    std::vector<size_t> caseJumps(switchNode->cases.size());
+    bool hasDefault = false;
+    for (size_t i = 0; i < switchNode->cases.size(); i++)
+    {
+        CaseNode *caseNode = switchNode->cases[i];
+        if (caseNode->value == nullptr)
+        {
+            hasDefault = true;
+            continue;
+        }
+        Operand value = compileExpression(caseNode->value);
+        if (!isIntLike(value.type))
+            error("case value must be int, char or bool");
+        int match = newTemp();
+        emit(Opcode::EQ_I, match, cond.reg, value.reg);
+        caseJumps[i] = emit(Opcode::JMPT, match);
+    }
+    size_t toDefault = emit(Opcode::JMP);
+    nextReg = mark;
+
+    breakPatches.emplace_back();
+    for (size_t i = 0; i < switchNode->cases.size(); i++)
+    {
+        CaseNode *caseNode = switchNode->cases[i];
+        patch(caseNode->value ? caseJumps[i] : toDefault, prog->code.size());
+
+        bool hasBreak = false;
+        for (auto stmt : caseNode->body)
+        {
+            if (stmt != nullptr && stmt->kind == NodeKind::Break)
+                hasBreak = true;
+        }
+        compileBlock(caseNode->body);
+        if (!hasBreak)
+            breakPatches.back().push_back(emit(Opcode::JMP));
+    }
+
+    size_t end = prog->code.size();
+    if (!hasDefault)
+        patch(toDefault, end);
+    for (size_t jump : breakPatches.back())
+        patch(jump, end);
+    breakPatches.pop_back();
+}
+
+void BytecodeCompiler::compilePrint(PrintNode *print)
+{
+    static const Opcode printOps[] = {Opcode::PRINT_I, Opcode::PRINT_F, Opcode::PRINT_D,
+                                      Opcode::PRINT_B, Opcode::PRINT_C, Opcode::PRINT_S};
+    Operand value = compileExpression(print->value);
+    emit(printOps[static_cast<int>(value.type)], value.reg);
+}
+
+// Operands are compiled before the operation using them, from the
+// walker's stack, so nesting costs no C++ stack
+BytecodeCompiler::Operand BytecodeCompiler::compileExpression(ParserNode *node)
+{
+    walker.walk(&node,
+        [this](ParserNode **site)
+        {
+            if (node_cast<BinOpNode>(*site) == nullptr && node_cast<UnaryNode>(*site) == nullptr)
+                return false;
+            pending.push_back({nextReg, 0, 0});
+            return true;
+        },
+        [this](ParserNode **site)
+        {
+            auto bin = static_cast<BinOpNode*>(*site);
+            if (bin->op->type == And || bin->op->type == Or)
+                startLogic(bin);
+        },
+        [this](ParserNode **site) { operands.push_back(compileNode(*site)); });
+    Operand result = operands.back();
+    operands.pop_back();
+    return result;
+}
+
+// Compiles one node whose operands are already compiled, on top of 'operands'
+BytecodeCompiler::Operand BytecodeCompiler::compileNode(ParserNode *node)
+{
+    if (node == nullptr)
+    {
+        error("expression failed to parse");
+        return {newTemp(), ValueType::Int};
+    }
+
+    Value v;
+    ValueType type = ValueType::Int;
+    switch (node->kind)
+    {
+    case NodeKind::Variable: {
+        auto var = static_cast<VariableNode*>(node);
+        const Slot *slot = lookup(var->id);
+        if (slot == nullptr)
+        {
+            error("use of undeclared variable '" + std::string(var->name) + "'");
+            return {newTemp(), ValueType::Int};
+        }
+        return {slot->reg, slot->type};
+    }
+    case NodeKind::BinOp: {
+        auto bin = static_cast<BinOpNode*>(node);
+        Pending op = pending.back();
+        pending.pop_back();
+        Operand right = operands.back();
+        operands.pop_back();
+        if (bin->op->type == And || bin->op->type == Or)
+            return finishLogic(op, right);
+        Operand left = operands.back();
+        operands.pop_back();
+        return compileBinOp(bin, left, right, op.base);
+    }
+    case NodeKind::Unary: {
+        int base = pending.back().base;
+        pending.pop_back();
+        Operand operand = operands.back();
+        operands.pop_back();
+        return compileUnary(static_cast<UnaryNode*>(node), operand, base);
+    }
+    case NodeKind::Number: {
+        auto num = static_cast<NumberNode*>(node);
+        switch (num->type)
+        {
+        case NumberType::Int:
+            v.i = static_cast<int32_t>(num->value);
+            type = ValueType::Int;
+            break;
+        case NumberType::Float:
+            v.f = static_cast<float>(num->value);
+            type = ValueType::Float;
+            break;
+        case NumberType::Double:
+            v.d = num->value;
+            type = ValueType::Double;
+            break;
+        }
+        break;
+    }
+    case NodeKind::String: {
+        int reg = newTemp();
+        emit(Opcode::LOADK, reg, stringConstant(static_cast<StringNode*>(node)->value));
+        return {reg, ValueType::String};
+    }
+    case NodeKind::Char:
+        v.i = static_cast<CharNode*>(node)->value;
+        type = ValueType::Char;
+        break;
+    case NodeKind::Boolean:
+        v.i = static_cast<BooleanNode*>(node)->value ? 1 : 0;
+        type = ValueType::Bool;
+        break;
+    case NodeKind::FunctionCall:
+        error("functions are not supported");
+        return {newTemp(), ValueType::Int};
+    // statements are not expressions
+    case NodeKind::WhileLoop:
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::Declaration:
+    case NodeKind::Assignment:
+    case NodeKind::If:
+    case NodeKind::Print:
+    case NodeKind::Operator:
+    case NodeKind::Case:
+    case NodeKind::Switch:
+    case NodeKind::Break:
+        error("invalid expression");
+        return {newTemp(), ValueType::Int};
+    }
+
+    int reg = newTemp();
+    emit(Opcode::LOADK, reg, constant(v));
+    return {reg, type};
+}
+
+// Both operands are compiled; their temps start at 'base'
+BytecodeCompiler::Operand BytecodeCompiler::compileBinOp(BinOpNode *bin, Operand left, Operand right, int base)
+{
+    OperatorType op = bin->op->type;
+    ValueType common;
+    if (left.type == ValueType::String || right.type == ValueType::String)
+        common = (left.type == right.type) ? ValueType::String : ValueType::Int;
+    else
+        common = arithmeticType(left.type, right.type);
+
+    Opcode code = binaryOpcode(op, common);
+    if (code == Opcode::HALT || (left.type == ValueType::String) != (right.type == ValueType::String))
+    {
+        error(std::string("operator '") + bin->op->getOperatorString() + "' is not supported on these operands");
+        return {newTemp(), ValueType::Int};
+    }
+
+    left = coerce(left, common);
+    right = coerce(right, common);
+
+    // Operand temps are dead once read, so the result reuses the first one
+    nextReg = base;
+    int result = newTemp();
+    emit(code, result, left.reg, right.reg);
+    bool comparison = op >= Equal && op <= GreaterThanEqualTo;
+    return {result, comparison ? ValueType::Bool : common};
+}
+
+// The operand's temps start at 'base'
+BytecodeCompiler::Operand BytecodeCompiler::compileUnary(UnaryNode *unary, Operand operand, int base)
+{
+    if (operand.type == ValueType::String)
+    {
+        error(std::string("operator '") + unary->op->getOperatorString() + "' is not supported on strings");
+        return {newTemp(), ValueType::Int};
+    }
+
+    nextReg = base;
+    int result = newTemp();
+    if (unary->op->type == Not)
+    {
+        convert(result, operand, ValueType::Bool);
+        emit(Opcode::NOT, result, result);
+        return {result, ValueType::Bool};
+    }
+    // bool and char promote to int, as in C++
+    ValueType type = isIntLike(operand.type) ? ValueType::Int : operand.type;
+    emit(type == ValueType::Int ? Opcode::NEG_I : type == ValueType::Float ? Opcode::NEG_F : Opcode::NEG_D,
+         result, operand.reg);
+    return {result, type};
+}
+
+// && and || short-circuit like the generated C++. Runs between the two
+// operands: converts the left one and jumps past the right one.
+void BytecodeCompiler::startLogic(BinOpNode *bin)
+{
+    Operand left = operands.back();
+    operands.pop_back();
+    Pending &op = pending.back();
+    // The left operand's temps are dead once it is converted
+    nextReg = op.base;
+    op.result = newTemp();
+    convert(op.result, left, ValueType::Bool);
+    op.skip = emit(bin->op->type == And ? Opcode::JMPF : Opcode::JMPT, op.result);
+}
+
+BytecodeCompiler::Operand BytecodeCompiler::finishLogic(const Pending &op, Operand right)
+{
+    convert(op.result, right, ValueType::Bool);
+    patch(op.skip, prog->code.size());
+    nextReg = op.result + 1;
+    return {op.result, ValueType::Bool};
+}
+
+// Write src into dst as type `to`, with C++ implicit conversion rules
+void BytecodeCompiler::convert(int dst, Operand src, ValueType to)
+{
+    ValueType from = src.type;
+    if (from == to || (isIntLike(from) && to == ValueType::Int))
+    {
+        if (dst != src.reg)
+            emit(Opcode::MOV, dst, src.reg);
+        return;
+    }
+    if (from == ValueType::String || to == ValueType::String)
+    {
+        error("cannot convert between string and non-string values");
+        return;
+    }
+
+    switch (to)
+    {
+    case ValueType::Bool:
+        emit(isIntLike(from) ? Opcode::TOBOOL_I : from == ValueType::Float ? Opcode::TOBOOL_F : Opcode::TOBOOL_D,
+             dst, src.reg);
+        break;
+    case ValueType::Char:
+        if (from == ValueType::Float)
+            emit(Opcode::F2I, dst, src.reg), src.reg = dst;
+        else if (from == ValueType::Double)
+            emit(Opcode::D2I, dst, src.reg), src.reg = dst;
+        emit(Opcode::I2C, dst, src.reg);
+        break;
+    case ValueType::Int:
+        emit(from == ValueType::Float ? Opcode::F2I : Opcode::D2I, dst, src.reg);
+        break;
+    case ValueType::Float:
+        emit(isIntLike(from) ? Opcode::I2F : Opcode::D2F, dst, src.reg);
+        break;
+    case ValueType::Double:
+        emit(isIntLike(from) ? Opcode::I2D : Opcode::F2D, dst, src.reg);
+        break;
+    case ValueType::String:
+        break;
+    }
+}
+
+BytecodeCompiler::Operand BytecodeCompiler::coerce(Operand src, ValueType to)
+{
+    if (src.type == to || (isIntLike(src.type) && to == ValueType::Int))
+        return src;
+    Operand result = {newTemp(), to};
+    convert(result.reg, src, to);
+    return result;
+}
+
+// ===== Interpreter =====
+
+int VirtualMachine::run(const BytecodeProgram &program)
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    firstOutput = -1;
+
+    std::vector<Value> registers(program.registerCount > 0 ? program.registerCount : 1);
+    Value *R = registers.data();
+    const Value *K = program.constants.data();
+    const Instruction *code = program.code.data();
+    const Instruction *ip = code;
+
+    auto markOutput = [&]() {
+        if (firstOutput < 0)
+            firstOutput = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+#ifdef CSTAR_COMPUTED_GOTO
+    static void *const dispatch[] = {
+#define CSTAR_OPCODE_LABEL(name) &&op_##name,
+        CSTAR_OPCODES(CSTAR_OPCODE_LABEL)
+#undef CSTAR_OPCODE_LABEL
+    };
+#define VM_START() goto *dispatch[static_cast<int>(ip->op)];
+#define VM_CASE(name) op_##name:
+#define VM_NEXT() goto *dispatch[static_cast<int>((++ip)->op)]
+#define VM_JUMP(target) do { ip = code + (target); goto *dispatch[static_cast<int>(ip->op)]; } while (0)
+#else
+// 'continue' inside do/while (0) would only leave the do, so jump back to the switch
+#define VM_START() for (;;) vm_dispatch: switch (ip->op)
+#define VM_CASE(name) case Opcode::name:
+#define VM_NEXT() do { ++ip; goto vm_dispatch; } while (0)
+#define VM_JUMP(target) do { ip = code + (target); goto vm_dispatch; } while (0)
+#endif
+
+#define A ip->a
+#define B ip->b
+#define C ip->c
+// int arithmetic wraps like the generated code does in practice
+#define WRAP(expr) static_cast<int32_t>(static_cast<uint32_t>(expr))
+
+    VM_START()
+    {
+        VM_CASE(LOADK) R[A] = K[B]; VM_NEXT();
+        VM_CASE(MOV) R[A] = R[B]; VM_NEXT();
+
+        VM_CASE(I2F) R[A].f = static_cast<float>(R[B].i); VM_NEXT();
+        VM_CASE(I2D) R[A].d = static_cast<double>(R[B].i); VM_NEXT();
+        VM_CASE(F2I) R[A].i = static_cast<int32_t>(R[B].f); VM_NEXT();
+        VM_CASE(F2D) R[A].d = static_cast<double>(R[B].f); VM_NEXT();
+        VM_CASE(D2I) R[A].i = static_cast<int32_t>(R[B].d); VM_NEXT();
+        VM_CASE(D2F) R[A].f = static_cast<float>(R[B].d); VM_NEXT();
+        VM_CASE(I2C) R[A].i = static_cast<char>(R[B].i); VM_NEXT();
+        VM_CASE(TOBOOL_I) R[A].i = R[B].i != 0; VM_NEXT();
+        VM_CASE(TOBOOL_F) R[A].i = R[B].f != 0; VM_NEXT();
+        VM_CASE(TOBOOL_D) R[A].i = R[B].d != 0; VM_NEXT();
+
+        VM_CASE(ADD_I) R[A].i = WRAP(static_cast<uint32_t>(R[B].i) + static_cast<uint32_t>(R[C].i)); VM_NEXT();
+        VM_CASE(SUB_I) R[A].i = WRAP(static_cast<uint32_t>(R[B].i) - static_cast<uint32_t>(R[C].i)); VM_NEXT();
+        VM_CASE(MUL_I) R[A].i = WRAP(static_cast<uint32_t>(R[B].i) * static_cast<uint32_t>(R[C].i)); VM_NEXT();
+        VM_CASE(DIV_I)
+            if (R[C].i == 0 || (R[C].i == -1 && R[B].i == INT32_MIN))
+                goto divide_error;
+            R[A].i = R[B].i / R[C].i;
+            VM_NEXT();
+        VM_CASE(MOD_I)
+            if (R[C].i == 0 || (R[C].i == -1 && R[B].i == INT32_MIN))
+                goto divide_error;
+            R[A].i = R[B].i % R[C].i;
+            VM_NEXT();
+
+        VM_CASE(ADD_F) R[A].f = R[B].f + R[C].f; VM_NEXT();
+        VM_CASE(SUB_F) R[A].f = R[B].f - R[C].f; VM_NEXT();
+        VM_CASE(MUL_F) R[A].f = R[B].f * R[C].f; VM_NEXT();
+        VM_CASE(DIV_F) R[A].f = R[B].f / R[C].f; VM_NEXT();
+        VM_CASE(ADD_D) R[A].d = R[B].d + R[C].d; VM_NEXT();
+        VM_CASE(SUB_D) R[A].d = R[B].d - R[C].d; VM_NEXT();
+        VM_CASE(MUL_D) R[A].d = R[B].d * R[C].d; VM_NEXT();
+        VM_CASE(DIV_D) R[A].d = R[B].d / R[C].d; VM_NEXT();
+        VM_CASE(NEG_I) R[A].i = WRAP(0u - static_cast<uint32_t>(R[B].i)); VM_NEXT();
+        VM_CASE(NEG_F) R[A].f = -R[B].f; VM_NEXT();
+        VM_CASE(NEG_D) R[A].d = -R[B].d; VM_NEXT();
+        VM_CASE(NOT) R[A].i = !R[B].i; VM_NEXT();
+
+        VM_CASE(EQ_I) R[A].i = R[B].i == R[C].i; VM_NEXT();
+        VM_CASE(NE_I) R[A].i = R[B].i != R[C].i; VM_NEXT();
+        VM_CASE(LT_I) R[A].i = R[B].i < R[C].i; VM_NEXT();
+        VM_CASE(LE_I) R[A].i = R[B].i <= R[C].i; VM_NEXT();
+        VM_CASE(GT_I) R[A].i = R[B].i > R[C].i; VM_NEXT();
+        VM_CASE(GE_I) R[A].i = R[B].i >= R[C].i; VM_NEXT();
+        VM_CASE(EQ_F) R[A].i = R[B].f == R[C].f; VM_NEXT();
+        VM_CASE(NE_F) R[A].i = R[B].f != R[C].f; VM_NEXT();
+        VM_CASE(LT_F) R[A].i = R[B].f < R[C].f; VM_NEXT();
+        VM_CASE(LE_F) R[A].i = R[B].f <= R[C].f; VM_NEXT();
+        VM_CASE(GT_F) R[A].i = R[B].f > R[C].f; VM_NEXT();
+        VM_CASE(GE_F) R[A].i = R[B].f >= R[C].f; VM_NEXT();
+        VM_CASE(EQ_D) R[A].i = R[B].d == R[C].d; VM_NEXT();
+        VM_CASE(NE_D) R[A].i = R[B].d != R[C].d; VM_NEXT();
+        VM_CASE(LT_D) R[A].i = R[B].d < R[C].d; VM_NEXT();
+        VM_CASE(LE_D) R[A].i = R[B].d <= R[C].d; VM_NEXT();
+        VM_CASE(GT_D) R[A].i = R[B].d > R[C].d; VM_NEXT();
+        VM_CASE(GE_D) R[A].i = R[B].d >= R[C].d; VM_NEXT();
+        VM_CASE(EQ_S) R[A].i = *R[B].s == *R[C].s; VM_NEXT();
+        VM_CASE(NE_S) R[A].i = *R[B].s != *R[C].s; VM_NEXT();
+
+        VM_CASE(JMP) VM_JUMP(A);
+        VM_CASE(JMPF)
+            if (!R[A].i)
+                VM_JUMP(B);
+            VM_NEXT();
+        VM_CASE(JMPT)
+            if (R[A].i)
+                VM_JUMP(B);
+            VM_NEXT();
+
+        VM_CASE(PRINT_I) markOutput(); out << R[A].i << '\n'; VM_NEXT();
+        VM_CASE(PRINT_F) markOutput(); out << R[A].f << '\n'; VM_NEXT();
+        VM_CASE(PRINT_D) markOutput(); out << R[A].d << '\n'; VM_NEXT();
+        VM_CASE(PRINT_B) markOutput(); out << (R[A].i != 0) << '\n'; VM_NEXT();
+        VM_CASE(PRINT_C) markOutput(); out << static_cast<char>(R[A].i) << '\n'; VM_NEXT();
+        VM_CASE(PRINT_S) markOutput(); out << *R[A].s << '\n'; VM_NEXT();
+
+        VM_CASE(HALT)
+            out.flush();
+            return 0;
+    }
+
+divide_error:
+    out.flush();
+    diagnostics << "Runtime error: integer division by zero or overflow\n";
+    return 1;
+
+#undef WRAP
+#undef A
+#undef B
+#undef C
+#undef VM_START
+#undef VM_CASE
+#undef VM_NEXT
+#undef VM_JUMP
+}
@@ -0,0 +1,165 @@
+#ifndef BYTECODEVM_H
+#define BYTECODEVM_H
+
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ir.h"
+#include "parser.h"
+
+// In-process execution of C* programs (--run): the checked AST is lowered
+// to register-based bytecode and interpreted, so no g++ round trip is
+// needed. Semantics follow the C++ that codegenerator.cpp would emit.
+
+// Every opcode, in dispatch-table order. Suffixes: I = int (also bool and
+// char), F = float, D = double, S = string.
+#define CSTAR_OPCODES(X) \
+	X(LOADK) X(MOV)                                           \
+	X(I2F) X(I2D) X(F2I) X(F2D) X(D2I) X(D2F) X(I2C)         \
+	X(TOBOOL_I) X(TOBOOL_F) X(TOBOOL_D)                       \
+	X(ADD_I) X(SUB_I) X(MUL_I) X(DIV_I) X(MOD_I)             \
+	X(ADD_F) X(SUB_F) X(MUL_F) X(DIV_F)                       \
+	X(ADD_D) X(SUB_D) X(MUL_D) X(DIV_D)                       \
+	X(NEG_I) X(NEG_F) X(NEG_D) X(NOT)                         \
+	X(EQ_I) X(NE_I) X(LT_I) X(LE_I) X(GT_I) X(GE_I)           \
+	X(EQ_F) X(NE_F) X(LT_F) X(LE_F) X(GT_F) X(GE_F)           \
+	X(EQ_D) X(NE_D) X(LT_D) X(LE_D) X(GT_D) X(GE_D)           \
+	X(EQ_S) X(NE_S)                                           \
+	X(JMP) X(JMPF) X(JMPT)                                    \
+	X(PRINT_I) X(PRINT_F) X(PRINT_D) X(PRINT_B) X(PRINT_C) X(PRINT_S) \
+	X(HALT)
+
+enum class Opcode : uint8_t
+{
+#define CSTAR_OPCODE_ENUM(name) name,
+	CSTAR_OPCODES(CSTAR_OPCODE_ENUM)
+#undef CSTAR_OPCODE_ENUM
+};
+
+// Static type of a register, following C++ rules for the generated code.
+// The same set as the IR's, so both share the conversion helpers in ir.h.
+using ValueType = IrType;
+
+// One register; which member is live is fixed at compile time
+union Value
+{
+	int32_t i; // int, bool and char
+	float f;
+	double d;
+	const std::string *s;
+};
+
+// a = destination (or operand for prints/jumps), b and c = sources
+struct Instruction
+{
+	Opcode op;
+	int32_t a;
+	int32_t b;
+	int32_t c;
+};
+
+struct BytecodeProgram
+{
+	std::vector<Instruction> code;
+	std::vector<Value> constants;
+	std::deque<std::string> strings; // Backing store for string constants
+	int registerCount = 0;
+};
+
+// Lowers a checked AST to bytecode. Variables are resolved to fixed
+// register slots here, so the VM never looks a name up.
+class BytecodeCompiler
+{
+public:
+	explicit BytecodeCompiler(std::ostream &diagnostics = std::cerr) : diagnostics(diagnostics) {}
+
+	// Returns false (after reporting) if the program uses something the
+	// VM does not support
+	bool compile(const std::vector<ParserNode*> &program, BytecodeProgram &out);
+
+private:
+	struct Slot
+	{
+		int reg;
+		ValueType type;
+	};
+
+	struct Operand
+	{
+		int reg;
+		ValueType type;
+	};
+
+	// Operation whose operands are being compiled
+	struct Pending
+	{
+		int base;    // First temp of its operands
+		int result;  // && and ||: register holding the result
+		size_t skip; // && and ||: jump past the right operand
+	};
+
+	std::ostream &diagnostics;
+	BytecodeProgram *prog = nullptr;
+	std::vector<std::unordered_map<SymbolId, Slot>> scopes;
+	std::vector<int> scopeBases;
+	std::vector<std::vector<size_t>> breakPatches; // One list per enclosing loop/switch
+	int nextReg = 0;
+	ExpressionWalker walker;
+	std::vector<Operand> operands; // Compiled operands not yet used
+	std::vector<Pending> pending;  // Operations whose operands are being compiled
+	bool ok = true;
+
+	void error(const std::string &message);
+	size_t emit(Opcode op, int a = 0, int b = 0, int c = 0);
+	void patch(size_t at, size_t target);
+	int newTemp();
+	int constant(Value v);
+	int stringConstant(std::string_view text);
+
+	void enterScope();
+	void exitScope();
+	const Slot *lookup(SymbolId id) const;
+
+	void compileBlock(const NodeList &statements);
+	void compileStatement(ParserNode *node);
+	void compileIf(IfNode *ifNode);
+	void compileWhile(WhileLoopNode *whileNode);
+	void compileSwitch(SwitchNode *switchNode);
+	void compilePrint(PrintNode *print);
+	void compileStore(const Slot &slot, ParserNode *value);
+	void compileCondition(ParserNode *condition, int reg);
+
+	Operand compileExpression(ParserNode *node);
+	Operand compileNode(ParserNode *node);
+	Operand compileBinOp(BinOpNode *bin, Operand left, Operand right, int base);
+	Operand compileUnary(UnaryNode *unary, Operand operand, int base);
+	void startLogic(BinOpNode *bin);
+	Operand finishLogic(const Pending &op, Operand right);
+	void convert(int dst, Operand src, ValueType to);
+	Operand coerce(Operand src, ValueType to);
+};
+
+// Executes a BytecodeProgram, writing the program's prints to 'out' and
+// runtime errors to 'diagnostics'
+class VirtualMachine
+{
+public:
+	explicit VirtualMachine(std::ostream &out = std::cout, std::ostream &diagnostics = std::cerr)
+		: out(out), diagnostics(diagnostics) {}
+
+	// Returns the process exit code (non-zero on runtime error)
+	int run(const BytecodeProgram &program);
+
+	// Milliseconds from run() start to the first print, -1 if none
+	double firstOutputMs() const { return firstOutput; }
+
+private:
+	std::ostream &out;
+	std::ostream &diagnostics;
+	double firstOutput = -1;
+};
+
+#endif // BYTECODEVM_H
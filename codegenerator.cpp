@@ -1,134 +1,467 @@
-#include "codegenerator.h"
-#include <sstream>
-#include <string>
-
-std::string generateExpression(ParserNode* node);
-
-std::string generateStatement(ParserNode* node, int indent = 0) {
-    std::ostringstream out;
-    std::string ind(indent, ' ');
-
-    if (auto decl = dynamic_cast<DeclarationNode*>(node)) {
-        if (decl->type == "string")
-            out << ind << "std::string " << decl->name;
-        else
-            out << ind << decl->type << " " << decl->name;
-    
-        if (decl->value != nullptr)
-            out << " = " << generateExpression(decl->value);
-        out << ";\n";
-    }
-    else if (auto assign = dynamic_cast<AssignmentNode*>(node)) {
-        out << ind << assign->var->name << " = " << generateExpression(assign->value) << ";\n";
-    }
-    else if (auto ifNode = dynamic_cast<IfNode*>(node)) {
-        // if statement
-        out << ind << "if (" << generateExpression(ifNode->condition) << ") {\n";
-        for (auto stmt : ifNode->thenBranch) {
-            out << generateStatement(stmt, indent + 4);
-        }
-        out << ind << "}\n";
-
-        // else branch
-        if (!ifNode->elseBranch.empty()) 
-        {
-            // Check if it's a chained if
-            if (ifNode->elseBranch.size() == 1 && dynamic_cast<IfNode*>(ifNode->elseBranch[0])) {
-                out << ind << "else " << generateStatement(ifNode->elseBranch[0], indent);
-            } else {
-                out << ind << "else {\n";
-                for (auto stmt : ifNode->elseBranch) {
-                    out << generateStatement(stmt, indent + 4);
-                }
-                out << ind << "}\n";
-            }
-        }
-    }
-    else if (auto print = dynamic_cast<PrintNode*>(node)) {
-        const std::string& val = print->token.text;
-        TokenType type = print->token.type;
-        out << ind << "std::cout << ";
-        if (type == TokenType::STRING_LITERAL) {
-            out << "\"" << val << "\"";
-        } else if (type == TokenType::CHAR_LITERAL) {
-            out << "'" << val << "'";
-        } else {
-            out << val;
-        }
-        out << " << std::endl;\n";
-    }
-    else if (auto switchNode = dynamic_cast<SwitchNode*>(node)) {
-        out << ind << "switch (" << generateExpression(switchNode->condition) << ") {\n";
-        for (auto caseNode : switchNode->cases) {
-            if (caseNode->value) {
-                out << ind << "  case " << generateExpression(caseNode->value) << ":\n";
-            } else {
-                out << ind << "  default:\n";
-            }
-
-            bool hasBreak = false;
-            for (auto stmt : caseNode->body) {
-                out << generateStatement(stmt, indent + 4);
-                if (dynamic_cast<BreakNode*>(stmt)) {
-                    hasBreak = true;
-                }
-            }
-
-            if (!hasBreak) {
-                out << ind << "    break;\n";
-            }
-        }
-        out << ind << "}\n";
-    }
-    else if (auto whileNode = dynamic_cast<WhileLoopNode*>(node)) {
-        out << ind << "while (" << generateExpression(whileNode->condition) << ") {\n";
-        for (auto stmt : whileNode->statements) {
-            out << generateStatement(stmt, indent + 4);
-        }
-        out << ind << "}\n";
-    }
-    else if (dynamic_cast<BreakNode*>(node)) {
-        out << ind << "break;\n";
-    }
-
-    return out.str();
-}
-std::string generateExpression(ParserNode* node) {
-    if (auto binop = dynamic_cast<BinOpNode*>(node)) {
-        return "(" + generateExpression(binop->left) + " " +
-               binop->op->getOperatorString() + " " +
-               generateExpression(binop->right) + ")";
-    }
-    else if (auto var = dynamic_cast<VariableNode*>(node)) {
-        return var->name;
-    }
-    else if (auto num = dynamic_cast<NumberNode*>(node)) {
-        if (num->type == TokenType::INTEGER_LITERAL) {
-            return std::to_string((int)num->value); // force int
-        } else {
-            return std::to_string(num->value); // leave float/double as-is
-        }
-    }
-    else if (auto str = dynamic_cast<StringNode*>(node)) {
-        return "\"" + str->value + "\"";
-    }
-    else if (auto chr = dynamic_cast<CharNode*>(node)) {
-        return "'" + std::string(1, chr->value) + "'";
-    }
-    else if (auto boolean = dynamic_cast<BooleanNode*>(node)) {
-        return boolean->value ? "true" : "false";
-    }
-
-    return "";
-}
-
-std::string generateCode(ParserNode* node) {
-    std::ostringstream out;
-    out << "#include <iostream>\n";
-    out << "#include <string>\n\n";
-    out << "int main() {\n";
-    out << generateStatement(node, 4);
-    out << "    return 0;\n";
-    out << "}\n";
-    return out.str();
-}
\ No newline at end of file
+#include "codegenerator.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+
+CodeEmitter::CodeEmitter(std::ostream &out) : out(out) {}
+
+// Deepest nesting of temporaries written into one expression
+static const uint32_t MAX_INLINE_DEPTH = 256;
+
+static const char *cppTypeName(IrType type) {
+    static const char *const names[] = {"int", "float", "double", "bool", "char", "std::string"};
+    return names[static_cast<int>(type)];
+}
+
+static const char *operatorText(IrOp op) {
+    switch (op) {
+    case IrOp::Add: return "+";
+    case IrOp::Sub: return "-";
+    case IrOp::Mul: return "*";
+    case IrOp::Div: return "/";
+    case IrOp::Mod: return "%";
+    case IrOp::Eq: return "==";
+    case IrOp::Ne: return "!=";
+    case IrOp::Lt: return "<";
+    case IrOp::Le: return "<=";
+    case IrOp::Gt: return ">";
+    case IrOp::Ge: return ">=";
+    case IrOp::And: return "&&";
+    case IrOp::Or: return "||";
+    // not binary operators
+    case IrOp::Const:
+    case IrOp::Copy:
+    case IrOp::Convert:
+    case IrOp::Neg:
+    case IrOp::Not:
+    case IrOp::Print:
+        break;
+    }
+    return "";
+}
+
+void CodeEmitter::emitProgram(const IrProgram &program) {
+    prog = &program;
+    analyze();
+
+    out << "#include <iostream>\n";
+    out << "#include <string>\n";
+    out << "#include \"cstar_runtime.h\"\n\n";
+    out << "int main() {\n";
+    declareRegisters();
+    for (uint32_t b = 0; b < program.blocks.size(); b++) {
+        emitBlock(b);
+    }
+    out << "}\n";
+}
+
+// Decides which temporaries are written into their use, which blocks need
+// a label, and what every remaining register is called
+void CodeEmitter::analyze() {
+    const IrProgram &program = *prog;
+    size_t count = program.registers.size();
+    std::vector<uint32_t> defs(count, 0), uses(count, 0);
+    std::vector<uint32_t> defBlock(count), defIndex(count);
+    std::vector<const IrInstruction*> definition(count, nullptr);
+    for (uint32_t b = 0; b < program.blocks.size(); b++) {
+        const IrBlock &block = program.blocks[b];
+        for (uint32_t i = 0; i < block.code.size(); i++) {
+            const IrInstruction &instr = block.code[i];
+            forEachOperand(instr, [&](uint32_t reg) { uses[reg]++; });
+            if (instr.dst != NO_REGISTER) {
+                defs[instr.dst]++;
+                defBlock[instr.dst] = b;
+                defIndex[instr.dst] = i;
+                definition[instr.dst] = &instr;
+            }
+        }
+        if (block.end == IrTerminator::Branch || block.end == IrTerminator::Switch) {
+            uses[block.condition]++;
+        }
+    }
+
+    // A temporary moves to its use only if nothing observable happens in
+    // between: no print, and no write to a register it might read. Nesting
+    // is capped so that g++ parsing a long chain does not recurse once per
+    // link; deeper values go through a named temporary.
+    inlined.assign(count, nullptr);
+    std::vector<uint32_t> depth(count, 0); // Inlined definitions nested in each value
+    for (uint32_t b = 0; b < program.blocks.size(); b++) {
+        const IrBlock &block = program.blocks[b];
+        long lastBarrier = -1;
+        auto tryInline = [&](uint32_t reg) {
+            if (program.registers[reg].name.empty() && defs[reg] == 1 && uses[reg] == 1 &&
+                defBlock[reg] == b && lastBarrier < static_cast<long>(defIndex[reg]) &&
+                depth[reg] < MAX_INLINE_DEPTH) {
+                inlined[reg] = definition[reg];
+            }
+        };
+        for (uint32_t i = 0; i < block.code.size(); i++) {
+            const IrInstruction &instr = block.code[i];
+            forEachOperand(instr, tryInline);
+            if (instr.dst != NO_REGISTER) {
+                forEachOperand(instr, [&](uint32_t reg) {
+                    if (inlined[reg] != nullptr) depth[instr.dst] = std::max(depth[instr.dst], depth[reg] + 1);
+                });
+            }
+            if (instr.op == IrOp::Print ||
+                !program.registers[instr.dst].name.empty() || defs[instr.dst] > 1) {
+                lastBarrier = i;
+            }
+        }
+        if (block.end == IrTerminator::Branch || block.end == IrTerminator::Switch) {
+            tryInline(block.condition);
+        }
+    }
+
+    // Blocks are emitted in order, so only jumps elsewhere need a label
+    labelled.assign(program.blocks.size(), false);
+    for (uint32_t b = 0; b < program.blocks.size(); b++) {
+        const IrBlock &block = program.blocks[b];
+        switch (block.end) {
+        case IrTerminator::Jump:
+            labelled[block.target] = labelled[block.target] || block.target != b + 1;
+            break;
+        case IrTerminator::Branch:
+            if (block.target != b + 1) labelled[block.target] = true;
+            if (block.otherwise != b + 1) labelled[block.otherwise] = true;
+            break;
+        case IrTerminator::Switch:
+            for (const IrCase &c : block.cases) labelled[c.target] = true;
+            if (block.target != b + 1) labelled[block.target] = true;
+            break;
+        case IrTerminator::Return:
+            break;
+        }
+    }
+
+    // Source names stay; a name declared twice, and every temporary, gets
+    // a suffix no source variable uses
+    std::unordered_set<std::string_view> sourceNames;
+    for (const IrRegister &reg : program.registers) {
+        if (!reg.name.empty()) sourceNames.insert(reg.name);
+    }
+    std::unordered_set<std::string> taken;
+    names.assign(count, std::string());
+    for (uint32_t r = 0; r < count; r++) {
+        if ((defs[r] == 0 && uses[r] == 0) || inlined[r] != nullptr) continue;
+        std::string_view own = program.registers[r].name;
+        std::string base = own.empty() ? "_t" + std::to_string(r) : std::string(own);
+        std::string name = base;
+        for (int suffix = 1; taken.count(name) > 0 || (name != own && sourceNames.count(name) > 0); suffix++) {
+            name = base + "_" + std::to_string(suffix);
+        }
+        taken.insert(name);
+        names[r] = std::move(name);
+    }
+}
+
+// Every variable lives for the whole of main(), so a goto never skips an
+// initialization. The IR writes each register before reading it.
+void CodeEmitter::declareRegisters() {
+    for (uint32_t r = 0; r < names.size(); r++) {
+        if (names[r].empty()) continue;
+        out << "    " << cppTypeName(prog->registers[r].type) << " " << names[r] << ";\n";
+    }
+}
+
+void CodeEmitter::emitBlock(uint32_t b) {
+    if (labelled[b]) {
+        out << "L" << b << ":\n";
+    }
+    const std::vector<IrInstruction> &code = prog->blocks[b].code;
+    size_t i = 0;
+    while (i < code.size()) {
+        const IrInstruction &instr = code[i];
+        if (instr.op == IrOp::Print) {
+            emitPrints(code, i);
+            continue;
+        }
+        if (inlined[instr.dst] != &instr) {
+            out << "    " << names[instr.dst] << " = ";
+            emitValue(instr);
+            out << ";\n";
+        }
+        i++;
+    }
+    emitTerminator(b);
+}
+
+// Exact printed text of a literal, as the body of a C++ string literal
+bool CodeEmitter::literalText(uint32_t reg, std::string &text) const {
+    const IrInstruction *def = inlined[reg];
+    if (def == nullptr || def->op != IrOp::Const) return false;
+    const IrConstant &c = prog->constants[def->a];
+    switch (c.type) {
+    case IrType::String:
+        text = c.text; // escapes are already C++ syntax
+        return true;
+    case IrType::Char: {
+        char chr = static_cast<char>(c.i);
+        text = (chr == '"' || chr == '\\') ? std::string("\\") + chr : std::string(1, chr);
+        return true;
+    }
+    case IrType::Bool:
+        text = c.i ? "1" : "0";
+        return true;
+    case IrType::Int:
+        text = std::to_string(c.i);
+        return true;
+    case IrType::Float:
+    case IrType::Double:
+        break; // floats keep their runtime formatting
+    }
+    return false;
+}
+
+// A run of prints becomes one cstar::print call. Literal values and the
+// newlines between them are joined into one string literal at compile
+// time, so only the non-literal values are formatted at runtime. The
+// temporaries between the prints are written into their arguments.
+void CodeEmitter::emitPrints(const std::vector<IrInstruction> &code, size_t &i) {
+    std::vector<uint32_t> values;
+    for (size_t j = i; j < code.size(); j++) {
+        const IrInstruction &instr = code[j];
+        if (instr.op == IrOp::Print) {
+            values.push_back(instr.a);
+            i = j + 1;
+        } else if (inlined[instr.dst] != &instr) {
+            break;
+        }
+    }
+
+    std::string piece;
+    if (values.size() == 1 && !literalText(values[0], piece)) {
+        // Buffered in cstar_runtime.h instead of a std::endl flush per line
+        out << "    cstar::println(";
+        emitOperand(values[0]);
+        out << ");\n";
+        return;
+    }
+
+    out << "    cstar::print(";
+    bool first = true;
+    std::string literal; // body of the string literal being built
+    auto flushLiteral = [&]() {
+        if (literal.empty()) return;
+        out << (first ? "" : ", ") << "\"" << literal << "\"";
+        first = false;
+        literal.clear();
+    };
+    for (uint32_t value : values) {
+        if (literalText(value, piece)) {
+            // Pieces always follow a "\n", so no escape can run into them
+            literal += piece;
+        } else {
+            flushLiteral();
+            out << (first ? "" : ", ");
+            emitOperand(value);
+            first = false;
+        }
+        literal += "\\n";
+    }
+    flushLiteral();
+    out << ");\n";
+}
+
+void CodeEmitter::emitTerminator(uint32_t b) {
+    const IrBlock &block = prog->blocks[b];
+    switch (block.end) {
+    case IrTerminator::Jump:
+        if (block.target != b + 1) {
+            out << "    goto L" << block.target << ";\n";
+        }
+        break;
+    case IrTerminator::Branch:
+        if (block.target == b + 1 && block.otherwise == b + 1) {
+            out << "    static_cast<void>(";
+            emitOperand(block.condition);
+            out << ");\n";
+        } else if (block.target == b + 1) {
+            out << "    if (!";
+            emitOperand(block.condition);
+            out << ") goto L" << block.otherwise << ";\n";
+        } else {
+            out << "    if (";
+            emitOperand(block.condition);
+            out << ") goto L" << block.target << ";\n";
+            if (block.otherwise != b + 1) {
+                out << "    goto L" << block.otherwise << ";\n";
+            }
+        }
+        break;
+    case IrTerminator::Switch: {
+        bool boolean = prog->registers[block.condition].type == IrType::Bool;
+        out << "    switch (" << (boolean ? "static_cast<int>(" : "");
+        emitOperand(block.condition);
+        out << (boolean ? ")" : "") << ") {\n";
+        for (const IrCase &c : block.cases) {
+            out << "    case ";
+            emitConstant({IrType::Int, c.value});
+            out << ": goto L" << c.target << ";\n";
+        }
+        if (block.target != b + 1) {
+            out << "    default: goto L" << block.target << ";\n";
+        }
+        out << "    }\n";
+        break;
+    }
+    case IrTerminator::Return:
+        out << "    return 0;\n";
+        break;
+    }
+}
+
+void CodeEmitter::emitOperand(uint32_t reg) {
+    size_t base = pending.size();
+    pending.push_back({reg, nullptr});
+    emitPending(base);
+}
+
+// Right-hand side of one instruction, fully parenthesized
+void CodeEmitter::emitValue(const IrInstruction &instr) {
+    size_t base = pending.size();
+    startValue(instr);
+    emitPending(base);
+}
+
+// Writes the pieces above 'base', expanding inlined operands in place from
+// the stack, so nested values cost no C++ stack
+void CodeEmitter::emitPending(size_t base) {
+    while (pending.size() > base) {
+        Piece piece = pending.back();
+        pending.pop_back();
+        if (piece.text != nullptr) {
+            out << piece.text;
+        } else if (inlined[piece.reg] != nullptr) {
+            startValue(*inlined[piece.reg]);
+        } else {
+            out << names[piece.reg];
+        }
+    }
+}
+
+// Writes the start of one instruction's value and queues the rest,
+// last piece first
+void CodeEmitter::startValue(const IrInstruction &instr) {
+    switch (instr.op) {
+    case IrOp::Const:
+        emitConstant(prog->constants[instr.a]);
+        break;
+    case IrOp::Copy:
+        pending.push_back({instr.a, nullptr});
+        break;
+    case IrOp::Convert:
+        out << "static_cast<" << cppTypeName(instr.type) << ">(";
+        pending.push_back({0, ")"});
+        pending.push_back({instr.a, nullptr});
+        break;
+    case IrOp::Neg: {
+        out << "(-";
+        const IrInstruction *def = inlined[instr.a];
+        if (def != nullptr && def->op == IrOp::Const) {
+            const IrConstant &c = prog->constants[def->a];
+            if (c.type == IrType::Float || c.type == IrType::Double ? std::signbit(c.d) : c.i < 0) {
+                out << " "; // "- -1", not "--1"
+            }
+        }
+        pending.push_back({0, ")"});
+        pending.push_back({instr.a, nullptr});
+        break;
+    }
+    case IrOp::Not:
+        out << "(!";
+        pending.push_back({0, ")"});
+        pending.push_back({instr.a, nullptr});
+        break;
+    case IrOp::Add:
+    case IrOp::Sub:
+    case IrOp::Mul:
+    case IrOp::Div:
+    case IrOp::Mod:
+    case IrOp::Eq:
+    case IrOp::Ne:
+    case IrOp::Lt:
+    case IrOp::Le:
+    case IrOp::Gt:
+    case IrOp::Ge:
+    case IrOp::And:
+    case IrOp::Or: {
+        // Two string literals would compare as pointers
+        const IrInstruction *left = inlined[instr.a];
+        bool wrap = instr.type == IrType::String && left != nullptr && left->op == IrOp::Const;
+        out << "(" << (wrap ? "std::string(" : "");
+        pending.push_back({0, ")"});
+        pending.push_back({instr.b, nullptr});
+        pending.push_back({0, " "});
+        pending.push_back({0, operatorText(instr.op)});
+        pending.push_back({0, wrap ? ") " : " "});
+        pending.push_back({instr.a, nullptr});
+        break;
+    }
+    case IrOp::Print:
+        break; // a statement, handled by emitPrints
+    }
+}
+
+// Shortest text that reads back as exactly this value, with the literal's
+// own type: 0.1 stays 0.1, 3.14f stays 3.14f and 2.0 is not printed as 2.
+// Folding can overflow to infinity or NaN, which have no literal, so those
+// are spelled as constant divisions.
+static std::string floatingLiteral(double value, bool isFloat) {
+    if (!std::isfinite(value)) {
+        const char *one = isFloat ? "1.0f" : "1.0";
+        const char *zero = isFloat ? "0.0f" : "0.0";
+        const char *numerator = std::isnan(value) ? zero : one;
+        return std::string("(") + (value < 0 ? "-" : "") + numerator + " / " + zero + ")";
+    }
+    char buffer[64];
+    char *end = isFloat
+        ? std::to_chars(buffer, buffer + sizeof(buffer), static_cast<float>(value)).ptr
+        : std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+    std::string text(buffer, end);
+    if (text.find_first_of(".e") == std::string::npos) {
+        text += ".0";
+    }
+    if (isFloat) {
+        text += 'f';
+    }
+    return text;
+}
+
+void CodeEmitter::emitConstant(const IrConstant &c) {
+    switch (c.type) {
+    case IrType::Int:
+        if (c.i == INT32_MIN) {
+            out << "(-2147483647 - 1)"; // 2147483648 alone does not fit in an int
+        } else {
+            out << c.i;
+        }
+        break;
+    case IrType::Float:
+    case IrType::Double:
+        out << floatingLiteral(c.d, c.type == IrType::Float);
+        break;
+    case IrType::Bool:
+        out << (c.i ? "true" : "false");
+        break;
+    case IrType::Char: {
+        char chr = static_cast<char>(c.i);
+        out << "'" << (chr == '\'' || chr == '\\' ? "\\" : "") << chr << "'";
+        break;
+    }
+    case IrType::String:
+        out << "\"" << c.text << "\"";
+        break;
+    }
+}
+
+std::string generateCode(const IrProgram &program) {
+    std::ostringstream out;
+    CodeEmitter emitter(out);
+    emitter.emitProgram(program);
+    return out.str();
+}
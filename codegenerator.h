@@ -2,10 +2,54 @@
 #define CODE_GENERATOR_H
 
 #include <string>
-#include "parser.h"
+#include <vector>
+#include <ostream>
+#include "ir.h"
 
-// Generate C++ code from a parsed syntax tree
+// Generate C++ code from the IR
 
-std::string generateCode(ParserNode *node);
+// Writes the generated program straight into one output stream. Every
+// variable is declared at the top of main(), each basic block becomes a
+// run of statements, and jumps that do not fall through become gotos.
+// A temporary that is used once, in the block that computes it, is
+// written into its use, so most source expressions come out whole.
+class CodeEmitter
+{
+public:
+	explicit CodeEmitter(std::ostream &out);
 
-#endif // CODE_GENERATOR_H
\ No newline at end of file
+	// Whole translation unit: prelude, declarations and main()'s body
+	void emitProgram(const IrProgram &program);
+
+private:
+	std::ostream &out;
+	const IrProgram *prog = nullptr;
+	std::vector<std::string> names;         // C++ name of every declared register
+	std::vector<const IrInstruction*> inlined; // Definition written into its only use
+	std::vector<bool> labelled;             // Blocks reached by a goto
+
+	// Part of a value still to be written: fixed text, or else a register
+	struct Piece
+	{
+		uint32_t reg;
+		const char *text;
+	};
+	std::vector<Piece> pending; // Innermost last
+
+	void analyze();
+	void declareRegisters();
+	void emitBlock(uint32_t b);
+	void emitPrints(const std::vector<IrInstruction> &code, size_t &i);
+	void emitTerminator(uint32_t b);
+	void emitOperand(uint32_t reg);
+	void emitValue(const IrInstruction &instr);
+	void emitPending(size_t base);
+	void startValue(const IrInstruction &instr);
+	void emitConstant(const IrConstant &c);
+	bool literalText(uint32_t reg, std::string &text) const;
+};
+
+// Convenience wrapper returning the whole program as a string
+std::string generateCode(const IrProgram &program);
+
+#endif // CODE_GENERATOR_H
@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "compileCache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+const char *const CPP_FILE = "output.cpp";
+const char *const EXE_FILE = "program";
+const char *const DIAGNOSTICS_FILE = "diagnostics.txt";
+const char *const AST_FILE = "ast.txt";
+const char *const PROFILE_SUFFIX = ".profile";
+
+// Larger AST dumps are not cached: replaying one costs little next to
+// the front end producing it, and it would crowd out other entries
+const uint64_t MAX_AST_BYTES = 1024 * 1024;
+
+// Minimal SHA-256 (FIPS 180-4), enough to key the cache
+class Sha256
+{
+public:
+    void update(std::string_view data)
+    {
+        for (char c : data)
+        {
+            block[blockSize++] = static_cast<uint8_t>(c);
+            if (blockSize == 64)
+            {
+                compress();
+                blockSize = 0;
+            }
+        }
+        length += data.size();
+    }
+
+    std::string hex()
+    {
+        uint64_t bits = length * 8;
+        update(std::string_view("\x80", 1));
+        while (blockSize != 56)
+            update(std::string_view("\0", 1));
+        char tail[8];
+        for (int i = 0; i < 8; i++)
+            tail[i] = static_cast<char>(bits >> (56 - 8 * i));
+        update(std::string_view(tail, 8));
+
+        static const char digits[] = "0123456789abcdef";
+        std::string result;
+        for (uint32_t word : state)
+            for (int shift = 28; shift >= 0; shift -= 4)
+                result += digits[(word >> shift) & 0xf];
+        return result;
+    }
+
+private:
+    uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    uint8_t block[64];
+    size_t blockSize = 0;
+    uint64_t length = 0;
+
+    static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void compress()
+    {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++)
+            w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) |
+                   (uint32_t(block[4 * i + 2]) << 8) | uint32_t(block[4 * i + 3]);
+        for (int i = 16; i < 64; i++)
+        {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++)
+        {
+            uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+};
+
+uint64_t directorySize(const fs::path &path)
+{
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const fs::directory_entry &entry : fs::directory_iterator(path, ec))
+    {
+        if (entry.is_regular_file(ec))
+            total += entry.file_size(ec);
+    }
+    return total;
+}
+
+// Path of the running compiler executable; empty if unknown
+std::string selfPath()
+{
+#ifdef _WIN32
+    char path[MAX_PATH];
+    DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+    return length > 0 && length < MAX_PATH ? std::string(path, length) : std::string();
+#else
+    std::error_code ec;
+    fs::path path = fs::read_symlink("/proc/self/exe", ec);
+    return ec ? std::string() : path.string();
+#endif
+}
+
+// Identifies this build of the compiler in every key: a hash of its own
+// executable, so rebuilding any part of it gives new keys. Falls back to
+// this file's build time if the executable cannot be read.
+const std::string &compilerBuild()
+{
+    static const std::string build = [] {
+        std::string path = selfPath();
+        std::ifstream in(path, std::ios::binary);
+        if (path.empty() || !in)
+            return std::string("cstar " __DATE__ " " __TIME__ " " __VERSION__);
+        Sha256 hash;
+        char chunk[65536];
+        while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0)
+            hash.update(std::string_view(chunk, static_cast<size_t>(in.gcount())));
+        return hash.hex();
+    }();
+    return build;
+}
+
+// Whole file as text; empty if it is missing
+std::string readFile(const fs::path &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+} // namespace
+
+CompileCache::CompileCache(std::string dir, uint64_t maxBytes) : dir(std::move(dir)), maxBytes(maxBytes)
+{
+
+}
+
+std::string CompileCache::key(std::string_view source, std::string_view backendFlags)
+{
+    Sha256 hash;
+    hash.update(compilerBuild());
+    hash.update(std::string_view("\0", 1));
+    hash.update(backendFlags);
+    hash.update(std::string_view("\0", 1));
+    hash.update(source);
+    return hash.hex();
+}
+
+bool CompileCache::fetch(const std::string &key, const std::string &outputCpp,
+                         const std::string &executable, std::string &diagnostics, std::string &astDump)
+{
+    fs::path entry = fs::path(dir) / key;
+    std::error_code ec;
+    if (!fs::is_directory(entry, ec))
+    {
+        misses++;
+        return false;
+    }
+
+    // A half-evicted or damaged entry is just a miss
+    fs::copy_file(entry / CPP_FILE, outputCpp, fs::copy_options::overwrite_existing, ec);
+    if (!ec)
+        fs::copy_file(entry / EXE_FILE, executable, fs::copy_options::overwrite_existing, ec);
+    if (ec)
+    {
+        misses++;
+        return false;
+    }
+
+    diagnostics = readFile(entry / DIAGNOSTICS_FILE);
+    astDump = readFile(entry / AST_FILE);
+
+    // Most recently used entries are the last to be evicted
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+    hits++;
+    return true;
+}
+
+void CompileCache::store(const std::string &key, const std::string &outputCpp,
+                         const std::string &executable, const std::string &diagnostics,
+                         const std::string &astDump)
+{
+    // An entry that could never fit would only evict everything else
+    std::error_code ec;
+    uint64_t bytes = fs::file_size(outputCpp, ec);
+    if (!ec)
+        bytes += fs::file_size(executable, ec);
+    if (ec || astDump.size() > MAX_AST_BYTES || bytes + diagnostics.size() + astDump.size() > maxBytes)
+        return;
+
+    fs::path entry = fs::path(dir) / key;
+    std::ostringstream tempName;
+    tempName << key << ".tmp" << std::hash<std::thread::id>()(std::this_thread::get_id())
+             << "_" << std::chrono::steady_clock::now().time_since_epoch().count();
+    fs::path temp = fs::path(dir) / tempName.str();
+
+    // Build the entry under a private name, then publish it with one rename
+    fs::create_directories(temp, ec);
+    if (!ec)
+        fs::copy_file(outputCpp, temp / CPP_FILE, ec);
+    if (!ec)
+        fs::copy_file(executable, temp / EXE_FILE, ec);
+    if (!ec)
+    {
+        std::ofstream out(temp / DIAGNOSTICS_FILE, std::ios::binary);
+        out << diagnostics;
+    }
+    if (!ec && !astDump.empty())
+    {
+        std::ofstream out(temp / AST_FILE, std::ios::binary);
+        out << astDump;
+    }
+    if (!ec)
+        fs::rename(temp, entry, ec);
+    if (ec)
+    {
+        // Another worker may have stored the same key first
+        fs::remove_all(temp, ec);
+        return;
+    }
+
+    stores++;
+    evict();
+}
+
+std::string CompileCache::profileDir(const std::string &key) const
+{
+    return (fs::path(dir) / (key + PROFILE_SUFFIX)).string();
+}
+
+void CompileCache::evict()
+{
+    std::lock_guard<std::mutex> lock(evictMutex);
+
+    struct Entry
+    {
+        fs::path path;
+        fs::file_time_type used;
+        uint64_t bytes;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const fs::directory_entry &entry : fs::directory_iterator(dir, ec))
+    {
+        // Skip entries still being written by another worker
+        if (!entry.is_directory(ec) || entry.path().filename().string().find(".tmp") != std::string::npos)
+            continue;
+        uint64_t bytes = directorySize(entry.path());
+        entries.push_back({entry.path(), entry.last_write_time(ec), bytes});
+        total += bytes;
+    }
+    if (total <= maxBytes)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.used < b.used; });
+    for (const Entry &entry : entries)
+    {
+        if (total <= maxBytes)
+            break;
+        if (fs::remove_all(entry.path, ec) > 0 && !ec)
+        {
+            total -= entry.bytes;
+            evictions++;
+        }
+    }
+}
+
+CompileCache::Stats CompileCache::stats() const
+{
+    Stats result;
+    result.hits = hits.load();
+    result.misses = misses.load();
+    result.stores = stores.load();
+    result.evictions = evictions.load();
+    return result;
+}
+
+void CompileCache::printStats(std::ostream &out) const
+{
+    uint64_t entries = 0, bytes = 0;
+    std::error_code ec;
+    for (const fs::directory_entry &entry : fs::directory_iterator(dir, ec))
+    {
+        std::string name = entry.path().filename().string();
+        if (entry.is_directory(ec) && name.find(".tmp") == std::string::npos)
+        {
+            if (name.find(PROFILE_SUFFIX) == std::string::npos)
+                entries++;
+            bytes += directorySize(entry.path());
+        }
+    }
+
+    Stats s = stats();
+    out << "Compile cache (" << dir << "): " << s.hits << " hits, " << s.misses << " misses, "
+        << s.stores << " stored, " << s.evictions << " evicted; "
+        << entries << " entries, " << bytes / 1024 << " KB of " << maxBytes / 1024 << " KB\n";
+}
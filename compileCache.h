@@ -0,0 +1,62 @@
+#ifndef COMPILECACHE_H
+#define COMPILECACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <iostream>
+
+// On-disk cache of generated C++ and the executables g++ built from it.
+// Entries live in <dir>/<key>/ where the key is the SHA-256 of the source
+// bytes, the compiler executable and the backend flags, so any change to
+// one of them is a miss. Once the cache grows past its size limit the least
+// recently used entries are evicted. Safe to share between batch workers.
+class CompileCache
+{
+public:
+	struct Stats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t stores = 0;
+		uint64_t evictions = 0;
+	};
+
+	CompileCache(std::string dir, uint64_t maxBytes);
+
+	// Hex SHA-256 over everything that decides the generated output
+	static std::string key(std::string_view source, std::string_view backendFlags);
+
+	// On a hit, copies the entry's C++ to outputCpp and its executable to
+	// executable, and returns the front end's diagnostics and AST dump
+	bool fetch(const std::string &key, const std::string &outputCpp,
+			   const std::string &executable, std::string &diagnostics, std::string &astDump);
+
+	// Adds an entry after a successful g++ build; failures only skip caching.
+	// Entries larger than the cache, or with an AST dump over 1 MB, are
+	// not stored.
+	void store(const std::string &key, const std::string &outputCpp,
+			   const std::string &executable, const std::string &diagnostics,
+			   const std::string &astDump);
+
+	// Where --pgo keeps the .gcda profiles for a key; evicted like an entry
+	std::string profileDir(const std::string &key) const;
+
+	Stats stats() const;
+	void printStats(std::ostream &out) const;
+
+private:
+	std::string dir;
+	uint64_t maxBytes;
+	std::atomic<uint64_t> hits{0};
+	std::atomic<uint64_t> misses{0};
+	std::atomic<uint64_t> stores{0};
+	std::atomic<uint64_t> evictions{0};
+	std::mutex evictMutex;
+
+	void evict();
+};
+
+#endif // COMPILECACHE_H
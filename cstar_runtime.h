@@ -0,0 +1,115 @@
+#ifndef CSTAR_RUNTIME_H
+#define CSTAR_RUNTIME_H
+
+// Runtime support included by every generated program.
+//
+// print() output collects in one static buffer that is written with a
+// single fwrite when it fills up and once more when the program exits,
+// instead of flushing std::cout after every line. Numbers are formatted
+// with std::to_chars straight into the buffer, so printing never touches
+// the heap. The text is byte-for-byte what std::cout would have printed.
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace cstar
+{
+
+class OutputBuffer
+{
+public:
+	OutputBuffer() = default;
+	OutputBuffer(const OutputBuffer &) = delete;
+	OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+	~OutputBuffer() { flush(); }
+
+	void flush()
+	{
+		if (used > 0)
+			std::fwrite(data, 1, used, stdout);
+		used = 0;
+		std::fflush(stdout);
+	}
+
+	void write(const char *text, size_t length)
+	{
+		if (length > sizeof(data) - used)
+		{
+			flush();
+			if (length > sizeof(data))
+			{
+				std::fwrite(text, 1, length, stdout);
+				return;
+			}
+		}
+		std::memcpy(data + used, text, length);
+		used += length;
+	}
+
+	void put(char c)
+	{
+		if (used == sizeof(data))
+			flush();
+		data[used++] = c;
+	}
+
+	// Same text as std::ostream's operator<< with default flags
+	void print(const char *text) { write(text, std::strlen(text)); }
+	void print(const std::string &text) { write(text.data(), text.size()); }
+	void print(char c) { put(c); }
+	void print(bool value) { put(value ? '1' : '0'); }
+
+	template <typename T>
+	std::enable_if_t<std::is_integral_v<T>> print(T value)
+	{
+		char digits[24];
+		write(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr - digits);
+	}
+
+	// %g with 6 significant digits, like the stream default
+	template <typename T>
+	std::enable_if_t<std::is_floating_point_v<T>> print(T value)
+	{
+		char digits[32];
+		write(digits, std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6).ptr - digits);
+	}
+
+	// String literals are copied with their compile-time length
+	template <typename T>
+	void append(const T &value)
+	{
+		if constexpr (std::is_array_v<T>)
+			write(value, std::extent_v<T> - 1);
+		else
+			print(value);
+	}
+
+private:
+	char data[1 << 16];
+	size_t used = 0;
+};
+
+// One buffer per program, flushed by its destructor when main returns
+inline OutputBuffer output;
+
+template <typename T>
+inline void println(const T &value)
+{
+	output.print(value);
+	output.put('\n');
+}
+
+// Several values in one call, for fused runs of prints
+template <typename... T>
+inline void print(const T &...parts)
+{
+	(output.append(parts), ...);
+}
+
+} // namespace cstar
+
+#endif // CSTAR_RUNTIME_H
@@ -0,0 +1,932 @@
+#include "ir.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include "types.h"
+
+namespace
+{
+
+// IR instruction for each OperatorType, in OperatorType order
+const IrOp operatorOps[] = {
+    IrOp::Add, IrOp::Sub, IrOp::Mul, IrOp::Div, IrOp::Mod,
+    IrOp::Add, IrOp::Sub, // ++ and -- never reach the IR
+    IrOp::Eq, IrOp::Ne, IrOp::Lt, IrOp::Le, IrOp::Gt, IrOp::Ge,
+    IrOp::And, IrOp::Or, IrOp::Not
+};
+static_assert(sizeof(operatorOps) / sizeof(operatorOps[0]) == OperatorType::Not + 1,
+              "one IrOp per OperatorType");
+
+// A case label: an int, char or bool literal, possibly negated
+bool caseValue(ParserNode *node, int32_t &value)
+{
+    bool negate = false;
+    while (auto unary = node_cast<UnaryNode>(node))
+    {
+        if (unary->op->type != Subtract)
+            return false;
+        negate = !negate;
+        node = unary->operand;
+    }
+    if (auto num = node_cast<NumberNode>(node))
+    {
+        if (num->type != NumberType::Int)
+            return false;
+        value = static_cast<int32_t>(num->value);
+    }
+    else if (auto chr = node_cast<CharNode>(node))
+        value = chr->value;
+    else if (auto boolean = node_cast<BooleanNode>(node))
+        value = boolean->value ? 1 : 0;
+    else
+        return false;
+    if (negate)
+        value = static_cast<int32_t>(0u - static_cast<uint32_t>(value));
+    return true;
+}
+
+// C++ conversion of a floating value to int, if it is defined
+bool truncate(double d, int32_t &out)
+{
+    if (!(d > -2147483649.0 && d < 2147483648.0))
+        return false;
+    out = static_cast<int32_t>(d);
+    return true;
+}
+
+} // namespace
+
+bool irTypeOf(const Type *type, IrType &out)
+{
+    if (type == nullptr)
+        return false;
+    switch (type->kind)
+    {
+    case TypeKind::Int:    out = IrType::Int; return true;
+    case TypeKind::Float:  out = IrType::Float; return true;
+    case TypeKind::Double: out = IrType::Double; return true;
+    case TypeKind::Bool:   out = IrType::Bool; return true;
+    case TypeKind::Char:   out = IrType::Char; return true;
+    case TypeKind::String: out = IrType::String; return true;
+    case TypeKind::Void:
+    case TypeKind::Function:
+    case TypeKind::Param:
+        break;
+    }
+    return false;
+}
+
+bool isIntLike(IrType t)
+{
+    return t == IrType::Int || t == IrType::Bool || t == IrType::Char;
+}
+
+IrType arithmeticType(IrType a, IrType b)
+{
+    if (a == IrType::Double || b == IrType::Double)
+        return IrType::Double;
+    if (a == IrType::Float || b == IrType::Float)
+        return IrType::Float;
+    return IrType::Int;
+}
+
+const char *irTypeName(IrType type)
+{
+    static const char *const names[] = {"int", "float", "double", "bool", "char", "string"};
+    return names[static_cast<int>(type)];
+}
+
+const char *irOpName(IrOp op)
+{
+    static const char *const names[] = {
+        "const", "copy", "convert",
+        "add", "sub", "mul", "div", "mod", "neg",
+        "eq", "ne", "lt", "le", "gt", "ge",
+        "and", "or", "not",
+        "print"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<int>(IrOp::Print) + 1,
+                  "one name per IrOp");
+    return names[static_cast<int>(op)];
+}
+
+// ===== IrProgram =====
+
+void IrProgram::link()
+{
+    for (IrBlock &block : blocks)
+    {
+        block.successors.clear();
+        block.predecessors.clear();
+    }
+    for (uint32_t from = 0; from < blocks.size(); from++)
+    {
+        IrBlock &block = blocks[from];
+        auto edge = [&](uint32_t to)
+        {
+            if (std::find(block.successors.begin(), block.successors.end(), to) != block.successors.end())
+                return;
+            block.successors.push_back(to);
+            blocks[to].predecessors.push_back(from);
+        };
+        switch (block.end)
+        {
+        case IrTerminator::Jump:
+            edge(block.target);
+            break;
+        case IrTerminator::Branch:
+            edge(block.target);
+            edge(block.otherwise);
+            break;
+        case IrTerminator::Switch:
+            for (const IrCase &c : block.cases)
+                edge(c.target);
+            edge(block.target);
+            break;
+        case IrTerminator::Return:
+            break;
+        }
+    }
+}
+
+size_t IrProgram::instructionCount() const
+{
+    size_t count = 0;
+    for (const IrBlock &block : blocks)
+        count += block.code.size();
+    return count;
+}
+
+static void printConstant(std::ostream &out, const IrConstant &c)
+{
+    char buffer[64];
+    switch (c.type)
+    {
+    case IrType::Int:
+        out << c.i;
+        break;
+    case IrType::Bool:
+        out << (c.i ? "true" : "false");
+        break;
+    case IrType::Char:
+        out << '\'' << static_cast<char>(c.i) << '\'';
+        break;
+    case IrType::Float:
+        out.write(buffer, std::to_chars(buffer, buffer + sizeof(buffer), static_cast<float>(c.d)).ptr - buffer);
+        out << 'f';
+        break;
+    case IrType::Double:
+        out.write(buffer, std::to_chars(buffer, buffer + sizeof(buffer), c.d).ptr - buffer);
+        break;
+    case IrType::String:
+        out << '"' << c.text << '"';
+        break;
+    }
+}
+
+void IrProgram::print(std::ostream &out) const
+{
+    for (uint32_t r = 0; r < registers.size(); r++)
+    {
+        if (!registers[r].name.empty())
+            out << "; r" << r << ": " << irTypeName(registers[r].type) << " " << registers[r].name << "\n";
+    }
+    for (uint32_t b = 0; b < blocks.size(); b++)
+    {
+        const IrBlock &block = blocks[b];
+        out << "b" << b << ":";
+        if (!block.predecessors.empty())
+        {
+            out << "  ; preds";
+            for (uint32_t p : block.predecessors)
+                out << " b" << p;
+        }
+        out << "\n";
+        for (const IrInstruction &instr : block.code)
+        {
+            out << "    ";
+            if (instr.dst != NO_REGISTER)
+                out << "r" << instr.dst << " = ";
+            out << irOpName(instr.op) << " " << irTypeName(instr.type) << " ";
+            switch (instr.op)
+            {
+            case IrOp::Const:
+                printConstant(out, constants[instr.a]);
+                break;
+            case IrOp::Copy:
+            case IrOp::Convert:
+            case IrOp::Neg:
+            case IrOp::Not:
+            case IrOp::Print:
+                out << "r" << instr.a;
+                break;
+            case IrOp::Add:
+            case IrOp::Sub:
+            case IrOp::Mul:
+            case IrOp::Div:
+            case IrOp::Mod:
+            case IrOp::Eq:
+            case IrOp::Ne:
+            case IrOp::Lt:
+            case IrOp::Le:
+            case IrOp::Gt:
+            case IrOp::Ge:
+            case IrOp::And:
+            case IrOp::Or:
+                out << "r" << instr.a << ", r" << instr.b;
+                break;
+            }
+            out << "\n";
+        }
+        switch (block.end)
+        {
+        case IrTerminator::Jump:
+            out << "    jump b" << block.target << "\n";
+            break;
+        case IrTerminator::Branch:
+            out << "    branch r" << block.condition << ", b" << block.target << ", b" << block.otherwise << "\n";
+            break;
+        case IrTerminator::Switch:
+            out << "    switch r" << block.condition << " [";
+            for (size_t i = 0; i < block.cases.size(); i++)
+                out << (i > 0 ? ", " : "") << block.cases[i].value << ": b" << block.cases[i].target;
+            out << "], default b" << block.target << "\n";
+            break;
+        case IrTerminator::Return:
+            out << "    return\n";
+            break;
+        }
+    }
+}
+
+// ===== Lowering =====
+
+bool IrBuilder::build(const std::vector<ParserNode*> &program, IrProgram &out)
+{
+    out = IrProgram();
+    prog = &out;
+    ok = true;
+    layout.clear();
+    scopes.clear();
+    breakTargets.clear();
+
+    startBlock(newBlock());
+    scopes.emplace_back(); // global
+    for (auto stmt : program)
+    {
+        buildStatement(stmt);
+    }
+    scopes.pop_back();
+    prog->blocks[current].end = IrTerminator::Return;
+
+    finish();
+    prog->link();
+    return ok;
+}
+
+void IrBuilder::error(const std::string &message)
+{
+    diagnostics << "IR error: " << message << "\n";
+    ok = false;
+}
+
+uint32_t IrBuilder::newRegister(IrType type, std::string_view name)
+{
+    prog->registers.push_back({type, name});
+    return static_cast<uint32_t>(prog->registers.size() - 1);
+}
+
+uint32_t IrBuilder::newBlock()
+{
+    prog->blocks.emplace_back();
+    return static_cast<uint32_t>(prog->blocks.size() - 1);
+}
+
+// Blocks are laid out in the order they are started, so the final order
+// follows the source: a loop's body comes before the code after it
+void IrBuilder::startBlock(uint32_t block)
+{
+    current = block;
+    layout.push_back(block);
+}
+
+void IrBuilder::emit(IrOp op, IrType type, uint32_t dst, uint32_t a, uint32_t b)
+{
+    prog->blocks[current].code.push_back({op, type, dst, a, b});
+}
+
+IrBuilder::Operand IrBuilder::constant(IrConstant value)
+{
+    IrType type = value.type;
+    uint32_t reg = newRegister(type);
+    prog->constants.push_back(std::move(value));
+    emit(IrOp::Const, type, reg, static_cast<uint32_t>(prog->constants.size() - 1));
+    return {reg, type};
+}
+
+void IrBuilder::jump(uint32_t from, uint32_t to)
+{
+    IrBlock &block = prog->blocks[from];
+    block.end = IrTerminator::Jump;
+    block.target = to;
+}
+
+void IrBuilder::branch(uint32_t from, uint32_t condition, uint32_t whenTrue, uint32_t whenFalse)
+{
+    IrBlock &block = prog->blocks[from];
+    block.end = IrTerminator::Branch;
+    block.condition = condition;
+    block.target = whenTrue;
+    block.otherwise = whenFalse;
+}
+
+uint32_t IrBuilder::lookup(SymbolId id) const
+{
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    {
+        auto found = it->find(id);
+        if (found != it->end())
+            return found->second;
+    }
+    return NO_REGISTER;
+}
+
+// The instruction that just defined a temporary, or nullptr. Only such a
+// definition may be rewritten, since nothing else has read it yet.
+IrInstruction *IrBuilder::definition(uint32_t reg)
+{
+    std::vector<IrInstruction> &code = prog->blocks[current].code;
+    if (code.empty() || code.back().dst != reg || !prog->registers[reg].name.empty())
+        return nullptr;
+    return &code.back();
+}
+
+void IrBuilder::buildBlock(const NodeList &statements)
+{
+    scopes.emplace_back();
+    for (auto stmt : statements)
+    {
+        buildStatement(stmt);
+    }
+    scopes.pop_back();
+}
+
+void IrBuilder::buildStatement(ParserNode *node)
+{
+    if (node == nullptr)
+    {
+        error("statement failed to parse");
+        return;
+    }
+
+    switch (node->kind)
+    {
+    case NodeKind::Declaration: {
+        auto decl = static_cast<DeclarationNode*>(node);
+        IrType type;
+        if (!irTypeOf(types::fromName(decl->type), type))
+        {
+            error("unsupported variable type '" + decl->type + "'");
+            return;
+        }
+        uint32_t reg = newRegister(type, decl->name);
+        if (decl->value != nullptr)
+        {
+            assign(reg, buildExpression(decl->value));
+        }
+        else
+        {
+            // Uninitialized C++ locals are indeterminate; start from zero
+            prog->constants.push_back({type});
+            emit(IrOp::Const, type, reg, static_cast<uint32_t>(prog->constants.size() - 1));
+        }
+        scopes.back()[decl->id] = reg;
+        break;
+    }
+    case NodeKind::Assignment: {
+        auto assignment = static_cast<AssignmentNode*>(node);
+        uint32_t reg = lookup(assignment->var->id);
+        if (reg == NO_REGISTER)
+            error("use of undeclared variable '" + std::string(assignment->var->name) + "'");
+        else
+            assign(reg, buildExpression(assignment->value));
+        break;
+    }
+    case NodeKind::If:
+        buildIf(static_cast<IfNode*>(node));
+        break;
+    case NodeKind::WhileLoop:
+        buildWhile(static_cast<WhileLoopNode*>(node));
+        break;
+    case NodeKind::Switch:
+        buildSwitch(static_cast<SwitchNode*>(node));
+        break;
+    case NodeKind::Print: {
+        Operand value = buildExpression(static_cast<PrintNode*>(node)->value);
+        emit(IrOp::Print, value.type, NO_REGISTER, value.reg);
+        break;
+    }
+    case NodeKind::Break:
+        if (breakTargets.empty())
+        {
+            error("'break' outside of a loop or switch");
+            break;
+        }
+        jump(current, breakTargets.back());
+        startBlock(newBlock()); // Whatever follows is unreachable
+        break;
+    // The C++ backend has never generated functions
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::FunctionCall:
+    // bare expressions have no effect
+    case NodeKind::Variable:
+    case NodeKind::Boolean:
+    case NodeKind::Operator:
+    case NodeKind::BinOp:
+    case NodeKind::Unary:
+    case NodeKind::String:
+    case NodeKind::Char:
+    case NodeKind::Number:
+    case NodeKind::Case:
+        break;
+    }
+}
+
+void IrBuilder::buildIf(IfNode *ifNode)
+{
+    Operand condition = coerce(buildExpression(ifNode->condition), IrType::Bool);
+    uint32_t test = current;
+
+    uint32_t thenBlock = newBlock();
+    startBlock(thenBlock);
+    buildBlock(ifNode->thenBranch);
+    uint32_t thenEnd = current;
+
+    uint32_t elseBlock = NO_REGISTER, elseEnd = NO_REGISTER;
+    if (!ifNode->elseBranch.empty())
+    {
+        elseBlock = newBlock();
+        startBlock(elseBlock);
+        buildBlock(ifNode->elseBranch);
+        elseEnd = current;
+    }
+
+    uint32_t join = newBlock();
+    branch(test, condition.reg, thenBlock, elseBlock == NO_REGISTER ? join : elseBlock);
+    jump(thenEnd, join);
+    if (elseEnd != NO_REGISTER)
+        jump(elseEnd, join);
+    startBlock(join);
+}
+
+void IrBuilder::buildWhile(WhileLoopNode *whileNode)
+{
+    uint32_t header = newBlock();
+    uint32_t exit = newBlock();
+    jump(current, header);
+
+    startBlock(header);
+    Operand condition = coerce(buildExpression(whileNode->condition), IrType::Bool);
+    uint32_t body = newBlock();
+    branch(current, condition.reg, body, exit);
+
+    breakTargets.push_back(exit);
+    startBlock(body);
+    buildBlock(whileNode->statements);
+    jump(current, header);
+    breakTargets.pop_back();
+
+    startBlock(exit);
+}
+
+// Generated C++ never falls through (a break is added to every case
+// without one), so every case ends by jumping past the switch
+void IrBuilder::buildSwitch(SwitchNode *switchNode)
+{
+    Operand condition = buildExpression(switchNode->condition);
+    if (!isIntLike(condition.type))
+        error("switch condition must be int, char or bool");
+    uint32_t test = current;
+    uint32_t exit = newBlock();
+
+    std::vector<IrCase> cases;
+    uint32_t defaultTarget = exit;
+    breakTargets.push_back(exit);
+    for (CaseNode *caseNode : switchNode->cases)
+    {
+        uint32_t body = newBlock();
+        if (caseNode->value == nullptr)
+        {
+            defaultTarget = body;
+        }
+        else
+        {
+            int32_t value = 0;
+            if (!caseValue(caseNode->value, value))
+                error("case value must be an int, char or bool literal");
+            cases.push_back({value, body});
+        }
+        startBlock(body);
+        buildBlock(caseNode->body);
+        jump(current, exit);
+    }
+    breakTargets.pop_back();
+
+    IrBlock &block = prog->blocks[test];
+    block.end = IrTerminator::Switch;
+    block.condition = condition.reg;
+    block.target = defaultTarget;
+    block.cases = std::move(cases);
+    startBlock(exit);
+}
+
+// dst = value, converted to dst's type. A temporary computed just for this
+// is renamed to dst instead of being copied.
+void IrBuilder::assign(uint32_t dst, Operand value)
+{
+    IrType type = prog->registers[dst].type;
+    IrInstruction *def = definition(value.reg);
+    if (def != nullptr && value.type == type && def->op != IrOp::Print)
+    {
+        def->dst = dst;
+        return;
+    }
+    convert(dst, value, type);
+}
+
+// Operands are built before the operation using them, from the walker's
+// stack, so nesting costs no C++ stack
+IrBuilder::Operand IrBuilder::buildExpression(ParserNode *node)
+{
+    markBranches(node);
+    walker.walk(&node,
+        [this](ParserNode **site)
+        {
+            if (node_cast<UnaryNode>(*site) != nullptr)
+                return true;
+            if (node_cast<BinOpNode>(*site) == nullptr)
+                return false;
+            pending.push_back({false, 0, 0});
+            return true;
+        },
+        [this](ParserNode **site)
+        {
+            auto bin = static_cast<BinOpNode*>(*site);
+            if (branching.erase(bin) != 0)
+                startLogic(bin);
+            else if (bin->op->type == And || bin->op->type == Or)
+                operands.back() = coerce(operands.back(), IrType::Bool);
+        },
+        [this](ParserNode **site) { operands.push_back(buildNode(*site)); });
+    Operand result = operands.back();
+    operands.pop_back();
+    return result;
+}
+
+// Finds the && and || whose right side could trap, bottom-up in one pass,
+// so each is known before its right side is built
+void IrBuilder::markBranches(ParserNode *node)
+{
+    walker.walk(&node,
+        [](ParserNode **site) { return node_cast<FunctionCall>(*site) == nullptr; },
+        [](ParserNode **) {},
+        [this](ParserNode **site)
+        {
+            bool traps = mayTrap(*site);
+            if (auto bin = node_cast<BinOpNode>(*site))
+            {
+                bool right = trapping.back();
+                trapping.pop_back();
+                if (right && (bin->op->type == And || bin->op->type == Or))
+                    branching.insert(bin);
+                traps = traps || right || trapping.back();
+                trapping.pop_back();
+            }
+            else if (node_cast<UnaryNode>(*site) != nullptr)
+            {
+                traps = traps || trapping.back();
+                trapping.pop_back();
+            }
+            trapping.push_back(traps);
+        });
+    trapping.pop_back();
+}
+
+// Builds one node whose operands are already built, on top of 'operands'
+IrBuilder::Operand IrBuilder::buildNode(ParserNode *node)
+{
+    if (node == nullptr)
+    {
+        error("expression failed to parse");
+        return {newRegister(IrType::Int), IrType::Int};
+    }
+
+    IrConstant value{IrType::Int};
+    switch (node->kind)
+    {
+    case NodeKind::Variable: {
+        auto var = static_cast<VariableNode*>(node);
+        uint32_t reg = lookup(var->id);
+        if (reg == NO_REGISTER)
+        {
+            error("use of undeclared variable '" + std::string(var->name) + "'");
+            return {newRegister(IrType::Int), IrType::Int};
+        }
+        return {reg, prog->registers[reg].type};
+    }
+    case NodeKind::BinOp: {
+        Pending op = pending.back();
+        pending.pop_back();
+        Operand right = operands.back();
+        operands.pop_back();
+        if (op.branches)
+            return finishLogic(op, right);
+        Operand left = operands.back();
+        operands.pop_back();
+        return buildBinOp(static_cast<BinOpNode*>(node), left, right);
+    }
+    case NodeKind::Unary: {
+        Operand operand = operands.back();
+        operands.pop_back();
+        return buildUnary(static_cast<UnaryNode*>(node), operand);
+    }
+    case NodeKind::Number: {
+        auto num = static_cast<NumberNode*>(node);
+        switch (num->type)
+        {
+        case NumberType::Int:
+            value.i = static_cast<int32_t>(num->value);
+            break;
+        case NumberType::Float:
+            value.type = IrType::Float;
+            value.d = static_cast<float>(num->value);
+            break;
+        case NumberType::Double:
+            value.type = IrType::Double;
+            value.d = num->value;
+            break;
+        }
+        break;
+    }
+    case NodeKind::String:
+        value.type = IrType::String;
+        value.text = static_cast<StringNode*>(node)->value;
+        break;
+    case NodeKind::Char:
+        value.type = IrType::Char;
+        value.i = static_cast<CharNode*>(node)->value;
+        break;
+    case NodeKind::Boolean:
+        value.type = IrType::Bool;
+        value.i = static_cast<BooleanNode*>(node)->value ? 1 : 0;
+        break;
+    case NodeKind::FunctionCall:
+        error("functions are not supported");
+        return {newRegister(IrType::Int), IrType::Int};
+    // statements are not expressions
+    case NodeKind::WhileLoop:
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::Declaration:
+    case NodeKind::Assignment:
+    case NodeKind::If:
+    case NodeKind::Print:
+    case NodeKind::Operator:
+    case NodeKind::Case:
+    case NodeKind::Switch:
+    case NodeKind::Break:
+        error("invalid expression");
+        return {newRegister(IrType::Int), IrType::Int};
+    }
+    return constant(std::move(value));
+}
+
+// && and || that reach here evaluate both sides eagerly
+IrBuilder::Operand IrBuilder::buildBinOp(BinOpNode *bin, Operand left, Operand right)
+{
+    OperatorType op = bin->op->type;
+    if (op == And || op == Or)
+    {
+        left = coerce(left, IrType::Bool);
+        right = coerce(right, IrType::Bool);
+        uint32_t result = newRegister(IrType::Bool);
+        emit(operatorOps[op], IrType::Bool, result, left.reg, right.reg);
+        return {result, IrType::Bool};
+    }
+
+    bool comparison = op >= Equal && op <= GreaterThanEqualTo;
+    bool strings = left.type == IrType::String || right.type == IrType::String;
+    IrType common = strings ? IrType::String : arithmeticType(left.type, right.type);
+    bool supported = op >= Add && op <= GreaterThanEqualTo && op != Increment && op != Decrement;
+    if (strings)
+        supported = supported && left.type == right.type && (op == Equal || op == NotEqual);
+    if (op == Modulus && common != IrType::Int)
+        supported = false;
+    if (!supported)
+    {
+        error(std::string("operator '") + bin->op->getOperatorString() + "' is not supported on these operands");
+        return {newRegister(IrType::Int), IrType::Int};
+    }
+
+    left = coerce(left, common);
+    right = coerce(right, common);
+    uint32_t result = newRegister(comparison ? IrType::Bool : common);
+    emit(operatorOps[op], common, result, left.reg, right.reg);
+    return {result, comparison ? IrType::Bool : common};
+}
+
+IrBuilder::Operand IrBuilder::buildUnary(UnaryNode *unary, Operand operand)
+{
+    if (operand.type == IrType::String)
+    {
+        error(std::string("operator '") + unary->op->getOperatorString() + "' is not supported on strings");
+        return {newRegister(IrType::Int), IrType::Int};
+    }
+
+    if (unary->op->type == Not)
+    {
+        operand = coerce(operand, IrType::Bool);
+        uint32_t result = newRegister(IrType::Bool);
+        emit(IrOp::Not, IrType::Bool, result, operand.reg);
+        return {result, IrType::Bool};
+    }
+    // bool and char promote to int, as in C++
+    IrType type = isIntLike(operand.type) ? IrType::Int : operand.type;
+    uint32_t result = newRegister(type);
+    emit(IrOp::Neg, type, result, operand.reg);
+    return {result, type};
+}
+
+// && and || are plain instructions when both sides can be evaluated
+// eagerly. Otherwise the right side gets its own block, so it only runs
+// when needed, like in the C++ source. Runs between the two operands.
+void IrBuilder::startLogic(BinOpNode *bin)
+{
+    Operand left = operands.back();
+    operands.pop_back();
+    Pending &op = pending.back();
+    op.branches = true;
+    op.result = newRegister(IrType::Bool);
+    convert(op.result, left, IrType::Bool);
+    uint32_t test = current;
+    uint32_t rhs = newBlock();
+    op.join = newBlock();
+    if (bin->op->type == And)
+        branch(test, op.result, rhs, op.join);
+    else
+        branch(test, op.result, op.join, rhs);
+    startBlock(rhs);
+}
+
+IrBuilder::Operand IrBuilder::finishLogic(const Pending &op, Operand right)
+{
+    convert(op.result, right, IrType::Bool);
+    jump(current, op.join);
+    startBlock(op.join);
+    return {op.result, IrType::Bool};
+}
+
+// Write src into dst as type `to`, with C++ implicit conversion rules
+void IrBuilder::convert(uint32_t dst, Operand src, IrType to)
+{
+    IrType from = src.type;
+    if (from == to || (isIntLike(from) && to == IrType::Int))
+    {
+        if (dst != src.reg)
+            emit(IrOp::Copy, to, dst, src.reg);
+        return;
+    }
+    if (from == IrType::String || to == IrType::String)
+    {
+        error("cannot convert between string and non-string values");
+        return;
+    }
+    if (!convertConstant(src, to, dst))
+        emit(IrOp::Convert, to, dst, src.reg);
+}
+
+IrBuilder::Operand IrBuilder::coerce(Operand src, IrType to)
+{
+    if (src.type == to || (isIntLike(src.type) && to == IrType::Int))
+        return src;
+    Operand result = {newRegister(to), to};
+    convert(result.reg, src, to);
+    return result;
+}
+
+// A literal that was just loaded is converted at compile time instead
+bool IrBuilder::convertConstant(Operand src, IrType to, uint32_t dst)
+{
+    IrInstruction *def = definition(src.reg);
+    if (def == nullptr || def->op != IrOp::Const)
+        return false;
+    IrConstant &c = prog->constants[def->a];
+    bool floating = c.type == IrType::Float || c.type == IrType::Double;
+    switch (to)
+    {
+    case IrType::Int:
+        if (!truncate(c.d, c.i))
+            return false;
+        break;
+    case IrType::Char: {
+        int32_t i = c.i;
+        if (floating && !truncate(c.d, i))
+            return false;
+        c.i = static_cast<char>(i);
+        break;
+    }
+    case IrType::Bool:
+        c.i = floating ? c.d != 0 : c.i != 0;
+        break;
+    case IrType::Float:
+        c.d = static_cast<float>(floating ? c.d : c.i);
+        break;
+    case IrType::Double:
+        if (!floating)
+            c.d = c.i;
+        break;
+    case IrType::String:
+        return false;
+    }
+    c.type = to;
+    def->type = to;
+    def->dst = dst;
+    return true;
+}
+
+// Sends jumps past blocks that only jump on, then drops unreachable blocks
+// and renumbers the rest in layout order
+void IrBuilder::finish()
+{
+    std::vector<IrBlock> &blocks = prog->blocks;
+    auto forward = [&](uint32_t b)
+    {
+        for (size_t hops = 0; hops < blocks.size(); hops++)
+        {
+            const IrBlock &block = blocks[b];
+            if (!block.code.empty() || block.end != IrTerminator::Jump)
+                break;
+            b = block.target;
+        }
+        return b;
+    };
+    for (IrBlock &block : blocks)
+    {
+        block.target = forward(block.target);
+        block.otherwise = forward(block.otherwise);
+        for (IrCase &c : block.cases)
+            c.target = forward(c.target);
+    }
+
+    std::vector<bool> reachable(blocks.size(), false);
+    std::vector<uint32_t> work = {0};
+    reachable[0] = true;
+    while (!work.empty())
+    {
+        const IrBlock &block = blocks[work.back()];
+        work.pop_back();
+        auto visit = [&](uint32_t b)
+        {
+            if (!reachable[b])
+            {
+                reachable[b] = true;
+                work.push_back(b);
+            }
+        };
+        switch (block.end)
+        {
+        case IrTerminator::Branch:
+            visit(block.otherwise);
+            visit(block.target);
+            break;
+        case IrTerminator::Switch:
+            for (const IrCase &c : block.cases)
+                visit(c.target);
+            visit(block.target);
+            break;
+        case IrTerminator::Jump:
+            visit(block.target);
+            break;
+        case IrTerminator::Return:
+            break;
+        }
+    }
+
+    std::vector<uint32_t> renumbered(blocks.size(), NO_REGISTER);
+    std::vector<IrBlock> kept;
+    for (uint32_t b : layout)
+    {
+        if (reachable[b] && renumbered[b] == NO_REGISTER)
+        {
+            renumbered[b] = static_cast<uint32_t>(kept.size());
+            kept.push_back(std::move(blocks[b]));
+        }
+    }
+    for (IrBlock &block : kept)
+    {
+        block.target = renumbered[block.target];
+        block.otherwise = block.end == IrTerminator::Branch ? renumbered[block.otherwise] : 0;
+        for (IrCase &c : block.cases)
+            c.target = renumbered[c.target];
+    }
+    blocks = std::move(kept);
+}
@@ -0,0 +1,230 @@
+#ifndef IR_H
+#define IR_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "parser.h"
+
+// Three-address intermediate representation between the checked AST and
+// the backends. A program is one function: basic blocks of instructions
+// over numbered virtual registers, ended by a terminator, with the CFG
+// edges stored on the blocks. Every implicit C++ conversion is an explicit
+// Convert, so a backend only has to map each instruction to its target.
+
+constexpr uint32_t NO_REGISTER = UINT32_MAX;
+
+// Type of a virtual register. Int, Bool and Char values are all int32:
+// Bool is 0 or 1 and Char is sign-extended, as in the bytecode VM.
+enum class IrType : uint8_t
+{
+	Int,
+	Float,
+	Double,
+	Bool,
+	Char,
+	String
+};
+
+// IrType holding values of a checked type; false for types without values
+bool irTypeOf(const Type *type, IrType &out);
+bool isIntLike(IrType t); // Int, Bool or Char: all int32
+// C++ usual arithmetic conversions for the types C* has
+IrType arithmeticType(IrType a, IrType b);
+
+// Every instruction, in IrOp order
+#define CSTAR_IR_OPS(X) \
+	X(Const) X(Copy) X(Convert)                  \
+	X(Add) X(Sub) X(Mul) X(Div) X(Mod) X(Neg)    \
+	X(Eq) X(Ne) X(Lt) X(Le) X(Gt) X(Ge)          \
+	X(And) X(Or) X(Not)                          \
+	X(Print)
+
+enum class IrOp : uint8_t
+{
+#define CSTAR_IR_OP_ENUM(name) name,
+	CSTAR_IR_OPS(CSTAR_IR_OP_ENUM)
+#undef CSTAR_IR_OP_ENUM
+};
+
+// dst = a op b. 'type' is what the operation computes in: the result for
+// arithmetic and Convert, the operands for comparisons (which yield Bool),
+// and the printed value for Print.
+struct IrInstruction
+{
+	IrOp op;
+	IrType type;
+	uint32_t dst; // NO_REGISTER for Print
+	uint32_t a;   // Const: index into IrProgram::constants
+	uint32_t b;
+};
+
+// Calls f with each register an instruction reads, in operand order
+template <typename F>
+inline void forEachOperand(const IrInstruction &instr, F f)
+{
+	switch (instr.op)
+	{
+	case IrOp::Const:
+		break; // 'a' is a constant index
+	case IrOp::Copy:
+	case IrOp::Convert:
+	case IrOp::Neg:
+	case IrOp::Not:
+	case IrOp::Print:
+		f(instr.a);
+		break;
+	case IrOp::Add:
+	case IrOp::Sub:
+	case IrOp::Mul:
+	case IrOp::Div:
+	case IrOp::Mod:
+	case IrOp::Eq:
+	case IrOp::Ne:
+	case IrOp::Lt:
+	case IrOp::Le:
+	case IrOp::Gt:
+	case IrOp::Ge:
+	case IrOp::And:
+	case IrOp::Or:
+		f(instr.a);
+		f(instr.b);
+		break;
+	}
+}
+
+struct IrConstant
+{
+	IrType type;
+	int32_t i = 0;      // Int, Bool and Char
+	double d = 0;       // Float and Double (a Float is stored exactly)
+	std::string text{}; // String, with the source's C++ escapes
+};
+
+enum class IrTerminator : uint8_t
+{
+	Jump,
+	Branch,
+	Switch,
+	Return
+};
+
+struct IrCase
+{
+	int32_t value;
+	uint32_t target;
+};
+
+struct IrBlock
+{
+	std::vector<IrInstruction> code;
+
+	IrTerminator end = IrTerminator::Return;
+	uint32_t condition = NO_REGISTER; // Branch and Switch operand
+	uint32_t target = 0;              // Jump; Branch when true; Switch default
+	uint32_t otherwise = 0;           // Branch when false
+	std::vector<IrCase> cases;        // Switch
+
+	// CFG edges, filled in by IrProgram::link()
+	std::vector<uint32_t> successors;
+	std::vector<uint32_t> predecessors;
+};
+
+struct IrRegister
+{
+	IrType type;
+	std::string_view name; // Source variable, owned by the StringInterner; empty for temporaries
+};
+
+struct IrProgram
+{
+	std::vector<IrRegister> registers;
+	std::vector<IrConstant> constants;
+	std::vector<IrBlock> blocks; // blocks[0] is the entry
+
+	// Recomputes successors and predecessors from the terminators
+	void link();
+	size_t instructionCount() const;
+	// Text form for --emit-ir
+	void print(std::ostream &out) const;
+};
+
+const char *irTypeName(IrType type);
+const char *irOpName(IrOp op);
+
+// Lowers a checked (and optionally optimized) AST to IR. Variables get one
+// register each; && and || whose right side could trap become branches.
+class IrBuilder
+{
+public:
+	explicit IrBuilder(std::ostream &diagnostics = std::cerr) : diagnostics(diagnostics) {}
+
+	// Returns false (after reporting) if the program uses something the
+	// backends do not support
+	bool build(const std::vector<ParserNode*> &program, IrProgram &out);
+
+private:
+	struct Operand
+	{
+		uint32_t reg;
+		IrType type;
+	};
+
+	// BinOp whose operands are being built
+	struct Pending
+	{
+		bool branches;   // && or || lowered as branches
+		uint32_t result; // Branches: register holding the result
+		uint32_t join;   // Branches: block after the right side
+	};
+
+	std::ostream &diagnostics;
+	IrProgram *prog = nullptr;
+	uint32_t current = 0;        // Block being filled
+	std::vector<uint32_t> layout; // Blocks in the order they were started
+	std::vector<std::unordered_map<SymbolId, uint32_t>> scopes;
+	std::vector<uint32_t> breakTargets; // Innermost loop or switch last
+	ExpressionWalker walker;
+	std::vector<Operand> operands;           // Built operands not yet used
+	std::vector<Pending> pending;            // BinOps whose operands are being built
+	std::vector<bool> trapping;              // markBranches: whether each operand could trap
+	std::unordered_set<BinOpNode*> branching; // && and || to lower as branches
+	bool ok = true;
+
+	void error(const std::string &message);
+	uint32_t newRegister(IrType type, std::string_view name = {});
+	uint32_t newBlock();
+	void startBlock(uint32_t block);
+	void emit(IrOp op, IrType type, uint32_t dst, uint32_t a = NO_REGISTER, uint32_t b = NO_REGISTER);
+	Operand constant(IrConstant value);
+	void jump(uint32_t from, uint32_t to);
+	void branch(uint32_t from, uint32_t condition, uint32_t whenTrue, uint32_t whenFalse);
+	uint32_t lookup(SymbolId id) const;
+
+	void buildBlock(const NodeList &statements);
+	void buildStatement(ParserNode *node);
+	void buildIf(IfNode *ifNode);
+	void buildWhile(WhileLoopNode *whileNode);
+	void buildSwitch(SwitchNode *switchNode);
+	void assign(uint32_t dst, Operand value);
+
+	Operand buildExpression(ParserNode *node);
+	void markBranches(ParserNode *node);
+	Operand buildNode(ParserNode *node);
+	Operand buildBinOp(BinOpNode *bin, Operand left, Operand right);
+	Operand buildUnary(UnaryNode *unary, Operand operand);
+	void startLogic(BinOpNode *bin);
+	Operand finishLogic(const Pending &op, Operand right);
+	void convert(uint32_t dst, Operand src, IrType to);
+	Operand coerce(Operand src, IrType to);
+	bool convertConstant(Operand src, IrType to, uint32_t dst);
+	IrInstruction *definition(uint32_t reg);
+
+	void finish();
+};
+
+#endif // IR_H
@@ -1,215 +1,150 @@
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
-#include <sstream>
-#include <set>
-#include <algorithm>
-#include <cctype>
-#include "semanticAnalyzer.h" 
-#include "tokenizer.h"
-#include "parser.h"
-#include "codegenerator.h"
+#include <thread>
+#include <optional>
+#include <filesystem>
+#include <charconv>
+#include <cstdint>
+#include "pipeline.h"
+#include "batch.h"
+#include "timeReport.h"
+#include "compileCache.h"
+
+// Most worker threads --batch will start
+static const uint64_t MAX_JOBS = 1024;
+
+// A whole decimal number within [min, max], without sign or spaces
+static bool parseCount(const std::string &text, uint64_t min, uint64_t max, uint64_t &value) {
+    const char *end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end && value >= min && value <= max;
+}
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "No input file detected!!\n";
-        return 1;
-    }
-
-    std::ifstream myfile(argv[1]);
-    if (!myfile.is_open()) {
-        std::cerr << "Failed to open file: " << argv[1] << "\n";
-        return 1;
-    }
-
-    Tokenizer tokenizer(myfile);
-    Token token;
-
-    std::vector<Token> tokens;
-    std::vector<Token> keywords;
-    std::vector<Token> dataTypes;
-    std::vector<Token> identifiers;
-    std::vector<Token> intLiterals;
-    std::vector<Token> floatLiterals;
-    std::vector<Token> charLiterals;
-    std::vector<Token> stringLiterals;
-    std::vector<Token> boolLiterals;
-    std::vector<Token> operators;
-    std::vector<Token> punctuation;
-    std::vector<Token> unknown;
-    
-    //   std::cout << "\n===== STARTING TOKENIZATION =====\n" << std::endl;
-
-    do
-    {
-        token = tokenizer.getNextToken();
-        tokens.push_back(token);
-
-        // Print tokens as they're found
-        // std::cout << "Line " << token.line << ": " << token.typeToString() << " [" << token.text << "]" << std::endl;
-
-        switch (token.type)
-        {
-        case TokenType::KEYWORD:
-            keywords.push_back(token);
-            break;
-        case TokenType::DATA_TYPE:
-            dataTypes.push_back(token);
-            break;
-        case TokenType::IDENTIFIER:
-            identifiers.push_back(token);
-            break;
-        case TokenType::INTEGER_LITERAL:
-            intLiterals.push_back(token);
-            break;
-        case TokenType::FLOAT_LITERAL:
-            floatLiterals.push_back(token);
-            break;
-        case TokenType::CHAR_LITERAL:
-            charLiterals.push_back(token);
-            break;
-        case TokenType::STRING_LITERAL:
-            stringLiterals.push_back(token);
-            break;
-        case TokenType::BOOL_LITERAL:
-            boolLiterals.push_back(token);
-            break;
-        case TokenType::OPERATOR:
-            operators.push_back(token);
-            break;
-        case TokenType::PUNCTUATION:
-            punctuation.push_back(token);
-            break;
-        case TokenType::UNKNOWN:
-            if (!token.text.empty())
-            {
-                unknown.push_back(token);
+    std::vector<std::string> inputPaths;
+    CompileOptions options;
+    bool batch = false;
+    unsigned jobs = std::thread::hardware_concurrency();
+    std::string timeReportFormat; // "table" or "json"; empty = no report
+    bool useCache = true;
+    bool cacheStats = false;
+    std::string cacheDir = ".cstar_cache";
+    uint64_t cacheMb = 256;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--arena-stats") {
+            options.arenaStats = true;
+        } else if (arg == "--run") {
+            options.runMode = true;
+        } else if (arg == "--run-stats") {
+            options.runMode = true;
+            options.runStats = true;
+        } else if (arg == "--no-opt") {
+            options.optimize = false;
+        } else if (arg == "--opt-report") {
+            options.optReport = true;
+        } else if (arg == "--emit-ir") {
+            options.emitIr = true;
+        } else if (arg == "--native") {
+            options.native = true;
+        } else if (arg == "--time-report" || arg == "--time-report=table") {
+            timeReportFormat = "table";
+        } else if (arg == "--time-report=json") {
+            timeReportFormat = "json";
+        } else if (arg == "-O0" || arg == "-O1" || arg == "-O2" || arg == "-O3" || arg == "-Ofast") {
+            options.profile.optLevel = arg;
+        } else if (arg.rfind("--march=", 0) == 0) {
+            // Goes on the g++ command line, so only allow CPU-name characters
+            std::string cpu = arg.substr(8);
+            if (cpu.empty() || cpu.find_first_not_of("abcdefghijklmnopqrstuvwxyz0123456789-_.") != std::string::npos) {
+                std::cerr << "Invalid target CPU: " << arg << "\n";
+                return 1;
             }
-            break;
-        case TokenType::END_OF_FILE:
-            break;
-        }
-    } while (token.type != TokenType::END_OF_FILE);
-
-    //   std::cout << "\n===== TOKENIZATION REPORT =====\n" << std::endl;
-
-    //   std::cout << "Nonempty lines processed: " << tokenizer.getEffectiveLineCount() << std::endl;
-
-    auto printCategory = [](const std::string &categoryName, const std::vector<Token> &tokens)
-    {
-        // std::cout << "\n" << categoryName << " (" << tokens.size() << "):" << std::endl;
-        std::set<std::string> uniqueTokens; // Show unique tokens found
-
-        for (const auto &t : tokens)
-        {
-            uniqueTokens.insert(t.text);
-        }
-
-        if (uniqueTokens.empty())
-        {
-            //   std::cout << "  (None)" << std::endl;
-        }
-        else
-        {
-            int count = 0;
-            for (const auto &text : uniqueTokens)
-            {
-                // std::cout << "  " << text << (++count % 5 == 0 ? "\n" : "");
+            options.profile.march = cpu;
+        } else if (arg == "--lto") {
+            options.profile.lto = true;
+        } else if (arg == "--pgo") {
+            options.pgo = true;
+        } else if (arg == "--no-cache") {
+            useCache = false;
+        } else if (arg == "--cache-stats") {
+            cacheStats = true;
+        } else if (arg.rfind("--cache-dir=", 0) == 0) {
+            cacheDir = arg.substr(12);
+        } else if (arg.rfind("--cache-size=", 0) == 0) {
+            // The limit is kept in bytes, so it must fit once multiplied out
+            if (!parseCount(arg.substr(13), 0, UINT64_MAX / (1024 * 1024), cacheMb)) {
+                std::cerr << "Invalid cache size (MB): " << arg << "\n";
+                return 1;
+            }
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg.rfind("-j", 0) == 0) {
+            std::string count = arg.size() > 2 ? arg.substr(2) : (i + 1 < argc ? argv[++i] : "");
+            uint64_t value;
+            if (!parseCount(count, 1, MAX_JOBS, value)) {
+                std::cerr << "Invalid job count: " << arg << "\n";
+                return 1;
             }
-            //   if (count % 5 != 0) std::cout << std::endl; // Ensure newline at end
+            jobs = static_cast<unsigned>(value);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        } else {
+            inputPaths.push_back(arg);
         }
-    };
-
-    //   printCategory("Data Types", dataTypes);
-    //   printCategory("Other Keywords", keywords); // (Keywords not classified as types/bools)
-    //   printCategory("Operators", operators);
-    //   printCategory("Identifiers (Variables/Functions/etc.)", identifiers);
-    //   printCategory("Integer Literals", intLiterals);
-    //   printCategory("Float/Double Literals", floatLiterals);
-    //   printCategory("Boolean Literals", boolLiterals);
-    //   printCategory("Character Literals", charLiterals);
-    //   printCategory("String Literals", stringLiterals);
-    //   printCategory("Punctuation", punctuation);
-    //   printCategory("Unknown Tokens", unknown);
-
-    Parser parser(tokens);
-    std::vector<ParserNode *> parserNodes = parser.parse();
-
-    SemanticAnalyzer sem;
-    sem.analyze(parserNodes);
-
-    for (ParserNode *node : parserNodes)
-    {
-        node->print();
-        std::cout << std::endl;
     }
 
-    std::cout << "Beginning code generation: \n\n\n";
-
-    // Code generation time!
-    std::string inputFilename(argv[1]);
-
-    size_t slash = inputFilename.find_last_of("\\/");
-    std::string dir, filename;
-    if (slash == std::string::npos)
-    {
-        dir = "";
-        filename = inputFilename;
+    // cstar_runtime.h ships next to the compiler
+    std::string compilerDir = std::filesystem::path(argv[0]).parent_path().string();
+    if (!compilerDir.empty()) {
+        options.runtimeDir = compilerDir;
     }
-    else
-    {
-        dir = inputFilename.substr(0, slash + 1); // e.g. "tests\"
-        filename = inputFilename.substr(slash + 1); // e.g. "testcase1.cstar"
-    }
-
-    size_t dot = filename.find_last_of('.');
-    std::string base = (dot == std::string::npos) ? filename : filename.substr(0, dot);
 
-    // Prepend "_" to the basename, append "_output.cpp", and rejoin
-    std::string outputCpp = dir + "_" + base + "_output.cpp";
-
-    std::ofstream outputFile(outputCpp);
-
-    if (!outputFile.is_open()) {
-        std::cerr << "Failed to open output file for writing.\n";
+    if (inputPaths.empty()) {
+        std::cerr << "No input file detected!!\n";
         return 1;
     }
 
-    outputFile << "#include <iostream>\n\n";
-    outputFile << "int main() {\n";
+    std::optional<CompileCache> cache;
+    if (useCache) {
+        cache.emplace(cacheDir, cacheMb * 1024 * 1024);
+        options.cache = &*cache;
+    }
+    auto printCacheStats = [&]() {
+        if (cacheStats && cache) {
+            cache->printStats(std::cerr);
+        }
+    };
 
-    for (ParserNode *node : parserNodes)
-    {
-        std::string generated = generateCode(node);
-        // Strip main() header and footer if included
-        size_t bodyStart = generated.find("{");
-        size_t bodyEnd = generated.rfind("return 0;");
-        if (bodyStart != std::string::npos && bodyEnd != std::string::npos) {
-            std::string body = generated.substr(bodyStart + 1, bodyEnd - bodyStart - 1);
-            // outputFile << body << "\n";
-            outputFile << body;
-        } else {
-            outputFile << "    // Code generation failed for this node\n";
+    if (batch) {
+        // Allocation counters are process-wide, so per-file reports would mix threads
+        if (!timeReportFormat.empty()) {
+            std::cerr << "--time-report cannot be combined with --batch\n";
+            return 1;
         }
+        // Workers share stdout, so keep only output that is captured per file
+        options.dumpAst = false;
+        options.runExecutable = false;
+        options.executable.clear();
+        int status = runBatch(inputPaths, options, jobs == 0 ? 1 : jobs);
+        printCacheStats();
+        return status;
     }
 
-    outputFile << "return 0;\n";
-    outputFile << "}\n";
-    outputFile.close();
-    std::cout << "C++ code written to: " << outputCpp << std::endl;
-
-    // Compile the generated file
-    std::string compileCommand = "g++ " + outputCpp + " -o generated_output";
-    int compileStatus = system(compileCommand.c_str());
-    if (compileStatus != 0) {
-        std::cerr << "Compilation failed!\n";
-    } else {
-        std::cout << "Running generated program:\n\n";
-        std::cout << "\n\n\n\n==================================\n\n\n\n";
-        system("generated_output.exe");
-        std::cout << "\n\nEnd of file!\n\n==================================\n\n\n\n";
+    if (inputPaths.size() > 1) {
+        std::cerr << "Multiple input files need --batch\n";
+        return 1;
     }
 
-    return 0;
+    TimeReport timeReport;
+    int status = compileFile(inputPaths[0], options, std::cout, std::cerr, &timeReport);
+    if (timeReportFormat == "json") {
+        timeReport.printJson(std::cerr);
+    } else if (timeReportFormat == "table") {
+        timeReport.printTable(std::cerr);
+    }
+    printCacheStats();
+    return status;
 }
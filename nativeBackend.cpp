@@ -0,0 +1,1660 @@
+#include "nativeBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+
+// Machine registers, in encoding order. XMM registers use 0-15 the same way.
+enum Reg : int
+{
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+constexpr int XMM0 = 0;
+constexpr int XMM1 = 1;
+
+// Registers the linear scan hands out. The runtime routines never touch
+// them (printDouble saves what it uses), so values survive every print.
+// The rest are scratch for lowering single instructions.
+constexpr int allocatableGprs[] = {RBX, RBP, R12, R13, R14, R15};
+constexpr int allocatableXmms[] = {2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+
+enum Cond : uint8_t
+{
+    CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7,
+    CC_S = 0x8, CC_NS = 0x9, CC_P = 0xA, CC_NP = 0xB, CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF
+};
+
+Cond invert(Cond cc)
+{
+    return static_cast<Cond>(cc ^ 1);
+}
+
+enum AluOp : uint8_t { ADD, OR, ADC, SBB, AND, SUB, XOR, CMP };
+
+// /digit of the F7 and C1 groups
+enum GroupOp : uint8_t { NOT = 2, NEG = 3, MUL = 4, DIV = 6, IDIV = 7, SHL = 4, SHR = 5, SAR = 7 };
+
+// Scalar SSE opcodes; the F3/F2 prefix picks float or double
+enum SseOp : uint8_t { MOVS = 0x10, ADDS = 0x58, MULS = 0x59, CVTS = 0x5A, SUBS = 0x5C, DIVS = 0x5E };
+
+// [base + index*scale + disp], or [rip + symbol + disp] when symbol >= 0
+struct Mem
+{
+    int base = RSP;
+    int index = -1;
+    int scale = 1;
+    int32_t disp = 0;
+    int symbol = -1;
+};
+
+Mem at(int base, int32_t disp = 0)
+{
+    Mem m;
+    m.base = base;
+    m.disp = disp;
+    return m;
+}
+
+Mem at(int base, int index, int scale, int32_t disp = 0)
+{
+    Mem m = at(base, disp);
+    m.index = index;
+    m.scale = scale;
+    return m;
+}
+
+Mem sym(int symbol, int32_t disp = 0)
+{
+    Mem m;
+    m.symbol = symbol;
+    m.disp = disp;
+    return m;
+}
+
+// Encodes the x86-64 instructions the backend uses into a code buffer,
+// with forward labels and RIP-relative references to data symbols that
+// are resolved once the image layout is known
+class Assembler
+{
+public:
+    std::vector<uint8_t> code;
+    std::vector<uint8_t> rodata;
+    uint32_t bssSize = 0;
+
+    int newLabel()
+    {
+        labels.push_back(-1);
+        return static_cast<int>(labels.size() - 1);
+    }
+
+    void bind(int label) { labels[label] = static_cast<int64_t>(code.size()); }
+
+    int rodataSymbol(const void *data, size_t size, size_t align)
+    {
+        rodata.resize((rodata.size() + align - 1) / align * align);
+        symbols.push_back({false, static_cast<uint32_t>(rodata.size())});
+        const uint8_t *bytes = static_cast<const uint8_t*>(data);
+        rodata.insert(rodata.end(), bytes, bytes + size);
+        return static_cast<int>(symbols.size() - 1);
+    }
+
+    int bssSymbol(uint32_t size, uint32_t align)
+    {
+        bssSize = (bssSize + align - 1) / align * align;
+        symbols.push_back({true, bssSize});
+        bssSize += size;
+        return static_cast<int>(symbols.size() - 1);
+    }
+
+    // Patches every jump and data reference for the final addresses
+    void link(uint64_t codeAddress, uint64_t rodataAddress, uint64_t bssAddress)
+    {
+        for (const LabelFixup &fix : labelFixups)
+            patch(fix.at, labels[fix.label] - static_cast<int64_t>(fix.at + 4));
+        for (const SymbolFixup &fix : symbolFixups)
+        {
+            const Symbol &s = symbols[fix.symbol];
+            uint64_t target = (s.bss ? bssAddress : rodataAddress) + s.offset + fix.addend;
+            patch(fix.at, static_cast<int64_t>(target - (codeAddress + fix.at + 4 + fix.tail)));
+        }
+    }
+
+    // Integer instructions. 'w' selects 64-bit operands instead of 32-bit.
+    void mov(bool w, int dst, int src) { rr(0, {0x89}, w, src, dst); }
+    void movImm(int dst, int32_t imm) // zero-extends into the full register
+    {
+        rex(false, 0, 0, dst, false);
+        byte(0xB8 + (dst & 7));
+        dword(static_cast<uint32_t>(imm));
+    }
+    void movImm64(int dst, uint64_t imm)
+    {
+        rex(true, 0, 0, dst, false);
+        byte(0xB8 + (dst & 7));
+        dword(static_cast<uint32_t>(imm));
+        dword(static_cast<uint32_t>(imm >> 32));
+    }
+    void load(bool w, int dst, const Mem &m) { rm(0, {0x8B}, w, dst, m); }
+    void store(bool w, const Mem &m, int src) { rm(0, {0x89}, w, src, m); }
+    void storeImm(bool w, const Mem &m, int32_t imm)
+    {
+        rm(0, {0xC7}, w, 0, m, false, 4);
+        dword(static_cast<uint32_t>(imm));
+    }
+    void storeWordImm(const Mem &m, uint16_t imm)
+    {
+        rm(0x66, {0xC7}, false, 0, m, false, 2);
+        byte(imm & 0xFF);
+        byte(imm >> 8);
+    }
+    void storeByte(const Mem &m, int src) { rm(0, {0x88}, false, src, m, true); }
+    void storeByteImm(const Mem &m, uint8_t imm)
+    {
+        rm(0, {0xC6}, false, 0, m, false, 1);
+        byte(imm);
+    }
+    void loadByte(int dst, const Mem &m) { rm(0, {0x0F, 0xB6}, false, dst, m); } // movzx
+    void lea(int dst, const Mem &m) { rm(0, {0x8D}, true, dst, m); }
+    void alu(AluOp op, bool w, int dst, int src) { rr(0, {static_cast<uint8_t>(op * 8 + 1)}, w, src, dst); }
+    void aluImm(AluOp op, bool w, int dst, int32_t imm)
+    {
+        if (imm >= -128 && imm <= 127)
+        {
+            rr(0, {0x83}, w, op, dst);
+            byte(static_cast<uint8_t>(imm));
+        }
+        else
+        {
+            rr(0, {0x81}, w, op, dst);
+            dword(static_cast<uint32_t>(imm));
+        }
+    }
+    void imul(bool w, int dst, int src) { rr(0, {0x0F, 0xAF}, w, dst, src); }
+    void test(bool w, int a, int b) { rr(0, {0x85}, w, b, a); }
+    void group(GroupOp op, bool w, int r) { rr(0, {0xF7}, w, op, r); }
+    void shiftImm(GroupOp op, bool w, int r, uint8_t count)
+    {
+        rr(0, {0xC1}, w, op, r);
+        byte(count);
+    }
+    void shiftCl(GroupOp op, bool w, int r) { rr(0, {0xD3}, w, op, r); }
+    void cdq() { byte(0x99); }
+    void setcc(Cond cc, int r) { rr(0, {0x0F, static_cast<uint8_t>(0x90 + cc)}, false, 0, r, true); }
+    void movzxByte(int dst, int src) { rr(0, {0x0F, 0xB6}, false, dst, src, true); }
+    void movsxByte(int dst, int src) { rr(0, {0x0F, 0xBE}, false, dst, src, true); }
+    void movsxd(int dst, int src) { rr(0, {0x63}, true, dst, src); }
+    void push(int r)
+    {
+        rex(false, 0, 0, r, false);
+        byte(0x50 + (r & 7));
+    }
+    void pop(int r)
+    {
+        rex(false, 0, 0, r, false);
+        byte(0x58 + (r & 7));
+    }
+    void ret() { byte(0xC3); }
+    void syscall() { byte(0x0F); byte(0x05); }
+    void repMovsb() { byte(0xF3); byte(0xA4); }
+    void jmp(int label) { branch({0xE9}, label); }
+    void jcc(Cond cc, int label) { branch({0x0F, static_cast<uint8_t>(0x80 + cc)}, label); }
+    void call(int label) { branch({0xE8}, label); }
+
+    // Scalar SSE; 'dbl' picks the double form
+    void sse(SseOp op, bool dbl, int dst, int src) { rr(dbl ? 0xF2 : 0xF3, {0x0F, op}, false, dst, src); }
+    void sseLoad(bool dbl, int dst, const Mem &m) { rm(dbl ? 0xF2 : 0xF3, {0x0F, 0x10}, false, dst, m); }
+    void sseStore(bool dbl, const Mem &m, int src) { rm(dbl ? 0xF2 : 0xF3, {0x0F, 0x11}, false, src, m); }
+    void cvtsi2s(bool dbl, int dst, int src) { rr(dbl ? 0xF2 : 0xF3, {0x0F, 0x2A}, false, dst, src); }
+    void cvtts2si(bool dbl, int dst, int src) { rr(dbl ? 0xF2 : 0xF3, {0x0F, 0x2C}, false, dst, src); }
+    void ucomis(bool dbl, int a, int b) { rr(dbl ? 0x66 : 0, {0x0F, 0x2E}, false, a, b); }
+    void xorps(int dst, int src) { rr(0, {0x0F, 0x57}, false, dst, src); }
+    void movqFromXmm(int dst, int src) { rr(0x66, {0x0F, 0x7E}, true, src, dst); }
+
+private:
+    struct LabelFixup
+    {
+        size_t at;
+        int label;
+    };
+
+    struct SymbolFixup
+    {
+        size_t at;
+        int symbol;
+        int32_t addend;
+        int tail; // Instruction bytes after the displacement
+    };
+
+    struct Symbol
+    {
+        bool bss;
+        uint32_t offset;
+    };
+
+    std::vector<int64_t> labels; // Code offset, -1 until bound
+    std::vector<Symbol> symbols;
+    std::vector<LabelFixup> labelFixups;
+    std::vector<SymbolFixup> symbolFixups;
+
+    void byte(uint8_t b) { code.push_back(b); }
+    void dword(uint32_t d)
+    {
+        for (int i = 0; i < 4; i++)
+            code.push_back(static_cast<uint8_t>(d >> (8 * i)));
+    }
+    void patch(size_t at, int64_t value)
+    {
+        for (int i = 0; i < 4; i++)
+            code[at + i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+    }
+
+    // 'force' emits an empty REX so byte registers 4-7 mean spl..dil
+    void rex(bool w, int reg, int index, int base, bool force)
+    {
+        uint8_t r = 0x40 | (w ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((index & 8) ? 2 : 0) | ((base & 8) ? 1 : 0);
+        if (r != 0x40 || force)
+            byte(r);
+    }
+
+    // Register-direct form: ModRM.reg = reg, ModRM.rm = rm
+    void rr(int prefix, std::initializer_list<uint8_t> op, bool w, int reg, int rmReg, bool byteRegs = false)
+    {
+        if (prefix)
+            byte(static_cast<uint8_t>(prefix));
+        rex(w, reg, 0, rmReg, byteRegs && ((reg >= 4 && reg < 8) || (rmReg >= 4 && rmReg < 8)));
+        for (uint8_t b : op)
+            byte(b);
+        byte(0xC0 | ((reg & 7) << 3) | (rmReg & 7));
+    }
+
+    // Memory form. 'tail' counts immediate bytes that follow the
+    // displacement, which RIP-relative addressing has to skip.
+    void rm(int prefix, std::initializer_list<uint8_t> op, bool w, int reg, const Mem &m,
+            bool byteReg = false, int tail = 0)
+    {
+        if (prefix)
+            byte(static_cast<uint8_t>(prefix));
+        bool force = byteReg && reg >= 4 && reg < 8;
+        if (m.symbol >= 0)
+        {
+            rex(w, reg, 0, 0, force);
+            for (uint8_t b : op)
+                byte(b);
+            byte(0x05 | ((reg & 7) << 3));
+            symbolFixups.push_back({code.size(), m.symbol, m.disp, tail});
+            dword(0);
+            return;
+        }
+        rex(w, reg, m.index >= 0 ? m.index : 0, m.base, force);
+        for (uint8_t b : op)
+            byte(b);
+        bool sib = m.index >= 0 || (m.base & 7) == RSP;
+        int mod = (m.disp == 0 && (m.base & 7) != RBP) ? 0 : (m.disp >= -128 && m.disp <= 127) ? 1 : 2;
+        byte(static_cast<uint8_t>(mod << 6 | (reg & 7) << 3 | (sib ? 4 : (m.base & 7))));
+        if (sib)
+        {
+            int scaleBits = m.scale == 8 ? 3 : m.scale == 4 ? 2 : m.scale == 2 ? 1 : 0;
+            byte(static_cast<uint8_t>(scaleBits << 6 | ((m.index >= 0 ? m.index : RSP) & 7) << 3 | (m.base & 7)));
+        }
+        if (mod == 1)
+            byte(static_cast<uint8_t>(m.disp));
+        else if (mod == 2)
+            dword(static_cast<uint32_t>(m.disp));
+    }
+
+    void branch(std::initializer_list<uint8_t> op, int label)
+    {
+        for (uint8_t b : op)
+            byte(b);
+        labelFixups.push_back({code.size(), label});
+        dword(0);
+    }
+};
+
+bool isFloating(IrType t)
+{
+    return t == IrType::Float || t == IrType::Double;
+}
+
+bool isComparison(IrOp op)
+{
+    return op >= IrOp::Eq && op <= IrOp::Ge;
+}
+
+Cond intCondition(IrOp op)
+{
+    switch (op)
+    {
+    case IrOp::Eq: return CC_E;
+    case IrOp::Ne: return CC_NE;
+    case IrOp::Lt: return CC_L;
+    case IrOp::Le: return CC_LE;
+    case IrOp::Gt: return CC_G;
+    default: return CC_GE;
+    }
+}
+
+constexpr uint32_t OUTPUT_BUFFER = 1 << 16;
+constexpr uint32_t BIG_LIMBS = 48;    // m * 5^1074 needs 40 64-bit limbs
+constexpr uint32_t DIGIT_BUFFER = 800; // ... and 767 decimal digits
+
+// Where a virtual register lives for its whole lifetime
+struct Location
+{
+    int reg = -1;  // Machine register, or -1 for a stack slot
+    int slot = -1; // [rsp + 8 * slot]
+};
+
+class Lowering
+{
+public:
+    Lowering(const IrProgram &program, NativeBackend::Stats &counters) : prog(program), counters(counters) {}
+
+    std::vector<uint8_t> run();
+
+private:
+    const IrProgram &prog;
+    NativeBackend::Stats &counters;
+    Assembler as;
+    std::vector<Location> locations;
+    std::vector<uint32_t> uses;
+    std::vector<uint32_t> defs;
+    int slots = 0;
+    std::vector<int> blockLabels;
+    std::unordered_map<std::string, int> strings; // Decoded text -> symbol
+    std::unordered_map<uint64_t, int> floatConstants;
+
+    // Runtime routines and their data
+    int exitLabel = 0, flushLabel = 0, writeAllLabel = 0, putBytesLabel = 0;
+    int printIntLabel = 0, printCharLabel = 0, printStringLabel = 0, printDoubleLabel = 0, mulSmallLabel = 0;
+    int outBuffer = 0, outUsed = 0, numBuffer = 0, bigNumber = 0, digitBuffer = 0, formatBuffer = 0;
+    int powersOf5 = 0, floatSign = 0, doubleSign = 0;
+
+    void allocateRegisters();
+    void lowerBlock(uint32_t b);
+    void lowerInstruction(const IrInstruction &instr);
+    void lowerTerminator(uint32_t b, const IrInstruction *fused);
+    void branchTo(Cond cc, uint32_t whenTrue, uint32_t whenFalse, uint32_t next);
+
+    int gpr(uint32_t reg, int scratch);
+    int gprDst(uint32_t reg, int scratch);
+    void gprDone(uint32_t reg, int machine);
+    int xmm(uint32_t reg, int scratch);
+    int xmmDst(uint32_t reg, int scratch);
+    void xmmDone(uint32_t reg, int machine);
+    Mem slotOf(uint32_t reg) const { return at(RSP, 8 * locations[reg].slot); }
+    bool wide(uint32_t reg) const { return prog.registers[reg].type == IrType::String; }
+    bool isDouble(uint32_t reg) const { return prog.registers[reg].type == IrType::Double; }
+
+    void loadConstant(uint32_t dst, const IrConstant &c);
+    void copy(uint32_t dst, uint32_t src);
+    void convert(const IrInstruction &instr);
+    void integerArithmetic(const IrInstruction &instr);
+    void division(const IrInstruction &instr);
+    void floatArithmetic(const IrInstruction &instr);
+    void negate(const IrInstruction &instr);
+    void compare(const IrInstruction &instr);
+    void print(const IrInstruction &instr);
+    int stringSymbol(const std::string &text);
+    int floatSymbol(double value, bool dbl);
+
+    void emitRuntime();
+    void emitOutput();
+    void emitPrintDouble();
+};
+
+std::vector<uint8_t> Lowering::run()
+{
+    exitLabel = as.newLabel();
+    flushLabel = as.newLabel();
+    writeAllLabel = as.newLabel();
+    putBytesLabel = as.newLabel();
+    printIntLabel = as.newLabel();
+    printCharLabel = as.newLabel();
+    printStringLabel = as.newLabel();
+    printDoubleLabel = as.newLabel();
+    mulSmallLabel = as.newLabel();
+    outBuffer = as.bssSymbol(OUTPUT_BUFFER, 64);
+    outUsed = as.bssSymbol(8, 8);
+    numBuffer = as.bssSymbol(32, 8);
+    bigNumber = as.bssSymbol(8 * BIG_LIMBS, 8);
+    digitBuffer = as.bssSymbol(DIGIT_BUFFER, 8);
+    formatBuffer = as.bssSymbol(32, 8);
+    uint64_t powers[28] = {1};
+    for (int i = 1; i < 28; i++)
+        powers[i] = powers[i - 1] * 5;
+    powersOf5 = as.rodataSymbol(powers, sizeof(powers), 8);
+    uint32_t floatMask = 0x80000000u;
+    uint64_t doubleMask = 0x8000000000000000ull;
+    floatSign = as.rodataSymbol(&floatMask, sizeof(floatMask), 4);
+    doubleSign = as.rodataSymbol(&doubleMask, sizeof(doubleMask), 8);
+
+    allocateRegisters();
+
+    // _start: the stack pointer arrives 16-byte aligned
+    int frame = (slots * 8 + 15) / 16 * 16;
+    if (frame > 0)
+        as.aluImm(SUB, true, RSP, frame);
+    for (size_t b = 0; b < prog.blocks.size(); b++)
+        blockLabels.push_back(as.newLabel());
+    for (uint32_t b = 0; b < prog.blocks.size(); b++)
+        lowerBlock(b);
+
+    as.bind(exitLabel);
+    as.call(flushLabel);
+    as.movImm(RAX, 231); // exit_group
+    as.alu(XOR, false, RDI, RDI);
+    as.syscall();
+    emitRuntime();
+    counters.codeBytes = as.code.size();
+
+    // One read+execute segment for headers, code and constants, and one
+    // read+write segment for the zero-filled buffers
+    constexpr uint64_t base = 0x400000;
+    constexpr uint64_t headers = 64 + 2 * 56;
+    uint64_t rodataOffset = (headers + as.code.size() + 15) / 16 * 16;
+    uint64_t fileSize = rodataOffset + as.rodata.size();
+    uint64_t bssAddress = (base + fileSize + 0xFFF) / 0x1000 * 0x1000;
+    as.link(base + headers, base + rodataOffset, bssAddress);
+
+    std::vector<uint8_t> image;
+    image.reserve(fileSize);
+    auto put = [&](uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; i++)
+            image.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    };
+    const uint8_t ident[16] = {0x7F, 'E', 'L', 'F', 2, 1, 1}; // 64-bit, little endian, version 1
+    image.insert(image.end(), ident, ident + 16);
+    put(2, 2);               // e_type: executable
+    put(0x3E, 2);            // e_machine: x86-64
+    put(1, 4);               // e_version
+    put(base + headers, 8);  // e_entry
+    put(64, 8);              // e_phoff
+    put(0, 8);               // e_shoff
+    put(0, 4);               // e_flags
+    put(64, 2);              // e_ehsize
+    put(56, 2);              // e_phentsize
+    put(2, 2);               // e_phnum
+    put(0, 2);               // e_shentsize
+    put(0, 2);               // e_shnum
+    put(0, 2);               // e_shstrndx
+    auto segment = [&](uint32_t flags, uint64_t address, uint64_t fileBytes, uint64_t memoryBytes)
+    {
+        put(1, 4); // PT_LOAD
+        put(flags, 4);
+        put(0, 8); // p_offset
+        put(address, 8);
+        put(address, 8);
+        put(fileBytes, 8);
+        put(memoryBytes, 8);
+        put(0x1000, 8);
+    };
+    segment(5, base, fileSize, fileSize);            // R+X
+    segment(6, bssAddress, 0, as.bssSize);           // R+W
+    image.insert(image.end(), as.code.begin(), as.code.end());
+    image.resize(rodataOffset, 0);
+    image.insert(image.end(), as.rodata.begin(), as.rodata.end());
+    return image;
+}
+
+// Linear scan over live intervals. Instructions are numbered in block
+// order; a register used outside the block that defines it is live over
+// whole blocks as found by a liveness pass, and its interval is widened
+// to cover them. The interval that ends last is the one spilled.
+void Lowering::allocateRegisters()
+{
+    constexpr uint32_t NONE = UINT32_MAX;
+    size_t count = prog.registers.size();
+    size_t blockCount = prog.blocks.size();
+    std::vector<uint32_t> first(count, NONE), last(count, 0), definedIn(count, NONE);
+    std::vector<bool> global(count, false);
+    std::vector<uint32_t> blockStart(blockCount), blockEnd(blockCount);
+    uses.assign(count, 0);
+    defs.assign(count, 0);
+
+    uint32_t pos = 0;
+    uint32_t b = 0;
+    auto touch = [&](uint32_t reg)
+    {
+        first[reg] = std::min(first[reg], pos);
+        last[reg] = std::max(last[reg], pos);
+    };
+    // A use not preceded by a definition in the same block reads a value
+    // from another block
+    auto use = [&](uint32_t reg)
+    {
+        touch(reg);
+        uses[reg]++;
+        if (definedIn[reg] != b)
+            global[reg] = true;
+    };
+    for (b = 0; b < blockCount; b++)
+    {
+        const IrBlock &block = prog.blocks[b];
+        blockStart[b] = pos;
+        for (const IrInstruction &instr : block.code)
+        {
+            forEachOperand(instr, use);
+            if (instr.dst != NO_REGISTER)
+            {
+                touch(instr.dst);
+                defs[instr.dst]++;
+                if (definedIn[instr.dst] != NONE && definedIn[instr.dst] != b)
+                    global[instr.dst] = true;
+                definedIn[instr.dst] = b;
+            }
+            pos++;
+        }
+        if (block.end == IrTerminator::Branch || block.end == IrTerminator::Switch)
+            use(block.condition);
+        blockEnd[b] = pos++;
+    }
+
+    // Liveness of the cross-block registers, as bit sets per block
+    std::vector<uint32_t> globals;
+    std::vector<uint32_t> globalIndex(count, NONE);
+    for (uint32_t r = 0; r < count; r++)
+    {
+        if (global[r] && first[r] != NONE)
+        {
+            globalIndex[r] = static_cast<uint32_t>(globals.size());
+            globals.push_back(r);
+        }
+    }
+    if (!globals.empty())
+    {
+        size_t words = (globals.size() + 63) / 64;
+        std::vector<uint64_t> useSet(blockCount * words, 0), defSet(blockCount * words, 0);
+        std::vector<uint64_t> liveIn(blockCount * words, 0), liveOut(blockCount * words, 0);
+        auto has = [&](const std::vector<uint64_t> &set, uint32_t block, uint32_t g)
+        {
+            return (set[block * words + g / 64] >> (g % 64)) & 1;
+        };
+        auto add = [&](std::vector<uint64_t> &set, uint32_t block, uint32_t g)
+        {
+            set[block * words + g / 64] |= uint64_t(1) << (g % 64);
+        };
+        for (uint32_t blk = 0; blk < blockCount; blk++)
+        {
+            const IrBlock &block = prog.blocks[blk];
+            auto read = [&](uint32_t reg)
+            {
+                uint32_t g = globalIndex[reg];
+                if (g != NONE && !has(defSet, blk, g))
+                    add(useSet, blk, g);
+            };
+            for (const IrInstruction &instr : block.code)
+            {
+                forEachOperand(instr, read);
+                if (instr.dst != NO_REGISTER && globalIndex[instr.dst] != NONE)
+                    add(defSet, blk, globalIndex[instr.dst]);
+            }
+            if (block.end == IrTerminator::Branch || block.end == IrTerminator::Switch)
+                read(block.condition);
+        }
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (uint32_t blk = static_cast<uint32_t>(blockCount); blk-- > 0;)
+            {
+                uint64_t *out = &liveOut[blk * words];
+                for (uint32_t succ : prog.blocks[blk].successors)
+                {
+                    for (size_t w = 0; w < words; w++)
+                        out[w] |= liveIn[succ * words + w];
+                }
+                for (size_t w = 0; w < words; w++)
+                {
+                    uint64_t in = useSet[blk * words + w] | (out[w] & ~defSet[blk * words + w]);
+                    if (in != liveIn[blk * words + w])
+                    {
+                        liveIn[blk * words + w] = in;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        for (uint32_t blk = 0; blk < blockCount; blk++)
+        {
+            for (uint32_t g = 0; g < globals.size(); g++)
+            {
+                uint32_t reg = globals[g];
+                if (has(liveIn, blk, g))
+                    first[reg] = std::min(first[reg], blockStart[blk]);
+                if (has(liveOut, blk, g))
+                    last[reg] = std::max(last[reg], blockEnd[blk]);
+            }
+        }
+    }
+
+    std::vector<uint32_t> order;
+    for (uint32_t r = 0; r < count; r++)
+    {
+        if (first[r] != NONE)
+            order.push_back(r);
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y)
+    {
+        return first[x] != first[y] ? first[x] < first[y] : x < y;
+    });
+
+    locations.assign(count, Location());
+    std::vector<uint32_t> active[2]; // GPR and XMM intervals holding a register
+    std::vector<int> freeRegs[2] = {
+        std::vector<int>(std::rbegin(allocatableGprs), std::rend(allocatableGprs)),
+        std::vector<int>(std::rbegin(allocatableXmms), std::rend(allocatableXmms))
+    };
+    for (uint32_t reg : order)
+    {
+        int cls = isFloating(prog.registers[reg].type) ? 1 : 0;
+        std::vector<uint32_t> &live = active[cls];
+        for (size_t i = 0; i < live.size();)
+        {
+            if (last[live[i]] < first[reg])
+            {
+                freeRegs[cls].push_back(locations[live[i]].reg);
+                live[i] = live.back();
+                live.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+        if (!freeRegs[cls].empty())
+        {
+            locations[reg].reg = freeRegs[cls].back();
+            freeRegs[cls].pop_back();
+            live.push_back(reg);
+            continue;
+        }
+        auto victim = std::max_element(live.begin(), live.end(), [&](uint32_t x, uint32_t y)
+        {
+            return last[x] < last[y];
+        });
+        if (last[*victim] > last[reg])
+        {
+            locations[reg].reg = locations[*victim].reg;
+            locations[*victim] = {-1, slots++};
+            *victim = reg;
+        }
+        else
+        {
+            locations[reg] = {-1, slots++};
+        }
+    }
+    counters.spilledRegisters = slots;
+    counters.allocatedRegisters = static_cast<int>(order.size()) - slots;
+}
+
+void Lowering::lowerBlock(uint32_t b)
+{
+    const IrBlock &block = prog.blocks[b];
+    as.bind(blockLabels[b]);
+
+    // An integer comparison that only feeds the branch becomes cmp + jcc
+    const IrInstruction *fused = nullptr;
+    if (block.end == IrTerminator::Branch && !block.code.empty())
+    {
+        const IrInstruction &lastInstr = block.code.back();
+        if (isComparison(lastInstr.op) && !isFloating(lastInstr.type) && lastInstr.dst == block.condition &&
+            uses[lastInstr.dst] == 1 && defs[lastInstr.dst] == 1)
+        {
+            fused = &lastInstr;
+        }
+    }
+    for (const IrInstruction &instr : block.code)
+    {
+        if (&instr != fused)
+            lowerInstruction(instr);
+    }
+    lowerTerminator(b, fused);
+}
+
+void Lowering::lowerTerminator(uint32_t b, const IrInstruction *fused)
+{
+    const IrBlock &block = prog.blocks[b];
+    uint32_t next = b + 1;
+    switch (block.end)
+    {
+    case IrTerminator::Jump:
+        if (block.target != next)
+            as.jmp(blockLabels[block.target]);
+        break;
+    case IrTerminator::Branch:
+        if (fused != nullptr)
+        {
+            int a = gpr(fused->a, RAX);
+            int c = gpr(fused->b, RCX);
+            as.alu(CMP, fused->type == IrType::String, a, c);
+            branchTo(intCondition(fused->op), block.target, block.otherwise, next);
+        }
+        else
+        {
+            int c = gpr(block.condition, RAX);
+            as.test(false, c, c);
+            branchTo(CC_NE, block.target, block.otherwise, next);
+        }
+        break;
+    case IrTerminator::Switch: {
+        int c = gpr(block.condition, RAX);
+        for (const IrCase &cs : block.cases)
+        {
+            as.aluImm(CMP, false, c, cs.value);
+            as.jcc(CC_E, blockLabels[cs.target]);
+        }
+        if (block.target != next)
+            as.jmp(blockLabels[block.target]);
+        break;
+    }
+    case IrTerminator::Return:
+        if (next != prog.blocks.size())
+            as.jmp(exitLabel);
+        break;
+    }
+}
+
+void Lowering::branchTo(Cond cc, uint32_t whenTrue, uint32_t whenFalse, uint32_t next)
+{
+    if (whenTrue == next)
+    {
+        if (whenFalse != next)
+            as.jcc(invert(cc), blockLabels[whenFalse]);
+        return;
+    }
+    as.jcc(cc, blockLabels[whenTrue]);
+    if (whenFalse != next)
+        as.jmp(blockLabels[whenFalse]);
+}
+
+// Machine register holding 'reg', loading it into 'scratch' if it is spilled
+int Lowering::gpr(uint32_t reg, int scratch)
+{
+    const Location &loc = locations[reg];
+    if (loc.reg >= 0)
+        return loc.reg;
+    as.load(wide(reg), scratch, slotOf(reg));
+    return scratch;
+}
+
+// Machine register to compute 'reg' in; gprDone() puts it in place
+int Lowering::gprDst(uint32_t reg, int scratch)
+{
+    return locations[reg].reg >= 0 ? locations[reg].reg : scratch;
+}
+
+void Lowering::gprDone(uint32_t reg, int machine)
+{
+    const Location &loc = locations[reg];
+    if (loc.reg < 0)
+        as.store(wide(reg), slotOf(reg), machine);
+    else if (loc.reg != machine)
+        as.mov(wide(reg), loc.reg, machine);
+}
+
+int Lowering::xmm(uint32_t reg, int scratch)
+{
+    const Location &loc = locations[reg];
+    if (loc.reg >= 0)
+        return loc.reg;
+    as.sseLoad(isDouble(reg), scratch, slotOf(reg));
+    return scratch;
+}
+
+int Lowering::xmmDst(uint32_t reg, int scratch)
+{
+    return locations[reg].reg >= 0 ? locations[reg].reg : scratch;
+}
+
+void Lowering::xmmDone(uint32_t reg, int machine)
+{
+    const Location &loc = locations[reg];
+    if (loc.reg < 0)
+        as.sseStore(isDouble(reg), slotOf(reg), machine);
+    else if (loc.reg != machine)
+        as.sse(MOVS, isDouble(reg), loc.reg, machine);
+}
+
+void Lowering::lowerInstruction(const IrInstruction &instr)
+{
+    switch (instr.op)
+    {
+    case IrOp::Const:
+        loadConstant(instr.dst, prog.constants[instr.a]);
+        break;
+    case IrOp::Copy:
+        copy(instr.dst, instr.a);
+        break;
+    case IrOp::Convert:
+        convert(instr);
+        break;
+    case IrOp::Add:
+    case IrOp::Sub:
+    case IrOp::Mul:
+    case IrOp::Div:
+        if (isFloating(instr.type))
+            floatArithmetic(instr);
+        else if (instr.op == IrOp::Div)
+            division(instr);
+        else
+            integerArithmetic(instr);
+        break;
+    case IrOp::Mod:
+        division(instr);
+        break;
+    case IrOp::And:
+    case IrOp::Or:
+        integerArithmetic(instr);
+        break;
+    case IrOp::Neg:
+    case IrOp::Not:
+        negate(instr);
+        break;
+    case IrOp::Eq:
+    case IrOp::Ne:
+    case IrOp::Lt:
+    case IrOp::Le:
+    case IrOp::Gt:
+    case IrOp::Ge:
+        compare(instr);
+        break;
+    case IrOp::Print:
+        print(instr);
+        break;
+    }
+}
+
+void Lowering::loadConstant(uint32_t dst, const IrConstant &c)
+{
+    switch (c.type)
+    {
+    case IrType::Int:
+    case IrType::Bool:
+    case IrType::Char: {
+        int d = gprDst(dst, RAX);
+        if (c.i == 0)
+            as.alu(XOR, false, d, d);
+        else
+            as.movImm(d, c.i);
+        gprDone(dst, d);
+        break;
+    }
+    case IrType::String: {
+        int d = gprDst(dst, RAX);
+        as.lea(d, sym(stringSymbol(c.text)));
+        gprDone(dst, d);
+        break;
+    }
+    case IrType::Float:
+    case IrType::Double: {
+        bool dbl = c.type == IrType::Double;
+        int d = xmmDst(dst, XMM0);
+        float f = static_cast<float>(c.d);
+        bool zero = dbl ? (c.d == 0 && !std::signbit(c.d)) : (f == 0 && !std::signbit(f));
+        if (zero)
+            as.xorps(d, d);
+        else
+            as.sseLoad(dbl, d, sym(floatSymbol(c.d, dbl)));
+        xmmDone(dst, d);
+        break;
+    }
+    }
+}
+
+void Lowering::copy(uint32_t dst, uint32_t src)
+{
+    if (isFloating(prog.registers[dst].type))
+    {
+        int d = xmmDst(dst, XMM0);
+        int s = xmm(src, d);
+        if (s != d)
+            as.sse(MOVS, isDouble(dst), d, s);
+        xmmDone(dst, d);
+        return;
+    }
+    int d = gprDst(dst, RAX);
+    int s = gpr(src, d);
+    if (s != d)
+        as.mov(wide(dst), d, s);
+    gprDone(dst, d);
+}
+
+// The same conversions g++ generates for the C++ backend's static_casts
+void Lowering::convert(const IrInstruction &instr)
+{
+    IrType from = prog.registers[instr.a].type;
+    IrType to = instr.type;
+    bool fromDouble = from == IrType::Double;
+    if (isFloating(from) && isFloating(to))
+    {
+        int d = xmmDst(instr.dst, XMM0);
+        as.sse(CVTS, fromDouble, d, xmm(instr.a, XMM1));
+        xmmDone(instr.dst, d);
+    }
+    else if (isFloating(to))
+    {
+        int s = gpr(instr.a, RAX);
+        int d = xmmDst(instr.dst, XMM0);
+        as.xorps(d, d); // cvtsi2ss only writes the low lane
+        as.cvtsi2s(to == IrType::Double, d, s);
+        xmmDone(instr.dst, d);
+    }
+    else if (isFloating(from))
+    {
+        int s = xmm(instr.a, XMM0);
+        if (to == IrType::Bool)
+        {
+            // NaN is unordered, and converts to true
+            as.xorps(XMM1, XMM1);
+            as.ucomis(fromDouble, s, XMM1);
+            as.setcc(CC_NE, RAX);
+            as.setcc(CC_P, RCX);
+            as.alu(OR, false, RAX, RCX);
+            int d = gprDst(instr.dst, RAX);
+            as.movzxByte(d, RAX);
+            gprDone(instr.dst, d);
+            return;
+        }
+        as.cvtts2si(fromDouble, RAX, s);
+        if (to == IrType::Char)
+            as.movsxByte(RAX, RAX);
+        gprDone(instr.dst, RAX);
+    }
+    else
+    {
+        int s = gpr(instr.a, RAX);
+        int d = gprDst(instr.dst, RAX);
+        if (to == IrType::Bool)
+        {
+            as.test(false, s, s);
+            as.setcc(CC_NE, RAX);
+            as.movzxByte(d, RAX);
+        }
+        else if (to == IrType::Char)
+        {
+            as.movsxByte(d, s);
+        }
+        else if (s != d)
+        {
+            as.mov(false, d, s);
+        }
+        gprDone(instr.dst, d);
+    }
+}
+
+// dst = a op b, computed in dst's register unless that register holds b
+void Lowering::integerArithmetic(const IrInstruction &instr)
+{
+    int b = gpr(instr.b, RCX);
+    int d = gprDst(instr.dst, RAX);
+    if (d == b && instr.a != instr.b)
+        d = RAX;
+    int a = gpr(instr.a, d);
+    if (a != d)
+        as.mov(false, d, a);
+    switch (instr.op)
+    {
+    case IrOp::Add: as.alu(ADD, false, d, b); break;
+    case IrOp::Sub: as.alu(SUB, false, d, b); break;
+    case IrOp::Mul: as.imul(false, d, b); break;
+    case IrOp::And: as.alu(AND, false, d, b); break;
+    default: as.alu(OR, false, d, b); break;
+    }
+    gprDone(instr.dst, d);
+}
+
+// idiv traps on a zero divisor and on INT_MIN / -1, as the C++ build does
+void Lowering::division(const IrInstruction &instr)
+{
+    int b = gpr(instr.b, RCX);
+    int a = gpr(instr.a, RAX);
+    if (a != RAX)
+        as.mov(false, RAX, a);
+    as.cdq();
+    as.group(IDIV, false, b);
+    gprDone(instr.dst, instr.op == IrOp::Div ? RAX : RDX);
+}
+
+void Lowering::floatArithmetic(const IrInstruction &instr)
+{
+    bool dbl = instr.type == IrType::Double;
+    int b = xmm(instr.b, XMM1);
+    int d = xmmDst(instr.dst, XMM0);
+    if (d == b && instr.a != instr.b)
+        d = XMM0;
+    int a = xmm(instr.a, d);
+    if (a != d)
+        as.sse(MOVS, dbl, d, a);
+    switch (instr.op)
+    {
+    case IrOp::Add: as.sse(ADDS, dbl, d, b); break;
+    case IrOp::Sub: as.sse(SUBS, dbl, d, b); break;
+    case IrOp::Mul: as.sse(MULS, dbl, d, b); break;
+    default: as.sse(DIVS, dbl, d, b); break;
+    }
+    xmmDone(instr.dst, d);
+}
+
+void Lowering::negate(const IrInstruction &instr)
+{
+    if (isFloating(instr.type))
+    {
+        bool dbl = instr.type == IrType::Double;
+        int d = xmmDst(instr.dst, XMM0);
+        int a = xmm(instr.a, d);
+        if (a != d)
+            as.sse(MOVS, dbl, d, a);
+        as.sseLoad(dbl, XMM1, sym(dbl ? doubleSign : floatSign));
+        as.xorps(d, XMM1);
+        xmmDone(instr.dst, d);
+        return;
+    }
+    int d = gprDst(instr.dst, RAX);
+    int a = gpr(instr.a, d);
+    if (a != d)
+        as.mov(false, d, a);
+    if (instr.op == IrOp::Not)
+        as.aluImm(XOR, false, d, 1);
+    else
+        as.group(NEG, false, d);
+    gprDone(instr.dst, d);
+}
+
+// Strings are compared by address: equal literals share one copy
+void Lowering::compare(const IrInstruction &instr)
+{
+    if (isFloating(instr.type))
+    {
+        bool dbl = instr.type == IrType::Double;
+        int a = xmm(instr.a, XMM0);
+        int b = xmm(instr.b, XMM1);
+        // Every comparison with NaN is false, except !=
+        switch (instr.op)
+        {
+        case IrOp::Eq:
+            as.ucomis(dbl, a, b);
+            as.setcc(CC_E, RAX);
+            as.setcc(CC_NP, RCX);
+            as.alu(AND, false, RAX, RCX);
+            break;
+        case IrOp::Ne:
+            as.ucomis(dbl, a, b);
+            as.setcc(CC_NE, RAX);
+            as.setcc(CC_P, RCX);
+            as.alu(OR, false, RAX, RCX);
+            break;
+        case IrOp::Lt:
+            as.ucomis(dbl, b, a);
+            as.setcc(CC_A, RAX);
+            break;
+        case IrOp::Le:
+            as.ucomis(dbl, b, a);
+            as.setcc(CC_AE, RAX);
+            break;
+        case IrOp::Gt:
+            as.ucomis(dbl, a, b);
+            as.setcc(CC_A, RAX);
+            break;
+        default:
+            as.ucomis(dbl, a, b);
+            as.setcc(CC_AE, RAX);
+            break;
+        }
+    }
+    else
+    {
+        int a = gpr(instr.a, RAX);
+        int b = gpr(instr.b, RCX);
+        as.alu(CMP, instr.type == IrType::String, a, b);
+        as.setcc(intCondition(instr.op), RAX);
+    }
+    int d = gprDst(instr.dst, RAX);
+    as.movzxByte(d, RAX);
+    gprDone(instr.dst, d);
+}
+
+void Lowering::print(const IrInstruction &instr)
+{
+    switch (instr.type)
+    {
+    case IrType::Int:
+    case IrType::Bool:
+    case IrType::Char: {
+        int a = gpr(instr.a, RDI);
+        if (a != RDI)
+            as.mov(false, RDI, a);
+        as.call(instr.type == IrType::Char ? printCharLabel : printIntLabel);
+        break;
+    }
+    case IrType::String: {
+        int a = gpr(instr.a, RDI);
+        if (a != RDI)
+            as.mov(true, RDI, a);
+        as.call(printStringLabel);
+        break;
+    }
+    case IrType::Float:
+        // Streams print a float as the double it converts to
+        as.sse(CVTS, false, XMM0, xmm(instr.a, XMM0));
+        as.call(printDoubleLabel);
+        break;
+    case IrType::Double: {
+        int a = xmm(instr.a, XMM0);
+        if (a != XMM0)
+            as.sse(MOVS, true, XMM0, a);
+        as.call(printDoubleLabel);
+        break;
+    }
+    }
+}
+
+// A string literal is its length, its bytes and a newline for print.
+// Each distinct text is stored once.
+int Lowering::stringSymbol(const std::string &text)
+{
+    std::string bytes = decodeEscapes(text);
+    auto found = strings.find(bytes);
+    if (found != strings.end())
+        return found->second;
+    std::vector<uint8_t> data(8 + bytes.size() + 1);
+    uint64_t length = bytes.size();
+    std::memcpy(data.data(), &length, 8);
+    std::memcpy(data.data() + 8, bytes.data(), bytes.size());
+    data.back() = '\n';
+    int symbol = as.rodataSymbol(data.data(), data.size(), 8);
+    strings.emplace(std::move(bytes), symbol);
+    return symbol;
+}
+
+int Lowering::floatSymbol(double value, bool dbl)
+{
+    uint64_t bits = 0;
+    if (dbl)
+    {
+        std::memcpy(&bits, &value, 8);
+    }
+    else
+    {
+        float f = static_cast<float>(value);
+        uint32_t single;
+        std::memcpy(&single, &f, 4);
+        bits = single | (uint64_t(1) << 32); // Keeps floats apart from doubles in the map
+    }
+    auto found = floatConstants.find(bits);
+    if (found != floatConstants.end())
+        return found->second;
+    int symbol = dbl ? as.rodataSymbol(&bits, 8, 8) : as.rodataSymbol(&bits, 4, 4);
+    floatConstants.emplace(bits, symbol);
+    return symbol;
+}
+
+void Lowering::emitRuntime()
+{
+    emitOutput();
+    emitPrintDouble();
+}
+
+// Output buffering and the integer, char and string prints. Each print
+// routine also writes the newline.
+void Lowering::emitOutput()
+{
+    // flush: write out the buffer and empty it
+    as.bind(flushLabel);
+    as.lea(RSI, sym(outBuffer));
+    as.load(true, RDX, sym(outUsed));
+    as.storeImm(true, sym(outUsed), 0);
+
+    // writeAll(rsi = bytes, rdx = length): write(1, ...) until done or failed
+    as.bind(writeAllLabel);
+    int writeLoop = as.newLabel(), writeDone = as.newLabel();
+    as.bind(writeLoop);
+    as.test(true, RDX, RDX);
+    as.jcc(CC_E, writeDone);
+    as.movImm(RAX, 1); // write
+    as.movImm(RDI, 1); // stdout
+    as.syscall();
+    as.test(true, RAX, RAX);
+    as.jcc(CC_LE, writeDone);
+    as.alu(ADD, true, RSI, RAX);
+    as.alu(SUB, true, RDX, RAX);
+    as.jmp(writeLoop);
+    as.bind(writeDone);
+    as.ret();
+
+    // putBytes(rsi = bytes, rdx = length): append to the buffer, flushing
+    // first if it would overflow; text larger than the buffer goes straight out
+    as.bind(putBytesLabel);
+    int copy = as.newLabel();
+    as.load(true, RAX, sym(outUsed));
+    as.lea(RCX, at(RAX, RDX, 1));
+    as.aluImm(CMP, true, RCX, OUTPUT_BUFFER);
+    as.jcc(CC_BE, copy);
+    as.push(RSI);
+    as.push(RDX);
+    as.call(flushLabel);
+    as.pop(RDX);
+    as.pop(RSI);
+    as.alu(XOR, false, RAX, RAX);
+    as.aluImm(CMP, true, RDX, OUTPUT_BUFFER);
+    as.jcc(CC_A, writeAllLabel);
+    as.bind(copy);
+    as.lea(RDI, sym(outBuffer));
+    as.alu(ADD, true, RDI, RAX);
+    as.alu(ADD, true, RAX, RDX);
+    as.store(true, sym(outUsed), RAX);
+    as.mov(true, RCX, RDX);
+    as.repMovsb();
+    as.ret();
+
+    // printInt(edi): decimal digits written backwards into numBuffer
+    as.bind(printIntLabel);
+    int positive = as.newLabel(), digit = as.newLabel(), unsignedDone = as.newLabel();
+    as.movsxd(RAX, RDI);
+    as.lea(RSI, sym(numBuffer, 24));
+    as.storeByteImm(at(RSI), '\n');
+    as.mov(true, R8, RAX);
+    as.test(true, RAX, RAX);
+    as.jcc(CC_NS, positive);
+    as.group(NEG, true, RAX);
+    as.bind(positive);
+    as.movImm(RCX, 10);
+    as.bind(digit);
+    as.alu(XOR, false, RDX, RDX);
+    as.group(DIV, true, RCX);
+    as.aluImm(ADD, false, RDX, '0');
+    as.aluImm(SUB, true, RSI, 1);
+    as.storeByte(at(RSI), RDX);
+    as.test(true, RAX, RAX);
+    as.jcc(CC_NE, digit);
+    as.test(true, R8, R8);
+    as.jcc(CC_NS, unsignedDone);
+    as.aluImm(SUB, true, RSI, 1);
+    as.storeByteImm(at(RSI), '-');
+    as.bind(unsignedDone);
+    as.lea(RDX, sym(numBuffer, 25));
+    as.alu(SUB, true, RDX, RSI);
+    as.jmp(putBytesLabel);
+
+    // printChar(dil)
+    as.bind(printCharLabel);
+    as.lea(RSI, sym(numBuffer));
+    as.storeByte(at(RSI), RDI);
+    as.storeByteImm(at(RSI, 1), '\n');
+    as.movImm(RDX, 2);
+    as.jmp(putBytesLabel);
+
+    // printString(rdi = literal): length, then the bytes and their newline
+    as.bind(printStringLabel);
+    as.load(true, RDX, at(RDI));
+    as.aluImm(ADD, true, RDX, 1);
+    as.lea(RSI, at(RDI, 8));
+    as.jmp(putBytesLabel);
+
+    // mulSmall(r9 = factor): bigNumber (rbx, r12 limbs) *= r9
+    as.bind(mulSmallLabel);
+    int mulLoop = as.newLabel(), mulDone = as.newLabel();
+    as.alu(XOR, false, RCX, RCX);
+    as.alu(XOR, false, R10, R10);
+    as.bind(mulLoop);
+    as.load(true, RAX, at(RBX, RCX, 8));
+    as.group(MUL, true, R9);
+    as.alu(ADD, true, RAX, R10);
+    as.aluImm(ADC, true, RDX, 0);
+    as.store(true, at(RBX, RCX, 8), RAX);
+    as.mov(true, R10, RDX);
+    as.aluImm(ADD, true, RCX, 1);
+    as.alu(CMP, true, RCX, R12);
+    as.jcc(CC_B, mulLoop);
+    as.test(true, R10, R10);
+    as.jcc(CC_E, mulDone);
+    as.store(true, at(RBX, R12, 8), R10);
+    as.aluImm(ADD, true, R12, 1);
+    as.bind(mulDone);
+    as.ret();
+}
+
+// printDouble(xmm0): %g with 6 significant digits, exactly as printf
+// rounds it. The value m * 2^e is expanded into an exact decimal integer
+// (m * 2^e, or m * 5^-e with the point moved -e places), so the digits
+// and the round-half-to-even decision are exact for every double.
+void Lowering::emitPrintDouble()
+{
+    auto label = [&]() { return as.newLabel(); };
+    int positive = label(), finite = label(), nan = label(), output = label();
+    int subnormal = label(), haveExponent = label(), nonzero = label();
+    int negativeExponent = label(), pow2Loop = label(), pow2Tail = label(), pow5Loop = label(), pow5Tail = label();
+    int toDecimal = label(), chunkLoop = label(), divideLoop = label(), trim = label(), trimmed = label();
+    int digitLoop = label(), topChunk = label(), chunkDone = label();
+    int significandLoop = label(), significandStore = label(), sticky = label(), tie = label();
+    int roundUp = label(), carry = label(), bump = label(), rounded = label(), strip = label(), stripped = label();
+    int scientific = label(), small = label(), integerPart = label(), fraction = label(), newline = label();
+    int zeros = label(), smallDigits = label(), smallLoop = label(), mantissaDigits = label(), exponent = label();
+    int exponentSign = label(), twoDigits = label();
+
+    as.bind(printDoubleLabel);
+    for (int r : {RBX, R12, R13, R14, R15})
+        as.push(r);
+    as.movqFromXmm(RAX, XMM0);
+    as.lea(R15, sym(formatBuffer)); // r15: output cursor
+    as.test(true, RAX, RAX);
+    as.jcc(CC_NS, positive);
+    as.storeByteImm(at(R15), '-');
+    as.aluImm(ADD, true, R15, 1);
+    as.bind(positive);
+    as.mov(true, RCX, RAX);
+    as.shiftImm(SHL, true, RCX, 1);
+    as.shiftImm(SHR, true, RCX, 53); // biased exponent
+    as.movImm64(RDX, 0x000FFFFFFFFFFFFFull);
+    as.alu(AND, true, RDX, RAX);     // fraction
+    as.aluImm(CMP, false, RCX, 0x7FF);
+    as.jcc(CC_NE, finite);
+    as.test(true, RDX, RDX);
+    as.jcc(CC_NE, nan);
+    as.storeImm(false, at(R15), 0x0A666E69); // "inf\n"
+    as.aluImm(ADD, true, R15, 4);
+    as.jmp(output);
+    as.bind(nan);
+    as.storeImm(false, at(R15), 0x0A6E616E); // "nan\n"
+    as.aluImm(ADD, true, R15, 4);
+    as.jmp(output);
+
+    // rdx = m, ecx = e
+    as.bind(finite);
+    as.test(false, RCX, RCX);
+    as.jcc(CC_E, subnormal);
+    as.movImm64(RAX, uint64_t(1) << 52);
+    as.alu(OR, true, RDX, RAX);
+    as.aluImm(SUB, false, RCX, 1075);
+    as.jmp(haveExponent);
+    as.bind(subnormal);
+    as.movImm(RCX, -1074);
+    as.bind(haveExponent);
+    as.test(true, RDX, RDX);
+    as.jcc(CC_NE, nonzero);
+    as.storeWordImm(at(R15), 0x0A30); // "0\n"
+    as.aluImm(ADD, true, R15, 2);
+    as.jmp(output);
+
+    // rbx = limbs, r12 = limb count, r13 = decimal places
+    as.bind(nonzero);
+    as.lea(RBX, sym(bigNumber));
+    as.store(true, at(RBX), RDX);
+    as.movImm(R12, 1);
+    as.alu(XOR, false, R13, R13);
+    as.test(false, RCX, RCX);
+    as.jcc(CC_S, negativeExponent);
+    as.mov(false, R14, RCX);
+    as.bind(pow2Loop);
+    as.aluImm(CMP, false, R14, 32);
+    as.jcc(CC_B, pow2Tail);
+    as.movImm64(R9, uint64_t(1) << 32);
+    as.call(mulSmallLabel);
+    as.aluImm(SUB, false, R14, 32);
+    as.jmp(pow2Loop);
+    as.bind(pow2Tail);
+    as.mov(false, RCX, R14);
+    as.movImm(R9, 1);
+    as.shiftCl(SHL, true, R9);
+    as.call(mulSmallLabel);
+    as.jmp(toDecimal);
+
+    as.bind(negativeExponent);
+    as.group(NEG, false, RCX);
+    as.mov(false, R13, RCX);
+    as.mov(false, R14, RCX);
+    as.bind(pow5Loop);
+    as.aluImm(CMP, false, R14, 27);
+    as.jcc(CC_B, pow5Tail);
+    as.load(true, R9, sym(powersOf5, 27 * 8));
+    as.call(mulSmallLabel);
+    as.aluImm(SUB, false, R14, 27);
+    as.jmp(pow5Loop);
+    as.bind(pow5Tail);
+    as.lea(RAX, sym(powersOf5));
+    as.load(true, R9, at(RAX, R14, 8));
+    as.call(mulSmallLabel);
+
+    // Decimal digits, 19 at a time from the bottom, end at digitBuffer's end
+    as.bind(toDecimal);
+    as.lea(R14, sym(digitBuffer, DIGIT_BUFFER)); // r14: first digit so far
+    as.movImm64(R8, 10000000000000000000ull);
+    as.bind(chunkLoop);
+    as.lea(RSI, at(RBX, R12, 8));
+    as.alu(XOR, false, RDX, RDX);
+    as.bind(divideLoop);
+    as.aluImm(SUB, true, RSI, 8);
+    as.load(true, RAX, at(RSI));
+    as.group(DIV, true, R8);
+    as.store(true, at(RSI), RAX);
+    as.alu(CMP, true, RSI, RBX);
+    as.jcc(CC_A, divideLoop);
+    as.bind(trim);
+    as.test(true, R12, R12);
+    as.jcc(CC_E, trimmed);
+    as.load(true, RAX, at(RBX, R12, 8, -8));
+    as.test(true, RAX, RAX);
+    as.jcc(CC_NE, trimmed);
+    as.aluImm(SUB, true, R12, 1);
+    as.jmp(trim);
+    as.bind(trimmed);
+    as.mov(true, RAX, RDX);
+    as.movImm(R9, 19);
+    as.movImm(R10, 10);
+    as.bind(digitLoop);
+    as.alu(XOR, false, RDX, RDX);
+    as.group(DIV, true, R10);
+    as.aluImm(ADD, false, RDX, '0');
+    as.aluImm(SUB, true, R14, 1);
+    as.storeByte(at(R14), RDX);
+    as.aluImm(SUB, false, R9, 1);
+    as.test(true, R12, R12);
+    as.jcc(CC_E, topChunk);
+    as.test(false, R9, R9);
+    as.jcc(CC_NE, digitLoop);
+    as.jmp(chunkDone);
+    as.bind(topChunk); // No leading zeros on the most significant chunk
+    as.test(true, RAX, RAX);
+    as.jcc(CC_NE, digitLoop);
+    as.bind(chunkDone);
+    as.test(true, R12, R12);
+    as.jcc(CC_NE, chunkLoop);
+
+    // rsi = digit count, r12 = decimal exponent of the first digit
+    as.lea(RSI, sym(digitBuffer, DIGIT_BUFFER));
+    as.alu(SUB, true, RSI, R14);
+    as.mov(true, R12, RSI);
+    as.aluImm(SUB, true, R12, 1);
+    as.alu(SUB, true, R12, R13);
+
+    // rdi = the 6 significant digits, zero padded
+    as.lea(RDI, sym(numBuffer));
+    as.alu(XOR, false, RCX, RCX);
+    as.bind(significandLoop);
+    as.movImm(RAX, '0');
+    as.alu(CMP, true, RCX, RSI);
+    as.jcc(CC_AE, significandStore);
+    as.loadByte(RAX, at(R14, RCX, 1));
+    as.bind(significandStore);
+    as.storeByte(at(RDI, RCX, 1), RAX);
+    as.aluImm(ADD, true, RCX, 1);
+    as.aluImm(CMP, true, RCX, 6);
+    as.jcc(CC_B, significandLoop);
+
+    // Round half to even on the exact remaining digits
+    as.aluImm(CMP, true, RSI, 6);
+    as.jcc(CC_BE, rounded);
+    as.loadByte(RAX, at(R14, 6));
+    as.aluImm(CMP, false, RAX, '5');
+    as.jcc(CC_A, roundUp);
+    as.jcc(CC_B, rounded);
+    as.movImm(RCX, 7);
+    as.bind(sticky);
+    as.alu(CMP, true, RCX, RSI);
+    as.jcc(CC_AE, tie);
+    as.loadByte(RAX, at(R14, RCX, 1));
+    as.aluImm(CMP, false, RAX, '0');
+    as.jcc(CC_NE, roundUp);
+    as.aluImm(ADD, true, RCX, 1);
+    as.jmp(sticky);
+    as.bind(tie);
+    as.loadByte(RAX, at(RDI, 5));
+    as.aluImm(AND, false, RAX, 1); // '0' is even
+    as.jcc(CC_E, rounded);
+    as.bind(roundUp);
+    as.movImm(RCX, 5);
+    as.bind(carry);
+    as.loadByte(RAX, at(RDI, RCX, 1));
+    as.aluImm(CMP, false, RAX, '9');
+    as.jcc(CC_NE, bump);
+    as.storeByteImm(at(RDI, RCX, 1), '0');
+    as.aluImm(SUB, true, RCX, 1);
+    as.jcc(CC_NS, carry);
+    as.storeByteImm(at(RDI), '1'); // 999999.5 -> 100000, one place up
+    as.aluImm(ADD, true, R12, 1);
+    as.jmp(rounded);
+    as.bind(bump);
+    as.aluImm(ADD, false, RAX, 1);
+    as.storeByte(at(RDI, RCX, 1), RAX);
+    as.bind(rounded);
+
+    // rcx = significant digits without trailing zeros
+    as.movImm(RCX, 6);
+    as.bind(strip);
+    as.aluImm(CMP, false, RCX, 1);
+    as.jcc(CC_BE, stripped);
+    as.loadByte(RAX, at(RDI, RCX, 1, -1));
+    as.aluImm(CMP, false, RAX, '0');
+    as.jcc(CC_NE, stripped);
+    as.aluImm(SUB, false, RCX, 1);
+    as.jmp(strip);
+    as.bind(stripped);
+    as.aluImm(CMP, true, R12, -4);
+    as.jcc(CC_L, scientific);
+    as.aluImm(CMP, true, R12, 6);
+    as.jcc(CC_GE, scientific);
+    as.test(true, R12, R12);
+    as.jcc(CC_S, small);
+
+    // Fixed notation, exponent 0 to 5
+    as.alu(XOR, false, RDX, RDX);
+    as.bind(integerPart);
+    as.loadByte(RAX, at(RDI, RDX, 1));
+    as.storeByte(at(R15), RAX);
+    as.aluImm(ADD, true, R15, 1);
+    as.aluImm(ADD, true, RDX, 1);
+    as.alu(CMP, true, RDX, R12);
+    as.jcc(CC_LE, integerPart);
+    as.alu(CMP, true, RDX, RCX);
+    as.jcc(CC_AE, newline);
+    as.storeByteImm(at(R15), '.');
+    as.aluImm(ADD, true, R15, 1);
+    as.bind(fraction);
+    as.loadByte(RAX, at(RDI, RDX, 1));
+    as.storeByte(at(R15), RAX);
+    as.aluImm(ADD, true, R15, 1);
+    as.aluImm(ADD, true, RDX, 1);
+    as.alu(CMP, true, RDX, RCX);
+    as.jcc(CC_B, fraction);
+    as.jmp(newline);
+
+    // Fixed notation, exponent -1 to -4: "0.", zeros, digits
+    as.bind(small);
+    as.storeWordImm(at(R15), 0x2E30); // "0."
+    as.aluImm(ADD, true, R15, 2);
+    as.mov(true, RDX, R12);
+    as.group(NEG, true, RDX);
+    as.aluImm(SUB, true, RDX, 1);
+    as.bind(zeros);
+    as.test(true, RDX, RDX);
+    as.jcc(CC_E, smallDigits);
+    as.storeByteImm(at(R15), '0');
+    as.aluImm(ADD, true, R15, 1);
+    as.aluImm(SUB, true, RDX, 1);
+    as.jmp(zeros);
+    as.bind(smallDigits);
+    as.alu(XOR, false, RDX, RDX);
+    as.bind(smallLoop);
+    as.loadByte(RAX, at(RDI, RDX, 1));
+    as.storeByte(at(R15), RAX);
+    as.aluImm(ADD, true, R15, 1);
+    as.aluImm(ADD, true, RDX, 1);
+    as.alu(CMP, true, RDX, RCX);
+    as.jcc(CC_B, smallLoop);
+    as.jmp(newline);
+
+    // Scientific: d[.ddddd]e+XX
+    as.bind(scientific);
+    as.loadByte(RAX, at(RDI));
+    as.storeByte(at(R15), RAX);
+    as.aluImm(ADD, true, R15, 1);
+    as.aluImm(CMP, false, RCX, 1);
+    as.jcc(CC_BE, exponent);
+    as.storeByteImm(at(R15), '.');
+    as.aluImm(ADD, true, R15, 1);
+    as.movImm(RDX, 1);
+    as.bind(mantissaDigits);
+    as.loadByte(RAX, at(RDI, RDX, 1));
+    as.storeByte(at(R15), RAX);
+    as.aluImm(ADD, true, R15, 1);
+    as.aluImm(ADD, true, RDX, 1);
+    as.alu(CMP, true, RDX, RCX);
+    as.jcc(CC_B, mantissaDigits);
+    as.bind(exponent);
+    as.storeByteImm(at(R15), 'e');
+    as.movImm(RAX, '+');
+    as.test(true, R12, R12);
+    as.jcc(CC_NS, exponentSign);
+    as.movImm(RAX, '-');
+    as.group(NEG, true, R12);
+    as.bind(exponentSign);
+    as.storeByte(at(R15, 1), RAX);
+    as.aluImm(ADD, true, R15, 2);
+    as.mov(true, RAX, R12);
+    as.aluImm(CMP, true, RAX, 100);
+    as.jcc(CC_B, twoDigits);
+    as.alu(XOR, false, RDX, RDX);
+    as.movImm(RCX, 100);
+    as.group(DIV, true, RCX);
+    as.aluImm(ADD, false, RAX, '0');
+    as.storeByte(at(R15), RAX);
+    as.aluImm(ADD, true, R15, 1);
+    as.mov(true, RAX, RDX);
+    as.bind(twoDigits);
+    as.alu(XOR, false, RDX, RDX);
+    as.movImm(RCX, 10);
+    as.group(DIV, true, RCX);
+    as.aluImm(ADD, false, RAX, '0');
+    as.storeByte(at(R15), RAX);
+    as.aluImm(ADD, false, RDX, '0');
+    as.storeByte(at(R15, 1), RDX);
+    as.aluImm(ADD, true, R15, 2);
+
+    as.bind(newline);
+    as.storeByteImm(at(R15), '\n');
+    as.aluImm(ADD, true, R15, 1);
+    as.bind(output);
+    as.lea(RSI, sym(formatBuffer));
+    as.mov(true, RDX, R15);
+    as.alu(SUB, true, RDX, RSI);
+    for (int r : {R15, R14, R13, R12, RBX})
+        as.pop(r);
+    as.jmp(putBytesLabel);
+}
+
+} // namespace
+
+std::vector<uint8_t> NativeBackend::compile(const IrProgram &program)
+{
+    counters = Stats();
+    Lowering lowering(program, counters);
+    return lowering.run();
+}
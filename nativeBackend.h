@@ -0,0 +1,35 @@
+#ifndef NATIVE_BACKEND_H
+#define NATIVE_BACKEND_H
+
+#include <cstdint>
+#include <vector>
+#include "ir.h"
+
+// Lowers the IR straight to x86-64 machine code and wraps it in a static
+// Linux ELF executable (--native). Nothing else is needed to build or run
+// it: there is no assembler or linker step and no libc. Output goes
+// through a buffer flushed with raw 'write' syscalls, and the program
+// ends with 'exit_group'. Every print is byte-for-byte what the g++
+// backend's cstar_runtime.h would write, including %g for floats.
+//
+// Virtual registers are given machine registers by linear scan over live
+// intervals; the ones that do not fit live in stack slots.
+class NativeBackend
+{
+public:
+	struct Stats
+	{
+		size_t codeBytes = 0;      // Program and runtime, without data
+		int allocatedRegisters = 0; // Virtual registers kept in machine registers
+		int spilledRegisters = 0;   // Virtual registers kept on the stack
+	};
+
+	// The whole executable file
+	std::vector<uint8_t> compile(const IrProgram &program);
+	const Stats &stats() const { return counters; }
+
+private:
+	Stats counters;
+};
+
+#endif // NATIVE_BACKEND_H
@@ -0,0 +1,1538 @@
+#include "optimizer.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+
+static bool isArithmetic(OperatorType op)
+{
+    return op == Add || op == Subtract || op == Multiply || op == Divide || op == Modulus;
+}
+
+static bool isComparison(OperatorType op)
+{
+    return op == Equal || op == NotEqual || op == LessThan || op == LessThanEqualTo ||
+           op == GreaterThan || op == GreaterThanEqualTo;
+}
+
+ConstantFolder::ConstantFolder(AstArena &arena) : arena(arena)
+{
+
+}
+
+void ConstantFolder::run(std::vector<ParserNode*> &program)
+{
+    definitions.clear();
+    knownValues.clear();
+
+    enterScope();
+    countBlock(program);
+    exitScope();
+
+    enterScope();
+    foldBlock(program);
+    exitScope();
+}
+
+void ConstantFolder::printStats(std::ostream &out) const
+{
+    out << "Constant folding: " << counters.foldedExpressions << " expressions folded, "
+        << counters.propagatedUses << " variable uses propagated\n";
+}
+
+void ConstantFolder::enterScope()
+{
+    scopes.emplace_back();
+}
+
+void ConstantFolder::exitScope()
+{
+    scopes.pop_back();
+}
+
+// Innermost declaration visible under this name; nullptr if none
+DeclarationNode *ConstantFolder::resolve(SymbolId id) const
+{
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope)
+    {
+        auto it = scope->find(id);
+        if (it != scope->end())
+            return it->second;
+    }
+    return nullptr;
+}
+
+// ---- Pass 1 ----
+
+template <typename List>
+void ConstantFolder::countBlock(const List &statements)
+{
+    for (auto stmt : statements)
+        countStatement(stmt, &statements);
+}
+
+void ConstantFolder::countStatement(ParserNode *node, const void *list)
+{
+    if (node == nullptr)
+        return;
+
+    switch (node->kind)
+    {
+    case NodeKind::Declaration: {
+        auto decl = static_cast<DeclarationNode*>(node);
+        Definitions &defs = definitions[decl];
+        defs.list = list;
+        defs.count = decl->value != nullptr ? 1 : 0;
+        scopes.back()[decl->id] = decl;
+        break;
+    }
+    case NodeKind::Assignment: {
+        auto assign = static_cast<AssignmentNode*>(node);
+        DeclarationNode *decl = resolve(assign->var->id);
+        if (decl == nullptr)
+            break;
+        Definitions &defs = definitions[decl];
+        defs.count++;
+        defs.sameListSet = defs.list == list ? assign : nullptr;
+        break;
+    }
+    case NodeKind::If: {
+        auto ifNode = static_cast<IfNode*>(node);
+        enterScope();
+        countBlock(ifNode->thenBranch);
+        exitScope();
+        enterScope();
+        countBlock(ifNode->elseBranch);
+        exitScope();
+        break;
+    }
+    case NodeKind::WhileLoop:
+        enterScope();
+        countBlock(static_cast<WhileLoopNode*>(node)->statements);
+        exitScope();
+        break;
+    case NodeKind::Switch:
+        for (auto caseNode : static_cast<SwitchNode*>(node)->cases)
+        {
+            enterScope();
+            countBlock(caseNode->body);
+            exitScope();
+        }
+        break;
+    // Function bodies are not generated; expressions define nothing
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::FunctionCall:
+    case NodeKind::Variable:
+    case NodeKind::Print:
+    case NodeKind::Boolean:
+    case NodeKind::Operator:
+    case NodeKind::BinOp:
+    case NodeKind::Unary:
+    case NodeKind::String:
+    case NodeKind::Char:
+    case NodeKind::Number:
+    case NodeKind::Case:
+    case NodeKind::Break:
+        break;
+    }
+}
+
+// ---- Pass 2 ----
+
+template <typename List>
+void ConstantFolder::foldBlock(List &statements)
+{
+    for (auto stmt : statements)
+        foldStatement(stmt);
+}
+
+void ConstantFolder::foldStatement(ParserNode *node)
+{
+    if (node == nullptr)
+        return;
+
+    switch (node->kind)
+    {
+    case NodeKind::Declaration: {
+        auto decl = static_cast<DeclarationNode*>(node);
+        decl->value = foldExpression(decl->value);
+        scopes.back()[decl->id] = decl;
+        if (decl->value != nullptr && definitions[decl].count == 1)
+            recordValue(decl, decl->value);
+        break;
+    }
+    case NodeKind::Assignment: {
+        auto assign = static_cast<AssignmentNode*>(node);
+        assign->value = foldExpression(assign->value);
+        DeclarationNode *decl = resolve(assign->var->id);
+        if (decl == nullptr)
+            break;
+        const Definitions &defs = definitions[decl];
+        if (defs.count == 1 && defs.sameListSet == assign)
+            recordValue(decl, assign->value);
+        break;
+    }
+    case NodeKind::If: {
+        auto ifNode = static_cast<IfNode*>(node);
+        ifNode->condition = foldExpression(ifNode->condition);
+        enterScope();
+        foldBlock(ifNode->thenBranch);
+        exitScope();
+        enterScope();
+        foldBlock(ifNode->elseBranch);
+        exitScope();
+        break;
+    }
+    case NodeKind::WhileLoop: {
+        auto whileNode = static_cast<WhileLoopNode*>(node);
+        whileNode->condition = foldExpression(whileNode->condition);
+        enterScope();
+        foldBlock(whileNode->statements);
+        exitScope();
+        break;
+    }
+    case NodeKind::Switch: {
+        auto switchNode = static_cast<SwitchNode*>(node);
+        switchNode->condition = foldExpression(switchNode->condition);
+        for (auto caseNode : switchNode->cases)
+        {
+            caseNode->value = foldExpression(caseNode->value);
+            enterScope();
+            foldBlock(caseNode->body);
+            exitScope();
+        }
+        break;
+    }
+    case NodeKind::FunctionCall:
+        for (auto &arg : static_cast<FunctionCall*>(node)->arguments)
+            arg = foldExpression(arg);
+        break;
+    case NodeKind::Print: {
+        auto print = static_cast<PrintNode*>(node);
+        print->value = foldExpression(print->value);
+        break;
+    }
+    // Function bodies are not generated
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::Variable:
+    case NodeKind::Boolean:
+    case NodeKind::Operator:
+    case NodeKind::BinOp:
+    case NodeKind::Unary:
+    case NodeKind::String:
+    case NodeKind::Char:
+    case NodeKind::Number:
+    case NodeKind::Case:
+    case NodeKind::Break:
+        break;
+    }
+}
+
+// Remembers a variable's only value if it is a literal of the variable's
+// own type. string variables are never propagated: it buys nothing.
+void ConstantFolder::recordValue(DeclarationNode *decl, ParserNode *value)
+{
+    Constant c;
+    if (!constantOf(value, c))
+        return;
+
+    bool matches = (decl->type == "int" && c.kind == Constant::Int) ||
+                   (decl->type == "float" && c.kind == Constant::Float) ||
+                   (decl->type == "double" && c.kind == Constant::Double) ||
+                   (decl->type == "bool" && c.kind == Constant::Bool) ||
+                   (decl->type == "char" && c.kind == Constant::Char);
+    if (matches)
+        knownValues[decl] = value;
+}
+
+// Returns the node to use in place of 'node' (possibly 'node' itself).
+// Operands are folded before the node holding them, from the walker's
+// stack, so deep nesting does not recurse.
+ParserNode *ConstantFolder::foldExpression(ParserNode *node)
+{
+    walker.walk(&node,
+        [](ParserNode **) { return true; },
+        [](ParserNode **) {},
+        [this](ParserNode **site) { *site = foldNode(*site); });
+    return node;
+}
+
+// Folds one node whose operands are already folded
+ParserNode *ConstantFolder::foldNode(ParserNode *node)
+{
+    if (node == nullptr)
+        return nullptr;
+
+    switch (node->kind)
+    {
+    case NodeKind::Variable: {
+        DeclarationNode *decl = resolve(static_cast<VariableNode*>(node)->id);
+        auto it = decl != nullptr ? knownValues.find(decl) : knownValues.end();
+        if (it == knownValues.end())
+            return node;
+        Constant c;
+        constantOf(it->second, c);
+        counters.propagatedUses++;
+        return makeLiteral(c); // Fresh node per use; later passes may edit it
+    }
+    case NodeKind::BinOp:
+        return foldBinOp(static_cast<BinOpNode*>(node));
+    case NodeKind::Unary: {
+        auto unary = static_cast<UnaryNode*>(node);
+        Constant operand, result;
+        if (!constantOf(unary->operand, operand))
+            return node;
+        if (!evaluateUnary(unary->op->type, operand, result))
+            return node;
+        counters.foldedExpressions++;
+        return makeLiteral(result);
+    }
+    case NodeKind::FunctionCall:
+        return node;
+    case NodeKind::Number:
+    case NodeKind::Boolean:
+    case NodeKind::Char:
+    case NodeKind::String:
+    // statements are not expressions
+    case NodeKind::WhileLoop:
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::Declaration:
+    case NodeKind::Assignment:
+    case NodeKind::If:
+    case NodeKind::Print:
+    case NodeKind::Operator:
+    case NodeKind::Case:
+    case NodeKind::Switch:
+    case NodeKind::Break:
+        break;
+    }
+    return node;
+}
+
+// The literal 'bin' evaluates to once its operands are folded, or 'bin'
+ParserNode *ConstantFolder::foldBinOp(BinOpNode *bin)
+{
+    Constant l, r, result;
+    if (!constantOf(bin->left, l) || !constantOf(bin->right, r))
+        return bin;
+    if (!evaluate(bin->op->type, l, r, result))
+        return bin;
+    counters.foldedExpressions++;
+    return makeLiteral(result);
+}
+
+// Reads a literal node as the value the generated C++ would see
+bool ConstantFolder::constantOf(ParserNode *node, Constant &out) const
+{
+    if (node == nullptr)
+        return false;
+
+    switch (node->kind)
+    {
+    case NodeKind::Number: {
+        auto num = static_cast<NumberNode*>(node);
+        switch (num->type)
+        {
+        case NumberType::Int:
+            // Emitted through an (int) cast; leave out-of-range literals alone
+            if (!(num->value >= INT_MIN && num->value <= INT_MAX))
+                return false;
+            out.kind = Constant::Int;
+            out.i = static_cast<long long>(num->value);
+            return true;
+        case NumberType::Float:
+            out.kind = Constant::Float;
+            break;
+        case NumberType::Double:
+            out.kind = Constant::Double;
+            break;
+        }
+        // Emitted in shortest round-trip form, so g++ sees exactly this value
+        out.d = num->value;
+        return std::isfinite(num->value);
+    }
+    case NodeKind::Boolean:
+        out.kind = Constant::Bool;
+        out.i = static_cast<BooleanNode*>(node)->value;
+        return true;
+    case NodeKind::Char:
+        out.kind = Constant::Char;
+        out.i = static_cast<CharNode*>(node)->value;
+        return true;
+    case NodeKind::WhileLoop:
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::FunctionCall:
+    case NodeKind::Declaration:
+    case NodeKind::Variable:
+    case NodeKind::Assignment:
+    case NodeKind::If:
+    case NodeKind::Print:
+    case NodeKind::Operator:
+    case NodeKind::BinOp:
+    case NodeKind::Unary:
+    case NodeKind::String:
+    case NodeKind::Case:
+    case NodeKind::Switch:
+    case NodeKind::Break:
+        break;
+    }
+    return false;
+}
+
+ParserNode *ConstantFolder::makeLiteral(const Constant &value)
+{
+    switch (value.kind)
+    {
+    case Constant::Int:
+        return arena.make<NumberNode>(NumberType::Int, static_cast<double>(value.i));
+    case Constant::Float:
+        return arena.make<NumberNode>(NumberType::Float, value.d);
+    case Constant::Double:
+        return arena.make<NumberNode>(NumberType::Double, value.d);
+    case Constant::Bool:
+        return arena.make<BooleanNode>(value.i != 0);
+    case Constant::Char:
+        return arena.make<CharNode>(static_cast<char>(value.i));
+    }
+    return nullptr;
+}
+
+// Applies 'op' with C++ semantics. Returns false whenever the result is
+// not a literal the emitter can reproduce exactly, or the C++ behaviour
+// is undefined (int overflow, division by zero).
+bool ConstantFolder::evaluate(OperatorType op, const Constant &l, const Constant &r, Constant &result) const
+{
+    if (isArithmetic(op))
+    {
+        // Only int, float and double arithmetic is folded; char/bool math stays in C++
+        bool lNumeric = l.kind == Constant::Int || l.isFloating();
+        bool rNumeric = r.kind == Constant::Int || r.isFloating();
+        if (!lNumeric || !rNumeric)
+            return false;
+
+        if (l.kind == Constant::Int && r.kind == Constant::Int)
+        {
+            long long a = l.i, b = r.i, value = 0;
+            switch (op)
+            {
+            case Add:      value = a + b; break;
+            case Subtract: value = a - b; break;
+            case Multiply: value = a * b; break;
+            case Divide:
+                if (b == 0)
+                    return false;
+                value = a / b;
+                break;
+            case Modulus:
+                if (b == 0 || (a == INT_MIN && b == -1))
+                    return false;
+                value = a % b;
+                break;
+            default:
+                return false;
+            }
+            if (value < INT_MIN || value > INT_MAX)
+                return false;
+            result.kind = Constant::Int;
+            result.i = value;
+            return true;
+        }
+
+        // Computed in the wider operand type, like the generated C++
+        bool inFloat = l.kind != Constant::Double && r.kind != Constant::Double;
+        double value = 0;
+        if (inFloat)
+        {
+            float a = static_cast<float>(l.number()), b = static_cast<float>(r.number());
+            switch (op)
+            {
+            case Add:      value = a + b; break;
+            case Subtract: value = a - b; break;
+            case Multiply: value = a * b; break;
+            case Divide:   value = a / b; break;
+            default:
+                return false; // '%' on a float does not compile
+            }
+        }
+        else
+        {
+            double a = l.number(), b = r.number();
+            switch (op)
+            {
+            case Add:      value = a + b; break;
+            case Subtract: value = a - b; break;
+            case Multiply: value = a * b; break;
+            case Divide:   value = a / b; break;
+            default:
+                return false; // '%' on a double does not compile
+            }
+        }
+        if (!std::isfinite(value))
+            return false;
+        result.kind = inFloat ? Constant::Float : Constant::Double;
+        result.d = value;
+        return true;
+    }
+
+    if (isComparison(op))
+    {
+        // int, char and bool all promote to int; otherwise the wider floating type wins
+        bool floating = l.isFloating() || r.isFloating();
+        double a = l.number(), b = r.number();
+        if (l.kind != Constant::Double && r.kind != Constant::Double)
+        {
+            // An int compared with a float is converted to float first
+            a = static_cast<float>(a);
+            b = static_cast<float>(b);
+        }
+        long long x = l.i, y = r.i;
+        bool value = false;
+        switch (op)
+        {
+        case Equal:              value = floating ? a == b : x == y; break;
+        case NotEqual:           value = floating ? a != b : x != y; break;
+        case LessThan:           value = floating ? a < b : x < y; break;
+        case LessThanEqualTo:    value = floating ? a <= b : x <= y; break;
+        case GreaterThan:        value = floating ? a > b : x > y; break;
+        case GreaterThanEqualTo: value = floating ? a >= b : x >= y; break;
+        default:
+            return false;
+        }
+        result.kind = Constant::Bool;
+        result.i = value;
+        return true;
+    }
+
+    if ((op == And || op == Or) && l.kind == Constant::Bool && r.kind == Constant::Bool)
+    {
+        result.kind = Constant::Bool;
+        result.i = op == And ? (l.i && r.i) : (l.i || r.i);
+        return true;
+    }
+    return false;
+}
+
+// Prefix '-' and '!' with C++ semantics; char and bool negation is left to C++
+bool ConstantFolder::evaluateUnary(OperatorType op, const Constant &operand, Constant &result) const
+{
+    if (op == Not)
+    {
+        result.kind = Constant::Bool;
+        result.i = operand.isFloating() ? operand.d == 0 : operand.i == 0;
+        return true;
+    }
+    if (op != Subtract)
+        return false;
+    if (operand.kind == Constant::Int && operand.i != INT_MIN)
+    {
+        result.kind = Constant::Int;
+        result.i = -operand.i;
+        return true;
+    }
+    if (operand.isFloating())
+    {
+        result.kind = operand.kind;
+        result.d = -operand.d;
+        return true;
+    }
+    return false;
+}
+
+// ---- Dead code elimination ----
+
+// Calls are the only expressions that could have an effect of their own
+bool DeadCodeEliminator::hasCall(ParserNode *node)
+{
+    bool found = false;
+    walker.walk(&node,
+        [&](ParserNode **site)
+        {
+            found = found || node_cast<FunctionCall>(*site) != nullptr;
+            return !found;
+        },
+        [](ParserNode **) {},
+        [](ParserNode **) {});
+    return found;
+}
+
+// Truth value of a literal condition
+static bool constantTruth(ParserNode *node, bool &value)
+{
+    if (auto boolean = node_cast<BooleanNode>(node))
+    {
+        value = boolean->value;
+        return true;
+    }
+    if (auto num = node_cast<NumberNode>(node))
+    {
+        value = num->value != 0;
+        return true;
+    }
+    if (auto chr = node_cast<CharNode>(node))
+    {
+        value = chr->value != 0;
+        return true;
+    }
+    return false;
+}
+
+// Value of a literal usable as a switch key or case label
+static bool integralValue(ParserNode *node, long long &value)
+{
+    if (auto num = node_cast<NumberNode>(node))
+    {
+        if (num->type != NumberType::Int)
+            return false;
+        value = static_cast<long long>(num->value);
+        return true;
+    }
+    if (auto chr = node_cast<CharNode>(node))
+    {
+        value = chr->value;
+        return true;
+    }
+    if (auto boolean = node_cast<BooleanNode>(node))
+    {
+        value = boolean->value;
+        return true;
+    }
+    return false;
+}
+
+// A block can only be inlined into its parent if that adds no names to it
+static bool declaresAtTop(const NodeList &statements)
+{
+    for (auto stmt : statements)
+    {
+        if (stmt != nullptr && stmt->kind == NodeKind::Declaration)
+            return true;
+    }
+    return false;
+}
+
+// 'break' that would leave the enclosing switch; nested loops and
+// switches catch their own
+static bool containsBreak(const NodeList &statements)
+{
+    for (auto stmt : statements)
+    {
+        if (stmt == nullptr)
+            continue;
+        if (stmt->kind == NodeKind::Break)
+            return true;
+        if (auto ifNode = node_cast<IfNode>(stmt))
+        {
+            if (containsBreak(ifNode->thenBranch) || containsBreak(ifNode->elseBranch))
+                return true;
+        }
+    }
+    return false;
+}
+
+DeadCodeEliminator::DeadCodeEliminator(AstArena &arena) : arena(arena)
+{
+
+}
+
+// Removing one thing can make another dead, so sweep until nothing changes
+void DeadCodeEliminator::run(std::vector<ParserNode*> &program)
+{
+    do
+    {
+        changed = false;
+        bindings.clear();
+        uses.clear();
+        blockReads.clear();
+        scopes.emplace_back();
+        bindBlock(program);
+        scopes.pop_back();
+
+        sweepBlock(program);
+    } while (changed);
+}
+
+void DeadCodeEliminator::printStats(std::ostream &out) const
+{
+    out << "Dead code: " << counters.unusedDeclarations << " unused variables removed";
+    if (!counters.removedVariables.empty())
+    {
+        out << " (";
+        for (size_t i = 0; i < counters.removedVariables.size(); i++)
+            out << (i > 0 ? ", " : "") << counters.removedVariables[i];
+        out << ")";
+    }
+    out << ", " << counters.deadAssignments << " dead assignments, "
+        << counters.prunedBranches << " constant branches pruned, "
+        << counters.unreachableStatements << " unreachable statements removed\n";
+}
+
+DeclarationNode *DeadCodeEliminator::resolve(SymbolId id) const
+{
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope)
+    {
+        auto it = scope->find(id);
+        if (it != scope->end())
+            return it->second;
+    }
+    return nullptr;
+}
+
+DeclarationNode *DeadCodeEliminator::bindingOf(ParserNode *node) const
+{
+    auto it = bindings.find(node);
+    return it != bindings.end() ? it->second : nullptr;
+}
+
+bool DeadCodeEliminator::isUnused(DeclarationNode *decl) const
+{
+    auto it = uses.find(decl);
+    return it != uses.end() && !it->second.read && it->second.removable;
+}
+
+// ---- Binding ----
+
+template <typename List>
+void DeadCodeEliminator::bindBlock(const List &statements)
+{
+    scopes.emplace_back();
+    for (auto stmt : statements)
+        bindStatement(stmt);
+    scopes.pop_back();
+}
+
+void DeadCodeEliminator::bindStatement(ParserNode *node)
+{
+    if (node == nullptr)
+        return;
+
+    switch (node->kind)
+    {
+    case NodeKind::Declaration: {
+        auto decl = static_cast<DeclarationNode*>(node);
+        bindExpression(decl->value, nullptr);
+        Uses &u = uses[decl];
+        if (hasCall(decl->value))
+            u.removable = false;
+        scopes.back()[decl->id] = decl;
+        break;
+    }
+    case NodeKind::Assignment: {
+        auto assign = static_cast<AssignmentNode*>(node);
+        DeclarationNode *decl = resolve(assign->var->id);
+        bindings[assign] = decl;
+        // 'set x = x + 1' alone does not keep x alive
+        bindExpression(assign->value, decl);
+        if (decl != nullptr && hasCall(assign->value))
+            uses[decl].removable = false;
+        break;
+    }
+    case NodeKind::Print: {
+        auto print = static_cast<PrintNode*>(node);
+        bindExpression(print->value, nullptr);
+        break;
+    }
+    case NodeKind::If: {
+        auto ifNode = static_cast<IfNode*>(node);
+        bindExpression(ifNode->condition, nullptr);
+        bindBlock(ifNode->thenBranch);
+        bindBlock(ifNode->elseBranch);
+        break;
+    }
+    case NodeKind::WhileLoop: {
+        auto whileNode = static_cast<WhileLoopNode*>(node);
+        bindExpression(whileNode->condition, nullptr);
+        bindBlock(whileNode->statements);
+        break;
+    }
+    case NodeKind::Switch: {
+        auto switchNode = static_cast<SwitchNode*>(node);
+        bindExpression(switchNode->condition, nullptr);
+        for (auto caseNode : switchNode->cases)
+        {
+            bindExpression(caseNode->value, nullptr);
+            bindBlock(caseNode->body);
+        }
+        break;
+    }
+    case NodeKind::FunctionCall:
+        bindExpression(node, nullptr);
+        break;
+    // Function bodies are not generated
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::Variable:
+    case NodeKind::Boolean:
+    case NodeKind::Operator:
+    case NodeKind::BinOp:
+    case NodeKind::Unary:
+    case NodeKind::String:
+    case NodeKind::Char:
+    case NodeKind::Number:
+    case NodeKind::Case:
+    case NodeKind::Break:
+        break;
+    }
+}
+
+// Reads of 'target' itself are not counted (the value stored into it)
+void DeadCodeEliminator::bindExpression(ParserNode *node, DeclarationNode *target)
+{
+    if (node == nullptr)
+        return;
+
+    switch (node->kind)
+    {
+    case NodeKind::Variable: {
+        DeclarationNode *decl = resolve(static_cast<VariableNode*>(node)->id);
+        bindings[node] = decl;
+        if (decl != nullptr && decl != target)
+            uses[decl].read = true;
+        break;
+    }
+    case NodeKind::BinOp:
+    case NodeKind::Unary:
+        // Operands are visited from the walker's stack, so nesting costs no C++ stack
+        // Calls bind their own arguments, where reads of 'target' do count
+        walker.walk(&node,
+            [](ParserNode **site) { return node_cast<FunctionCall>(*site) == nullptr; },
+            [](ParserNode **) {},
+            [&](ParserNode **site)
+            {
+                if (node_cast<BinOpNode>(*site) == nullptr && node_cast<UnaryNode>(*site) == nullptr)
+                    bindExpression(*site, target);
+            });
+        break;
+    case NodeKind::FunctionCall:
+        for (auto arg : static_cast<FunctionCall*>(node)->arguments)
+            bindExpression(arg, nullptr);
+        break;
+    case NodeKind::Number:
+    case NodeKind::Boolean:
+    case NodeKind::Char:
+    case NodeKind::String:
+    // statements are not expressions
+    case NodeKind::WhileLoop:
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::Declaration:
+    case NodeKind::Assignment:
+    case NodeKind::If:
+    case NodeKind::Print:
+    case NodeKind::Operator:
+    case NodeKind::Case:
+    case NodeKind::Switch:
+    case NodeKind::Break:
+        break;
+    }
+}
+
+// ---- Sweeping ----
+
+template <typename List>
+void DeadCodeEliminator::sweepBlock(List &statements)
+{
+    for (auto stmt : statements)
+        sweepNested(stmt);
+
+    std::vector<ParserNode*> kept;
+    kept.reserve(statements.size());
+    bool afterBreak = false;
+    auto keep = [&](ParserNode *stmt)
+    {
+        if (afterBreak)
+        {
+            counters.unreachableStatements++;
+            changed = true;
+            return;
+        }
+        kept.push_back(stmt);
+        afterBreak = stmt != nullptr && stmt->kind == NodeKind::Break;
+    };
+    auto prune = [&]()
+    {
+        counters.prunedBranches++;
+        changed = true;
+    };
+
+    for (auto stmt : statements)
+    {
+        if (stmt == nullptr)
+        {
+            keep(stmt);
+            continue;
+        }
+
+        bool truth = false;
+        switch (stmt->kind)
+        {
+        case NodeKind::Declaration: {
+            auto decl = static_cast<DeclarationNode*>(stmt);
+            if (!isUnused(decl))
+            {
+                keep(stmt);
+                break;
+            }
+            counters.unusedDeclarations++;
+            counters.removedVariables.push_back(std::string(decl->name));
+            changed = true;
+            break;
+        }
+        case NodeKind::Assignment: {
+            DeclarationNode *decl = bindingOf(stmt);
+            if (decl == nullptr || !isUnused(decl))
+            {
+                keep(stmt);
+                break;
+            }
+            counters.deadAssignments++;
+            changed = true;
+            break;
+        }
+        case NodeKind::If: {
+            auto ifNode = static_cast<IfNode*>(stmt);
+            if (!constantTruth(ifNode->condition, truth))
+            {
+                keep(stmt);
+                break;
+            }
+            NodeList &taken = truth ? ifNode->thenBranch : ifNode->elseBranch;
+            if (!declaresAtTop(taken))
+            {
+                for (auto inner : taken)
+                    keep(inner);
+                prune();
+                break;
+            }
+            // Its declarations need the braces; keep the block, drop the test
+            if (!truth || !ifNode->elseBranch.empty())
+            {
+                ifNode->condition = arena.make<BooleanNode>(true);
+                if (!truth)
+                    ifNode->thenBranch = ifNode->elseBranch;
+                ifNode->elseBranch.clear();
+                prune();
+            }
+            keep(stmt);
+            break;
+        }
+        case NodeKind::WhileLoop:
+            if (constantTruth(static_cast<WhileLoopNode*>(stmt)->condition, truth) && !truth)
+                prune();
+            else
+                keep(stmt);
+            break;
+        case NodeKind::Switch: {
+            auto switchNode = static_cast<SwitchNode*>(stmt);
+            long long key = 0;
+            CaseNode *taken = nullptr;
+            CaseNode *fallback = nullptr;
+            bool decidable = integralValue(switchNode->condition, key);
+            for (auto caseNode : switchNode->cases)
+            {
+                long long label = 0;
+                if (!decidable)
+                    break;
+                if (caseNode->value == nullptr)
+                    fallback = caseNode;
+                else if (!integralValue(caseNode->value, label))
+                    decidable = false;
+                else if (label == key && taken == nullptr)
+                    taken = caseNode;
+            }
+            if (!decidable)
+            {
+                keep(stmt);
+                break;
+            }
+            if (taken == nullptr)
+                taken = fallback;
+            if (taken == nullptr)
+            {
+                prune(); // No case runs
+                break;
+            }
+
+            NodeList body = taken->body;
+            if (!body.empty() && body.back() != nullptr && body.back()->kind == NodeKind::Break)
+                body.pop_back();
+            if (!declaresAtTop(body) && !containsBreak(body))
+            {
+                for (auto inner : body)
+                    keep(inner);
+                prune();
+                break;
+            }
+            if (switchNode->cases.size() > 1)
+            {
+                switchNode->cases.assign(1, taken);
+                prune();
+            }
+            keep(stmt);
+            break;
+        }
+        case NodeKind::FunctionDeclaration:
+        case NodeKind::FunctionCall:
+        case NodeKind::Variable:
+        case NodeKind::Print:
+        case NodeKind::Boolean:
+        case NodeKind::Operator:
+        case NodeKind::BinOp:
+        case NodeKind::Unary:
+        case NodeKind::String:
+        case NodeKind::Char:
+        case NodeKind::Number:
+        case NodeKind::Case:
+        case NodeKind::Break:
+            keep(stmt);
+            break;
+        }
+    }
+
+    removeDeadStores(kept);
+    statements.assign(kept.begin(), kept.end());
+}
+
+void DeadCodeEliminator::sweepNested(ParserNode *node)
+{
+    if (auto ifNode = node_cast<IfNode>(node))
+    {
+        sweepBlock(ifNode->thenBranch);
+        sweepBlock(ifNode->elseBranch);
+    }
+    else if (auto whileNode = node_cast<WhileLoopNode>(node))
+    {
+        sweepBlock(whileNode->statements);
+    }
+    else if (auto switchNode = node_cast<SwitchNode>(node))
+    {
+        for (auto caseNode : switchNode->cases)
+            sweepBlock(caseNode->body);
+    }
+}
+
+// Backward walk over one list: a store is dead if a later statement of
+// the same list overwrites the variable before anything reads it
+void DeadCodeEliminator::removeDeadStores(std::vector<ParserNode*> &statements)
+{
+    std::unordered_map<DeclarationNode*, bool> overwritten;
+    std::vector<DeclarationNode*> reads;
+    std::vector<bool> dead(statements.size(), false);
+
+    for (size_t i = statements.size(); i-- > 0;)
+    {
+        ParserNode *stmt = statements[i];
+        reads.clear();
+        if (auto assign = node_cast<AssignmentNode>(stmt))
+        {
+            DeclarationNode *decl = bindingOf(assign);
+            if (decl != nullptr && overwritten[decl] && !hasCall(assign->value))
+            {
+                dead[i] = true;
+                counters.deadAssignments++;
+                changed = true;
+                continue;
+            }
+            if (decl != nullptr)
+                overwritten[decl] = true;
+            collectReads(assign->value, reads);
+        }
+        else if (auto decl = node_cast<DeclarationNode>(stmt))
+        {
+            if (decl->value != nullptr && overwritten[decl] && !hasCall(decl->value))
+            {
+                decl->value = nullptr;
+                counters.deadAssignments++;
+                changed = true;
+            }
+            collectReads(decl->value, reads);
+        }
+        else
+        {
+            collectReads(stmt, reads);
+        }
+        for (auto read : reads)
+            overwritten[read] = false;
+    }
+
+    size_t out = 0;
+    for (size_t i = 0; i < statements.size(); i++)
+    {
+        if (!dead[i])
+            statements[out++] = statements[i];
+    }
+    statements.resize(out);
+}
+
+// Every declaration read anywhere inside 'node'. Sweeping runs innermost
+// lists first, so a nested block's reads are already cached when its
+// parent list asks; entries computed before a dead store was removed only
+// over-approximate, which keeps more stores, never fewer.
+void DeadCodeEliminator::collectReads(ParserNode *node, std::vector<DeclarationNode*> &out)
+{
+    if (node == nullptr)
+        return;
+
+    bool block = node->kind == NodeKind::If || node->kind == NodeKind::WhileLoop ||
+                 node->kind == NodeKind::Switch;
+    if (!block)
+    {
+        collectBlockReads(node, out);
+        return;
+    }
+
+    auto cached = blockReads.find(node);
+    if (cached == blockReads.end())
+    {
+        std::vector<DeclarationNode*> reads;
+        collectBlockReads(node, reads);
+        std::sort(reads.begin(), reads.end());
+        reads.erase(std::unique(reads.begin(), reads.end()), reads.end());
+        cached = blockReads.emplace(node, std::move(reads)).first;
+    }
+    out.insert(out.end(), cached->second.begin(), cached->second.end());
+}
+
+void DeadCodeEliminator::collectBlockReads(ParserNode *node, std::vector<DeclarationNode*> &out)
+{
+    if (node == nullptr)
+        return;
+
+    // Nested statements go back through collectReads to use the cache
+    switch (node->kind)
+    {
+    case NodeKind::Variable:
+        if (DeclarationNode *decl = bindingOf(node))
+            out.push_back(decl);
+        break;
+    case NodeKind::Print:
+        collectBlockReads(static_cast<PrintNode*>(node)->value, out);
+        break;
+    case NodeKind::BinOp:
+    case NodeKind::Unary:
+    case NodeKind::FunctionCall:
+        // Operands are visited from the walker's stack, so nesting costs no C++ stack
+        walker.walk(&node,
+            [](ParserNode **) { return true; },
+            [](ParserNode **) {},
+            [&](ParserNode **site)
+            {
+                if (node_cast<VariableNode>(*site) != nullptr)
+                    collectBlockReads(*site, out);
+            });
+        break;
+    case NodeKind::Declaration:
+        collectBlockReads(static_cast<DeclarationNode*>(node)->value, out);
+        break;
+    case NodeKind::Assignment:
+        collectBlockReads(static_cast<AssignmentNode*>(node)->value, out);
+        break;
+    case NodeKind::If: {
+        auto ifNode = static_cast<IfNode*>(node);
+        collectBlockReads(ifNode->condition, out);
+        for (auto stmt : ifNode->thenBranch)
+            collectReads(stmt, out);
+        for (auto stmt : ifNode->elseBranch)
+            collectReads(stmt, out);
+        break;
+    }
+    case NodeKind::WhileLoop: {
+        auto whileNode = static_cast<WhileLoopNode*>(node);
+        collectBlockReads(whileNode->condition, out);
+        for (auto stmt : whileNode->statements)
+            collectReads(stmt, out);
+        break;
+    }
+    case NodeKind::Switch: {
+        auto switchNode = static_cast<SwitchNode*>(node);
+        collectBlockReads(switchNode->condition, out);
+        for (auto caseNode : switchNode->cases)
+        {
+            collectBlockReads(caseNode->value, out);
+            for (auto stmt : caseNode->body)
+                collectReads(stmt, out);
+        }
+        break;
+    }
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::Boolean:
+    case NodeKind::Operator:
+    case NodeKind::String:
+    case NodeKind::Char:
+    case NodeKind::Number:
+    case NodeKind::Case:
+    case NodeKind::Break:
+        break;
+    }
+}
+
+// ---- Common subexpression elimination ----
+
+enum ValueKind : unsigned char { VariableValue, NumberValue, BooleanValue, CharValue, BinaryValue, UnaryValue };
+
+static bool isCommutative(OperatorType op)
+{
+    return op == Add || op == Multiply || op == Equal || op == NotEqual;
+}
+
+// The next else-if in a chain, or nullptr
+static IfNode *elseIf(IfNode *ifNode)
+{
+    if (ifNode->elseBranch.size() != 1)
+        return nullptr;
+    return node_cast<IfNode>(ifNode->elseBranch[0]);
+}
+
+size_t CommonSubexpressionEliminator::ValueKeyHash::operator()(const ValueKey &key) const
+{
+    uint64_t h = (static_cast<uint64_t>(key.kind) << 8) | key.op;
+    h = h * 0x9E3779B97F4A7C15ull ^ key.a;
+    h = h * 0x9E3779B97F4A7C15ull ^ key.b;
+    return static_cast<size_t>(h ^ (h >> 29));
+}
+
+CommonSubexpressionEliminator::CommonSubexpressionEliminator(AstArena &arena, StringInterner &names,
+                                                             const SemanticAnalyzer &analyzer)
+    : arena(arena), names(names), analyzer(analyzer)
+{
+
+}
+
+void CommonSubexpressionEliminator::run(std::vector<ParserNode*> &program)
+{
+    versions.clear();
+    eliminateBlock(program);
+}
+
+void CommonSubexpressionEliminator::printStats(std::ostream &out) const
+{
+    out << "Common subexpressions: " << counters.temporaries << " temporaries, "
+        << counters.reusedExpressions << " repeated computations removed\n";
+}
+
+DeclarationNode *CommonSubexpressionEliminator::resolve(SymbolId id) const
+{
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope)
+    {
+        auto it = scope->find(id);
+        if (it != scope->end())
+            return it->second;
+    }
+    return nullptr;
+}
+
+// Numbers every statement, then hoists what repeats. Nested lists are
+// separate regions and are finished before the statements after them.
+template <typename List>
+void CommonSubexpressionEliminator::eliminateBlock(List &statements)
+{
+    if (depth == regions.size())
+        regions.emplace_back();
+    Region &region = regions[depth++];
+    region.clear();
+    scopes.emplace_back();
+    for (auto stmt : statements)
+        numberStatement(region, stmt);
+    scopes.pop_back();
+
+    introduceTemporaries(region);
+    depth--;
+    if (region.temporariesBefore.empty())
+        return;
+
+    std::vector<ParserNode*> rewritten;
+    rewritten.reserve(statements.size() + region.temporariesBefore.size());
+    for (auto stmt : statements)
+    {
+        auto it = region.temporariesBefore.find(stmt);
+        if (it != region.temporariesBefore.end())
+            rewritten.insert(rewritten.end(), it->second.begin(), it->second.end());
+        rewritten.push_back(stmt);
+    }
+    statements.assign(rewritten.begin(), rewritten.end());
+}
+
+void CommonSubexpressionEliminator::numberStatement(Region &region, ParserNode *node)
+{
+    if (node == nullptr)
+        return;
+
+    bool hoistable = false;
+    switch (node->kind)
+    {
+    case NodeKind::Declaration: {
+        auto decl = static_cast<DeclarationNode*>(node);
+        if (decl->value != nullptr)
+            number(region, &decl->value, -1, node, hoistable);
+        scopes.back()[decl->id] = decl;
+        break;
+    }
+    case NodeKind::Assignment: {
+        auto assign = static_cast<AssignmentNode*>(node);
+        number(region, &assign->value, -1, node, hoistable);
+        if (DeclarationNode *decl = resolve(assign->var->id))
+            versions[decl]++;
+        break;
+    }
+    case NodeKind::Print:
+        number(region, &static_cast<PrintNode*>(node)->value, -1, node, hoistable);
+        break;
+    case NodeKind::If: {
+        // No body runs until a condition holds, so the whole chain's
+        // conditions see the same variables
+        auto ifNode = static_cast<IfNode*>(node);
+        for (IfNode *link = ifNode; link != nullptr; link = elseIf(link))
+            number(region, &link->condition, -1, node, hoistable);
+        for (IfNode *link = ifNode; link != nullptr; link = elseIf(link))
+        {
+            eliminateBlock(link->thenBranch);
+            if (elseIf(link) == nullptr && !link->elseBranch.empty())
+                eliminateBlock(link->elseBranch);
+        }
+        break;
+    }
+    case NodeKind::WhileLoop:
+        // The condition is re-evaluated after the body, so it stays out
+        eliminateBlock(static_cast<WhileLoopNode*>(node)->statements);
+        break;
+    case NodeKind::Switch: {
+        auto switchNode = static_cast<SwitchNode*>(node);
+        number(region, &switchNode->condition, -1, node, hoistable);
+        for (auto caseNode : switchNode->cases)
+            eliminateBlock(caseNode->body);
+        break;
+    }
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::FunctionCall:
+    case NodeKind::Variable:
+    case NodeKind::BinOp:
+    case NodeKind::Unary:
+    case NodeKind::Boolean:
+    case NodeKind::Operator:
+    case NodeKind::String:
+    case NodeKind::Char:
+    case NodeKind::Number:
+    case NodeKind::Case:
+    case NodeKind::Break:
+        break;
+    }
+}
+
+// Value number of *site. 'hoistable' says whether the expression is pure
+// and cannot trap, so it may be computed earlier than written.
+uint32_t CommonSubexpressionEliminator::number(Region &region, ParserNode **site, int parent,
+                                               ParserNode *anchor, bool &hoistable)
+{
+    // Each operation's occurrence is recorded on the way down and its value
+    // numbered on the way back up, in the order recursion would use, but
+    // from the walker's stack so nesting costs no C++ stack
+    parents.push_back(parent);
+    walker.walk(site,
+        [&](ParserNode **at)
+        {
+            if (node_cast<BinOpNode>(*at) == nullptr && node_cast<UnaryNode>(*at) == nullptr)
+                return false;
+            int self = static_cast<int>(region.occurrences.size());
+            region.occurrences.push_back({at, parents.back(), anchor});
+            parents.push_back(self);
+            return true;
+        },
+        [](ParserNode **) {},
+        [&](ParserNode **at) { numberNode(region, *at); });
+    parents.pop_back();
+    Numbered result = numbered.back();
+    numbered.pop_back();
+    hoistable = result.hoistable;
+    return result.value;
+}
+
+// Numbers one node whose operands are numbered on top of 'numbered'
+void CommonSubexpressionEliminator::numberNode(Region &region, ParserNode *node)
+{
+    if (node == nullptr)
+    {
+        numbered.push_back({uniqueNumber(region), false});
+        return;
+    }
+
+    switch (node->kind)
+    {
+    case NodeKind::Variable: {
+        DeclarationNode *decl = resolve(static_cast<VariableNode*>(node)->id);
+        if (decl == nullptr)
+            break;
+        numbered.push_back({valueNumber(region, {VariableValue, 0, reinterpret_cast<uintptr_t>(decl), versions[decl]}), true});
+        return;
+    }
+    case NodeKind::Number: {
+        auto num = static_cast<NumberNode*>(node);
+        uint64_t bits;
+        std::memcpy(&bits, &num->value, sizeof bits);
+        numbered.push_back({valueNumber(region, {NumberValue, static_cast<unsigned char>(num->type), bits, 0}), true});
+        return;
+    }
+    case NodeKind::Boolean:
+        numbered.push_back({valueNumber(region, {BooleanValue, 0, static_cast<BooleanNode*>(node)->value, 0}), true});
+        return;
+    case NodeKind::Char:
+        numbered.push_back({valueNumber(region, {CharValue, 0, static_cast<unsigned char>(static_cast<CharNode*>(node)->value), 0}), true});
+        return;
+    case NodeKind::String:
+        numbered.push_back({uniqueNumber(region), true});
+        return;
+    case NodeKind::BinOp: {
+        auto bin = static_cast<BinOpNode*>(node);
+        int self = parents.back();
+        parents.pop_back();
+        Numbered right = numbered.back();
+        numbered.pop_back();
+        Numbered left = numbered.back();
+        numbered.pop_back();
+        uint64_t a = left.value, b = right.value;
+        OperatorType op = bin->op->type;
+        if (isCommutative(op) && b < a)
+            std::swap(a, b);
+        uint32_t value = valueNumber(region, {BinaryValue, static_cast<unsigned char>(op), a, b});
+        const Type *type = analyzer.typeOf(bin);
+        bool hoistable = left.hoistable && right.hoistable && type != nullptr && !mayTrap(bin);
+        if (hoistable)
+            record(region, value, self, type);
+        numbered.push_back({value, hoistable});
+        return;
+    }
+    case NodeKind::Unary: {
+        auto unary = static_cast<UnaryNode*>(node);
+        int self = parents.back();
+        parents.pop_back();
+        Numbered operand = numbered.back();
+        numbered.pop_back();
+        uint32_t value = valueNumber(region, {UnaryValue, static_cast<unsigned char>(unary->op->type), operand.value, 0});
+        const Type *type = analyzer.typeOf(unary);
+        bool hoistable = operand.hoistable && type != nullptr;
+        if (hoistable)
+            record(region, value, self, type);
+        numbered.push_back({value, hoistable});
+        return;
+    }
+    case NodeKind::FunctionCall:
+    case NodeKind::WhileLoop:
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::Declaration:
+    case NodeKind::Assignment:
+    case NodeKind::If:
+    case NodeKind::Print:
+    case NodeKind::Operator:
+    case NodeKind::Case:
+    case NodeKind::Switch:
+    case NodeKind::Break:
+        break;
+    }
+    numbered.push_back({uniqueNumber(region), false});
+}
+
+uint32_t CommonSubexpressionEliminator::valueNumber(Region &region, const ValueKey &key)
+{
+    auto inserted = region.numbers.emplace(key, static_cast<uint32_t>(region.values.size()));
+    if (inserted.second)
+        region.values.emplace_back();
+    return inserted.first->second;
+}
+
+// A value equal to nothing else, e.g. a call's result
+uint32_t CommonSubexpressionEliminator::uniqueNumber(Region &region)
+{
+    region.values.emplace_back();
+    return static_cast<uint32_t>(region.values.size() - 1);
+}
+
+// Only int, float, double and bool results can be hoisted; a temporary of
+// those types holds exactly what the C++ expression computes
+void CommonSubexpressionEliminator::record(Region &region, uint32_t value, int occurrence, const Type *type)
+{
+    if (!type->isNumeric() && type != &types::Bool)
+        return;
+    Value &v = region.values[value];
+    if (v.last >= 0)
+        region.occurrences[v.last].next = occurrence;
+    else
+        v.first = occurrence;
+    v.last = occurrence;
+    v.type = type;
+    v.count++;
+}
+
+void CommonSubexpressionEliminator::Region::clear()
+{
+    numbers.clear();
+    values.clear();
+    occurrences.clear();
+    temporariesBefore.clear();
+}
+
+// An operation always has a higher value number than its operands, so
+// going from the highest down picks the largest repeated expressions
+// first; what is left of their subexpressions is considered afterwards.
+void CommonSubexpressionEliminator::introduceTemporaries(Region &region)
+{
+    std::vector<int> live;
+    for (size_t value = region.values.size(); value-- > 0;)
+    {
+        const Value &v = region.values[value];
+        if (v.count < 2)
+            continue;
+        live.clear();
+        for (int occurrence = v.first; occurrence >= 0; occurrence = region.occurrences[occurrence].next)
+        {
+            if (!covered(region, occurrence))
+                live.push_back(occurrence);
+        }
+        if (live.size() < 2)
+            continue;
+
+        // The first occurrence's tree becomes the initializer
+        Occurrence &first = region.occurrences[live[0]];
+        Token name = temporaryName();
+        auto decl = arena.make<DeclarationNode>(std::string(v.type->name), name, *first.site);
+        *first.site = arena.make<VariableNode>(name);
+        first.state = Occurrence::Moved;
+        for (size_t i = 1; i < live.size(); i++)
+        {
+            Occurrence &later = region.occurrences[live[i]];
+            *later.site = arena.make<VariableNode>(name);
+            later.state = Occurrence::Replaced;
+        }
+
+        // Temporaries made later never use earlier ones, but may be used
+        // by them, so each goes in front of those already placed
+        std::vector<DeclarationNode*> &before = region.temporariesBefore[first.anchor];
+        before.insert(before.begin(), decl);
+        counters.temporaries++;
+        counters.reusedExpressions += static_cast<int>(live.size()) - 1;
+    }
+}
+
+// Whether the occurrence was replaced along with an enclosing expression.
+// One inside a moved tree still runs, as part of a temporary's initializer.
+bool CommonSubexpressionEliminator::covered(const Region &region, int occurrence) const
+{
+    for (int p = region.occurrences[occurrence].parent; p >= 0; p = region.occurrences[p].parent)
+    {
+        if (region.occurrences[p].state == Occurrence::Replaced)
+            return true;
+        if (region.occurrences[p].state == Occurrence::Moved)
+            return false;
+    }
+    return false;
+}
+
+// A name no identifier in the program uses
+Token CommonSubexpressionEliminator::temporaryName()
+{
+    while (true)
+    {
+        std::string text = "_cse" + std::to_string(nextTemporary++);
+        size_t known = names.size();
+        SymbolId id = names.intern(text);
+        if (id == known)
+            return Token{TokenType::IDENTIFIER, names.name(id), 0, 0, id};
+    }
+}
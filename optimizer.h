@@ -0,0 +1,249 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <iostream>
+#include "parser.h"
+#include "semanticAnalyzer.h"
+#include "stringInterner.h"
+
+// AST-level optimization passes. They run after SemanticAnalyzer::analyze
+// and rewrite the tree in place, so both the C++ backend and --run see
+// the optimized program. New nodes come from the compilation's arena.
+
+// Folds literal arithmetic, comparisons and boolean logic, and propagates
+// the value of variables that are assigned exactly once
+class ConstantFolder
+{
+public:
+	struct Stats
+	{
+		int foldedExpressions = 0; // operations replaced by their result
+		int propagatedUses = 0;    // variable reads replaced by a literal
+	};
+
+	explicit ConstantFolder(AstArena &arena);
+
+	void run(std::vector<ParserNode*> &program);
+	const Stats &stats() const { return counters; }
+	void printStats(std::ostream &out) const;
+
+private:
+	// Value of a literal node, typed the way the generated C++ sees it
+	struct Constant
+	{
+		enum Kind { Int, Float, Double, Bool, Char } kind = Int;
+		long long i = 0; // Int, Bool and Char
+		double d = 0;    // Float and Double
+
+		bool isFloating() const { return kind == Float || kind == Double; }
+		double number() const { return isFloating() ? d : static_cast<double>(i); }
+	};
+
+	struct Definitions
+	{
+		int count = 0;                         // initializer + every 'set'
+		const void *list = nullptr;            // statement list holding the declaration
+		AssignmentNode *sameListSet = nullptr; // a 'set' in that same list
+	};
+
+	AstArena &arena;
+	Stats counters;
+	std::unordered_map<DeclarationNode*, Definitions> definitions;
+	std::unordered_map<DeclarationNode*, ParserNode*> knownValues;
+	std::vector<std::unordered_map<SymbolId, DeclarationNode*>> scopes;
+	ExpressionWalker walker;
+
+	void enterScope();
+	void exitScope();
+	DeclarationNode *resolve(SymbolId id) const;
+
+	// Pass 1: count the definitions of every declared variable
+	template <typename List> void countBlock(const List &statements);
+	void countStatement(ParserNode *node, const void *list);
+
+	// Pass 2: fold, remembering single-definition constants on the way
+	template <typename List> void foldBlock(List &statements);
+	void foldStatement(ParserNode *node);
+	ParserNode *foldExpression(ParserNode *node);
+	ParserNode *foldNode(ParserNode *node);
+	ParserNode *foldBinOp(BinOpNode *bin);
+	void recordValue(DeclarationNode *decl, ParserNode *value);
+
+	bool constantOf(ParserNode *node, Constant &out) const;
+	ParserNode *makeLiteral(const Constant &value);
+	bool evaluate(OperatorType op, const Constant &l, const Constant &r, Constant &result) const;
+	bool evaluateUnary(OperatorType op, const Constant &operand, Constant &result) const;
+};
+
+// Removes what cannot affect the program's output: variables that are
+// never read (with every store to them), stores that are overwritten
+// before any read, branches whose condition is a literal, and statements
+// after a 'break'. Run after ConstantFolder, which exposes most of these.
+class DeadCodeEliminator
+{
+public:
+	struct Stats
+	{
+		int unusedDeclarations = 0;
+		int deadAssignments = 0;      // stores never read, incl. dropped initializers
+		int prunedBranches = 0;       // if/while/switch decided by a literal condition
+		int unreachableStatements = 0;
+		std::vector<std::string> removedVariables;
+	};
+
+	explicit DeadCodeEliminator(AstArena &arena);
+
+	void run(std::vector<ParserNode*> &program);
+	const Stats &stats() const { return counters; }
+	void printStats(std::ostream &out) const;
+
+private:
+	struct Uses
+	{
+		bool read = false;
+		bool removable = true; // no store to it calls a function
+	};
+
+	AstArena &arena;
+	Stats counters;
+	bool changed = false;
+	// Variable and Assignment nodes -> the declaration they refer to
+	std::unordered_map<ParserNode*, DeclarationNode*> bindings;
+	std::unordered_map<DeclarationNode*, Uses> uses;
+	std::vector<std::unordered_map<SymbolId, DeclarationNode*>> scopes;
+	// Reads of each if/while/switch, so nested blocks are walked once per round
+	std::unordered_map<ParserNode*, std::vector<DeclarationNode*>> blockReads;
+	ExpressionWalker walker;
+
+	DeclarationNode *resolve(SymbolId id) const;
+	DeclarationNode *bindingOf(ParserNode *node) const;
+	bool isUnused(DeclarationNode *decl) const;
+	bool hasCall(ParserNode *node);
+
+	// Name resolution and read tracking for the current tree
+	template <typename List> void bindBlock(const List &statements);
+	void bindStatement(ParserNode *node);
+	void bindExpression(ParserNode *node, DeclarationNode *target);
+
+	// Rewrites one statement list, innermost lists first
+	template <typename List> void sweepBlock(List &statements);
+	void sweepNested(ParserNode *node);
+	void removeDeadStores(std::vector<ParserNode*> &statements);
+	void collectReads(ParserNode *node, std::vector<DeclarationNode*> &out);
+	void collectBlockReads(ParserNode *node, std::vector<DeclarationNode*> &out);
+};
+
+// Computes each repeated expression once. Within a statement list, and
+// across the conditions of an if/elif chain, identical pure expressions
+// get the same value number; the largest ones seen more than once are
+// stored in a compiler temporary declared ahead of the first use. A 'set'
+// gives the variable a new version, so later uses no longer match.
+// Integer '/' and '%' by a variable divisor are never hoisted, since
+// moving them out of '&&'/'||' could add a division by zero.
+class CommonSubexpressionEliminator
+{
+public:
+	struct Stats
+	{
+		int temporaries = 0;
+		int reusedExpressions = 0; // later occurrences replaced by a temporary
+	};
+
+	CommonSubexpressionEliminator(AstArena &arena, StringInterner &names, const SemanticAnalyzer &analyzer);
+
+	void run(std::vector<ParserNode*> &program);
+	const Stats &stats() const { return counters; }
+	void printStats(std::ostream &out) const;
+
+private:
+	// What a value number stands for: an operation on other value numbers,
+	// a literal, or one version of a variable
+	struct ValueKey
+	{
+		unsigned char kind;
+		unsigned char op;
+		uint64_t a;
+		uint64_t b;
+
+		bool operator==(const ValueKey &other) const
+		{
+			return kind == other.kind && op == other.op && a == other.a && b == other.b;
+		}
+	};
+
+	struct ValueKeyHash
+	{
+		size_t operator()(const ValueKey &key) const;
+	};
+
+	// One candidate expression node, in evaluation order
+	struct Occurrence
+	{
+		ParserNode **site;
+		int parent;         // Enclosing occurrence, -1 at the top of a statement
+		ParserNode *anchor; // Statement that evaluates it
+		int next = -1;      // Next occurrence of the same value
+		enum State : unsigned char { Live, Moved, Replaced } state = Live;
+	};
+
+	struct Value
+	{
+		const Type *type = nullptr; // Set once an occurrence may be hoisted
+		int first = -1;             // Occurrence list, in evaluation order
+		int last = -1;
+		int count = 0;
+	};
+
+	// Value number of an expression and whether it may be hoisted
+	struct Numbered
+	{
+		uint32_t value;
+		bool hoistable;
+	};
+
+	// Value numbering state for one statement list. Kept per nesting depth
+	// and reused, so numbering a block does not allocate once warmed up.
+	struct Region
+	{
+		std::unordered_map<ValueKey, uint32_t, ValueKeyHash> numbers;
+		std::vector<Value> values; // Indexed by value number
+		std::vector<Occurrence> occurrences;
+		std::unordered_map<ParserNode*, std::vector<DeclarationNode*>> temporariesBefore;
+
+		void clear();
+	};
+
+	AstArena &arena;
+	StringInterner &names;
+	const SemanticAnalyzer &analyzer;
+	Stats counters;
+	std::vector<std::unordered_map<SymbolId, DeclarationNode*>> scopes;
+	std::unordered_map<DeclarationNode*, uint32_t> versions; // Bumped by every 'set'
+	std::deque<Region> regions;                                // One per open statement list
+	ExpressionWalker walker;
+	std::vector<int> parents;                                  // Occurrences being numbered, innermost last
+	std::vector<Numbered> numbered;                            // Operands numbered so far
+	size_t depth = 0;
+	int nextTemporary = 0;
+
+	DeclarationNode *resolve(SymbolId id) const;
+
+	template <typename List> void eliminateBlock(List &statements);
+	void numberStatement(Region &region, ParserNode *node);
+	uint32_t number(Region &region, ParserNode **site, int parent, ParserNode *anchor, bool &hoistable);
+	void numberNode(Region &region, ParserNode *node);
+	uint32_t valueNumber(Region &region, const ValueKey &key);
+	uint32_t uniqueNumber(Region &region);
+	void record(Region &region, uint32_t value, int occurrence, const Type *type);
+
+	void introduceTemporaries(Region &region);
+	bool covered(const Region &region, int occurrence) const;
+	Token temporaryName();
+};
+
+#endif // OPTIMIZER_H
@@ -1,8 +1,15 @@
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
 #include "parser.h"
+#include "types.h"
 
 // Added this helper function for indented debug output
 const bool DEBUG_PARSING = false;
@@ -21,11 +28,9 @@ void ParserNode::print(int indent)
     std::cout << "ParserNode\n";
 }
 
-FunctionDeclaration::FunctionDeclaration(std::string name, std::vector<std::string> parameters, std::vector<ParserNode*> body)
+FunctionDeclaration::FunctionDeclaration(const Token &name, std::vector<Token> parameters, NodeList body)
+    : ParserNode(KIND), name(name.text), id(name.symbol), parameters(std::move(parameters)), body(std::move(body))
 {
-    this->name = name;
-    this->parameters = parameters;
-    this->body = body;
 }
 void FunctionDeclaration::print(int indent)
 {
@@ -39,13 +44,13 @@ void FunctionDeclaration::print(int indent)
         std::cout << "  ";
     }
     std::cout << "Parameters:" << std::endl;
-    for (std::string param : parameters) 
+    for (const Token &param : parameters) 
     {
         for (int i = 0; i < indent+2; i++)
         {
             std::cout << "  ";
         }
-        std::cout << param << std::endl;
+        std::cout << param.text << std::endl;
     }
     for (int i = 0; i < indent+1; i++)
     {
@@ -58,10 +63,9 @@ void FunctionDeclaration::print(int indent)
     }
 }
 
-FunctionCall::FunctionCall(std::string name, std::vector<ParserNode*> arguments) 
+FunctionCall::FunctionCall(const Token &name, NodeList arguments)
+    : ParserNode(KIND), name(name.text), id(name.symbol), arguments(std::move(arguments))
 {
-    this->name = name;
-    this->arguments = arguments;
 }
 
 void FunctionCall::print(int indent)
@@ -77,11 +81,9 @@ void FunctionCall::print(int indent)
     }
 }
 
-DeclarationNode::DeclarationNode(std::string type, std::string name, ParserNode* value)
+DeclarationNode::DeclarationNode(std::string type, const Token &identifier, ParserNode* value)
+	: ParserNode(KIND), type(std::move(type)), name(identifier.text), id(identifier.symbol), value(value)
 {
-	this->type = type;
-	this->name = name;
-	this->value = value;
 }
 
 void DeclarationNode::print(int indent) 
@@ -97,9 +99,8 @@ void DeclarationNode::print(int indent)
 	}
 }
 
-VariableNode::VariableNode(Token varTok)
+VariableNode::VariableNode(const Token &varTok) : ParserNode(KIND), name(varTok.text), id(varTok.symbol)
 {
-    name = varTok.text;
 }
 
 void VariableNode::print(int indent) 
@@ -111,7 +112,7 @@ void VariableNode::print(int indent)
     std::cout << "Variable: " << name << "\n";
 }
 
-AssignmentNode::AssignmentNode(VariableNode *var, ParserNode *value) : var(var), value(value)
+AssignmentNode::AssignmentNode(VariableNode *var, ParserNode *value) : ParserNode(KIND), var(var), value(value)
 {
 
 }
@@ -127,7 +128,7 @@ void AssignmentNode::print(int indent)
     value->print(indent + 1);
 }
 
-IfNode::IfNode(ParserNode *condition, std::vector<ParserNode*> thenBranch, std::vector<ParserNode*> elseBranch) : condition(condition), thenBranch(thenBranch), elseBranch(elseBranch)
+IfNode::IfNode(ParserNode *condition, NodeList thenBranch, NodeList elseBranch) : ParserNode(KIND), condition(condition), thenBranch(std::move(thenBranch)), elseBranch(std::move(elseBranch))
 {
 
 }
@@ -169,20 +170,21 @@ void IfNode::print(int indent)
     }
 }  
 
-PrintNode::PrintNode(Token token)
+PrintNode::PrintNode(ParserNode *value) : ParserNode(KIND), value(value)
 {
-    this->token = token; // Assign token
+
 }
 
 void PrintNode::print(int indent)
 {
     for (int i = 0; i < indent; i++)
         std::cout << "  ";
-    std::cout << "Print: " << token.text << "\n";
+    std::cout << "Print:\n";
+    value->print(indent + 1);
 }
 
-CaseNode::CaseNode(ParserNode* value, std::vector<ParserNode*> body)
-    : value(value), body(body) {}
+CaseNode::CaseNode(ParserNode* value, NodeList body)
+    : ParserNode(KIND), value(value), body(std::move(body)) {}
 
 void CaseNode::print(int indent) {
     for (int i = 0; i < indent; i++) std::cout << "  ";
@@ -204,8 +206,8 @@ void BreakNode::print(int indent)
 	std::cout << "Break\n";
 }
     
-SwitchNode::SwitchNode(ParserNode* condition, std::vector<CaseNode*> cases)
-    : condition(condition), cases(cases) {}
+SwitchNode::SwitchNode(ParserNode* condition, ArenaVector<CaseNode*> cases)
+    : ParserNode(KIND), condition(condition), cases(std::move(cases)) {}
 
 void SwitchNode::print(int indent) {
     for (int i = 0; i < indent; i++) std::cout << "  ";
@@ -216,11 +218,16 @@ void SwitchNode::print(int indent) {
     for (auto& c : cases)
         c->print(indent + 1);
 }
-BooleanNode::BooleanNode(Token token) 
+BooleanNode::BooleanNode(const Token &token) : ParserNode(KIND)
 {
     value = (token.text == "true");
 }
 
+BooleanNode::BooleanNode(bool value) : ParserNode(KIND), value(value)
+{
+
+}
+
 void BooleanNode::print(int indent) 
 {
     for (int i = 0; i < indent; i++)
@@ -231,172 +238,140 @@ void BooleanNode::print(int indent)
     std::cout << "Boolean: " << (value ? "true" : "false") << "\n";
 }
 
-OperatorNode::OperatorNode(Token opTok)
+bool operatorFromText(std::string_view text, OperatorType &type)
 {
-    std::string op = opTok.text;
-    
-    if (op == "+")
-    {
-        type = OperatorType::Add;
-    }
-    else if (op == "-")
-    {
-        type = OperatorType::Subtract;
-    }
-    else if (op == "*")
-    {
-        type = OperatorType::Multiply;
-    }
-    else if (op == "/")
-    {
-        type = OperatorType::Divide;
-    }
-    else if (op == "%")
-    {
-        type = OperatorType::Modulus;
-    }
-    else if (op == "++")
-    {
-        type = OperatorType::Increment;
-    }
-    else if (op == "--")
-    {
-        type = OperatorType::Decrement;
-    }
-    else if (op == "=")
-    {
-        type = OperatorType::Equal;
-    }
-    else if (op == "!=")
-    {
-        type = OperatorType::NotEqual;
-    }
-    else if (op == "<")
-    {
-        type = OperatorType::LessThan;
-    }
-    else if (op == "<=")
-    {
-        type = OperatorType::LessThanEqualTo;
-    }
-    else if (op == ">")
-    {
-        type = OperatorType::GreaterThan;
-    }
-    else if (op == ">=")
-    {
-        type = OperatorType::GreaterThanEqualTo;
-    }
-    else if (op == "&&")
-    {
-        type = OperatorType::And;
-    }
-    else if (op == "||")
-    {
-        type = OperatorType::Or;
-    }
-    else if (op == "!")
-    {
-        type = OperatorType::Not;
+    // C* spelling of each operator, in OperatorType order
+    static const std::string_view spellings[] = {
+        "+", "-", "*", "/", "%", "++", "--",
+        "=", "!=", "<", "<=", ">", ">=",
+        "&&", "||", "!"
+    };
+    for (int i = 0; i <= OperatorType::Not; i++)
+    {
+        if (spellings[i] == text)
+        {
+            type = static_cast<OperatorType>(i);
+            return true;
+        }
     }
-    else
+    return false;
+}
+
+OperatorNode::OperatorNode(const Token &opTok) : ParserNode(KIND), type(Add)
+{
+    if (!operatorFromText(opTok.text, type))
     {
         std::cerr << "Invalid Operator: " << opTok.text << std::endl;
     }
 }
 
-std::string OperatorNode::getOperatorString()
+OperatorNode::OperatorNode(OperatorType type) : ParserNode(KIND), type(type)
 {
-    if (type == OperatorType::Add)
-    {
-        return "+";
-    }
-    else if (type == OperatorType::Subtract)
-    {
-        return "-";
-    }
-    else if (type == OperatorType::Multiply)
-    {
-        return "*";
-    }
-    else if (type == OperatorType::Divide)
-    {
-        return "/";
-    }
-    else if (type == OperatorType::Modulus)
-    {
-        return "%";
-    }
-    else if (type == OperatorType::Increment)
-    {
-        return "++";
-    }
-    else if (type == OperatorType::Decrement)
-    {
-        return "--";
-    }
-    else if (type == OperatorType::Equal)
-    {
-        return "==";
-    }
-    else if (type == OperatorType::NotEqual)
-    {
-        return "!=";
-    }
-    else if (type == OperatorType::LessThan)
-    {
-        return "<";
-    }
-    else if (type == OperatorType::LessThanEqualTo)
-    {
-        return "<=";
-    }
-    else if (type == OperatorType::GreaterThan)
-    {
-        return ">";
-    }
-    else if (type == OperatorType::GreaterThanEqualTo)
-    {
-        return ">=";
-    }
-    else if (type == OperatorType::And)
-    {
-        return "&&";
-    }
-    else if (type == OperatorType::Or)
-    {
-        return "||";
-    }
-    else if (type == OperatorType::Not)
-    {
-        return "!";
-    }
-    
-    // Base case (not sure if this should ever be called)
-    return "";
+
+}
+
+// C++ spelling of each operator, in OperatorType order
+const char *OperatorNode::getOperatorString() const
+{
+    static const char *const spellings[] = {
+        "+", "-", "*", "/", "%", "++", "--",
+        "==", "!=", "<", "<=", ">", ">=",
+        "&&", "||", "!"
+    };
+    static_assert(sizeof(spellings) / sizeof(spellings[0]) == OperatorType::Not + 1,
+                  "one spelling per OperatorType");
+    return spellings[type];
 }
 
-BinOpNode::BinOpNode(ParserNode *left, OperatorNode *op, ParserNode *right): left(left), op(op), right(right)
+BinOpNode::BinOpNode(ParserNode *left, OperatorNode *op, ParserNode *right) : ParserNode(KIND), left(left), op(op), right(right)
 {
 
 }
 
+namespace
+{
+
+// Expressions deeper than this print at this indent, so a long chain's
+// dump grows linearly with its length
+const int MAX_EXPRESSION_INDENT = 32;
+
+// Prints an expression from an explicit stack, so nesting costs no C++ stack
+void printExpression(ParserNode *root, int indent)
+{
+    struct Line
+    {
+        ParserNode *node;
+        OperatorNode *op; // "Operator:" line of a BinOp when set
+        int indent;
+    };
+    std::vector<Line> pending{{root, nullptr, indent}};
+    while (!pending.empty())
+    {
+        Line line = pending.back();
+        pending.pop_back();
+        if (line.node == nullptr && line.op == nullptr)
+            continue;
+        int column = std::min(line.indent, std::max(indent, MAX_EXPRESSION_INDENT));
+        auto bin = node_cast<BinOpNode>(line.node);
+        auto unary = node_cast<UnaryNode>(line.node);
+        if (line.op == nullptr && bin == nullptr && unary == nullptr)
+        {
+            line.node->print(column);
+            continue;
+        }
+
+        std::cout << std::setw(column * 2) << "";
+        if (line.op != nullptr)
+        {
+            std::cout << "Operator: " << line.op->getOperatorString() << "\n";
+        }
+        else if (bin != nullptr)
+        {
+            std::cout << "BinaryOperation:\n";
+            pending.push_back({bin->right, nullptr, line.indent + 1});
+            pending.push_back({nullptr, bin->op, line.indent + 1});
+            pending.push_back({bin->left, nullptr, line.indent + 1});
+        }
+        else
+        {
+            std::cout << "UnaryOperation: " << unary->op->getOperatorString() << "\n";
+            pending.push_back({unary->operand, nullptr, line.indent + 1});
+        }
+    }
+}
+
+} // namespace
+
 void BinOpNode::print(int indent)
 {
-    for (int i = 0; i < indent; i++)
-        std::cout << "  ";
+    printExpression(this, indent);
+}
+
+bool mayTrap(ParserNode *node)
+{
+    if (node == nullptr || node->kind == NodeKind::FunctionCall)
+        return true;
+    auto bin = node_cast<BinOpNode>(node);
+    if (bin == nullptr || (bin->op->type != Divide && bin->op->type != Modulus))
+        return false;
+    if (bin->exprType != nullptr && bin->exprType->isFloating())
+        return false;
+    auto divisor = node_cast<NumberNode>(bin->right);
+    return divisor == nullptr || divisor->type != NumberType::Int ||
+           divisor->value == 0 || divisor->value == -1;
+}
 
-    std::cout << "BinaryOperation:\n";
-    left->print(indent + 1);
+UnaryNode::UnaryNode(OperatorNode *op, ParserNode *operand) : ParserNode(KIND), op(op), operand(operand)
+{
 
-    for (int i = 0; i < indent + 1; i++) 
-        std::cout << "  ";
+}
 
-    std::cout << "Operator: " << op->getOperatorString() << "\n";
-    right->print(indent + 1);
+void UnaryNode::print(int indent)
+{
+    printExpression(this, indent);
 }
 
-StringNode::StringNode(Token str)
+StringNode::StringNode(const Token &str) : ParserNode(KIND)
 {
     value = str.text;
 }
@@ -409,11 +384,16 @@ void StringNode::print(int indent)
     std::cout << "String: " << value << "\n";
 }
 
-CharNode::CharNode(Token chr)
+CharNode::CharNode(const Token &chr) : ParserNode(KIND)
 {
     value = chr.text[0];
 }
 
+CharNode::CharNode(char value) : ParserNode(KIND), value(value)
+{
+
+}
+
 void CharNode::print(int indent) 
 {
     for (int i = 0; i < indent; i++) 
@@ -422,29 +402,69 @@ void CharNode::print(int indent)
     std::cout << "Char: " << value << "\n";
 }
 
-NumberNode::NumberNode(Token numTok)
+namespace
+{
+
+// Locale-independent and non-throwing. Out-of-range text falls back to
+// strtod/strtof, which give infinity on overflow and 0 or a denormal on
+// underflow; the parser reports the former.
+template <typename T>
+T parseNumber(std::string_view text)
 {
-    type = numTok.type;
-    if (numTok.text.back() == 'f')
+    T value = 0;
+    if (std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc::result_out_of_range)
     {
-        value = stof(numTok.text);
+        std::string copy(text);
+        value = std::is_same_v<T, float> ? std::strtof(copy.c_str(), nullptr) : std::strtod(copy.c_str(), nullptr);
+    }
+    return value;
+}
+
+} // namespace
+
+NumberNode::NumberNode(const Token &numTok) : ParserNode(KIND)
+{
+    std::string_view text = numTok.text;
+    if (numTok.type == TokenType::INTEGER_LITERAL)
+    {
+        // Exact up to INT64_MAX; anything larger is only known to be too big
+        type = NumberType::Int;
+        int64_t whole = 0;
+        bool fits = std::from_chars(text.data(), text.data() + text.size(), whole).ec == std::errc();
+        value = fits ? static_cast<double>(whole) : HUGE_VAL;
+    }
+    else if (text.back() == 'f')
+    {
+        type = NumberType::Float;
+        value = parseNumber<float>(text.substr(0, text.size() - 1));
     }
     else
     {
-        value = std::stod(numTok.text);
+        type = NumberType::Double;
+        value = parseNumber<double>(text);
     }
 }
 
+NumberNode::NumberNode(NumberType type, double value) : ParserNode(KIND), type(type), value(value)
+{
+
+}
+
 void NumberNode::print(int indent)
 {
     for (int i = 0; i < indent; i++)
         std::cout << "  ";
 
-    std::cout << "Number: " << value << "\n";
+    std::cout << "Number: ";
+    if (type == NumberType::Int)
+        std::cout << static_cast<int64_t>(value) << "\n";
+    else
+        std::cout << value << "\n";
 }
 
 
-Parser::Parser(std::vector<Token> &tokens): tokens(tokens), index(0)
+Parser::Parser(std::vector<Token> &tokens, AstArena &arena, std::ostream &diagnostics)
+    : tokens(tokens), arena(arena), diagnostics(diagnostics), index(0)
 {
 
 }
@@ -456,7 +476,7 @@ std::vector<ParserNode*> Parser::parse()
     std::vector<ParserNode*> nodes;
     while (index < tokens.size() - 1)
     {
-        debugPrint("Parsing statement at token: " + tokens[index].text, 1);
+        debugPrint("Parsing statement at token: " + std::string(tokens[index].text), 1);
         ParserNode *statement = parseStatement();
         if (statement != nullptr)
         {
@@ -465,7 +485,7 @@ std::vector<ParserNode*> Parser::parse()
         }
         else
         {
-            std::cerr << "Compilation stopped at token index " << index << ": " << tokens[index].text << std::endl;
+            diagnostics << "Compilation stopped at token index " << index << ": " << tokens[index].text << std::endl;
             break;
         }
     }
@@ -480,9 +500,8 @@ ParserNode* Parser::parseFunctionDeclaration()
     return nullptr;
 }
 
-WhileLoopNode::WhileLoopNode(ParserNode* condition, std::vector<ParserNode*> statements) : condition(condition) 
+WhileLoopNode::WhileLoopNode(ParserNode* condition, NodeList statements) : ParserNode(KIND), condition(condition), statements(std::move(statements))
 {
-    this->statements = statements;
 }
 
 void WhileLoopNode::print(int indent)  
@@ -515,119 +534,135 @@ ParserNode* Parser::parseWhileLoop() {
     index++;
 
     if (tokens[index].text != "(") {
-        std::cerr << "Expected '(' after 'while'\n";
+        diagnostics << "Expected '(' after 'while'\n";
         return nullptr;
     }
     index++;
 
     ParserNode* condition = logic();
+    if (condition == nullptr) {
+        return nullptr;
+    }
 
     if (tokens[index].text != ")") {
-        std::cerr << "Expected ')' after while condition\n";
+        diagnostics << "Expected ')' after while condition\n";
         return nullptr;
     }
     index++;
 
     if (tokens[index].text != "{") {
-        std::cerr << "Expected '{' to start while body\n";
+        diagnostics << "Expected '{' to start while body\n";
         return nullptr;
     }
 
-    std::vector<ParserNode*> body = parseBlock();
-    return new WhileLoopNode(condition, body);
+    NodeList body = parseBlock();
+    return arena.make<WhileLoopNode>(condition, std::move(body));
 }
 
 ParserNode* Parser::parseSwitch() {
     index++; // skip 'switch'
 
     if (tokens[index].text != "(") {
-        std::cerr << "Expected '('\n";
+        diagnostics << "Expected '('\n";
         return nullptr;
     }
     index++;
     ParserNode* condition = expression();
+    if (condition == nullptr) {
+        return nullptr;
+    }
     if (tokens[index].text != ")") {
-        std::cerr << "Expected ')'\n";
+        diagnostics << "Expected ')'\n";
         return nullptr;
     }
     index++;
 
     if (tokens[index].text != "{") {
-        std::cerr << "Expected '{' after switch condition\n";
+        diagnostics << "Expected '{' after switch condition\n";
         return nullptr;
     }
     index++; // skip '{'
 
-    std::vector<CaseNode*> caseList;
+    ArenaVector<CaseNode*> caseList = arena.list<CaseNode*>();
     while (tokens[index].text != "}") {
         if (tokens[index].text == "case") {
             index++; // skip 'case'
             if (tokens[index].text != "(") {
-                std::cerr << "Expected '(' after case\n";
+                diagnostics << "Expected '(' after case\n";
                 return nullptr;
             }
             index++; // skip '('
 
             ParserNode* value = logic(); // supports &&, =, etc.
+            if (value == nullptr) {
+                return nullptr;
+            }
 
             if (tokens[index].text != ")") {
-                std::cerr << "Expected ')' after case condition\n";
+                diagnostics << "Expected ')' after case condition\n";
                 return nullptr;
             }
             index++; // skip ')'
 
             if (tokens[index].text != ":") {
-                std::cerr << "Expected ':' after case(...)\n";
+                diagnostics << "Expected ':' after case(...)\n";
                 return nullptr;
             }
             index++;
 
-            std::vector<ParserNode*> caseBody;
+            NodeList caseBody = arena.list<ParserNode*>();
             while (tokens[index].text != "case" && tokens[index].text != "default" && tokens[index].text != "}") {
-                caseBody.push_back(parseStatement());
+                ParserNode* statement = parseStatement();
+                if (statement == nullptr) {
+                    return nullptr;
+                }
+                caseBody.push_back(statement);
             }
 
-            caseList.push_back(new CaseNode(value, caseBody));
+            caseList.push_back(arena.make<CaseNode>(value, std::move(caseBody)));
         }
         else if (tokens[index].text == "default") {
             index++; // skip 'default'
             if (tokens[index].text != ":") {
-                std::cerr << "Expected ':' after default\n";
+                diagnostics << "Expected ':' after default\n";
                 return nullptr;
             }
             index++;
 
-            std::vector<ParserNode*> caseBody;
+            NodeList caseBody = arena.list<ParserNode*>();
             while (tokens[index].text != "case" && tokens[index].text != "}" && tokens[index].text != "default") {
-                caseBody.push_back(parseStatement());
+                ParserNode* statement = parseStatement();
+                if (statement == nullptr) {
+                    return nullptr;
+                }
+                caseBody.push_back(statement);
             }
 
-            caseList.push_back(new CaseNode(nullptr, caseBody));
+            caseList.push_back(arena.make<CaseNode>(nullptr, std::move(caseBody)));
         }
         else {
-            std::cerr << "Expected 'case' or 'default'\n";
+            diagnostics << "Expected 'case' or 'default'\n";
             return nullptr;
         }
     }
 
     index++; // skip '}'
-    return new SwitchNode(condition, caseList);
+    return arena.make<SwitchNode>(condition, std::move(caseList));
 }
 
 ParserNode* Parser::parseDeclaration()
 {
 	debugPrint("Parsing declaration", 1);
 
-	std::string type = tokens[index].text;
+	std::string type(tokens[index].text);
 	index++;
 
 	Token identifier = tokens[index];
 	if (identifier.type != TokenType::IDENTIFIER)
 	{
-		std::cerr << "Expected variable name\n";
+		diagnostics << "Expected variable name\n";
 		return nullptr;
 	}
-	std::string varName = identifier.text;
 	index++;
 
 	ParserNode* value = nullptr;
@@ -637,16 +672,20 @@ ParserNode* Parser::parseDeclaration()
 	{
 		index++; // skip '='
 		value = expression();
+		if (value == nullptr)
+		{
+			return nullptr;
+		}
 	}
 
 	if (tokens[index].text != ";")
 	{
-		std::cerr << "Expected ';'\n";
+		diagnostics << "Expected ';'\n";
 		return nullptr;
 	}
 	index++;
 
-	return new DeclarationNode(type, varName, value);
+	return arena.make<DeclarationNode>(type, identifier, value);
 }
 
 ParserNode* Parser::parsePrint()
@@ -655,50 +694,43 @@ ParserNode* Parser::parsePrint()
 
     if (tokens[index].text != "print")
     {
-        std::cerr << "Unable to parse print statement\n";
+        diagnostics << "Unable to parse print statement\n";
         return nullptr;
     }
     index++;
 
     if (tokens[index].text != "(")
     {
-        std::cerr << "Expected '('\n";
+        diagnostics << "Expected '('\n";
         return nullptr;
     }
     index++;
 
-    debugPrint("Parsing expression for assignment", 2);
-    Token valueToken = tokens[index]; // Save token before parsing
-    ParserNode* value = expression(); // Still parse it for validation
-
-    if (!(valueToken.type == TokenType::STRING_LITERAL || 
-        valueToken.type == TokenType::CHAR_LITERAL ||
-        valueToken.type == TokenType::INTEGER_LITERAL ||
-        valueToken.type == TokenType::FLOAT_LITERAL ||
-        valueToken.type == TokenType::IDENTIFIER ||
-        valueToken.type == TokenType::BOOL_LITERAL)) 
+    debugPrint("Parsing expression to print", 2);
+    ParserNode* value = logic();
+    if (value == nullptr)
     {
-      std::cerr << "Invalid token type for print statement\n";
-      return nullptr;
+        diagnostics << "Invalid expression in print statement\n";
+        return nullptr;
     }
 
 
     debugPrint("Expression parsed", 2);
 
     if (tokens[index].text != ")") {
-        std::cerr << "Expected ')'\n";
+        diagnostics << "Expected ')'\n";
         return nullptr;
     }
     index++;
     if (tokens[index].text != ";")
     {
-        std::cerr << "Expected ';'";
+        diagnostics << "Expected ';'";
         return nullptr;
     }
     index++;
     
     debugPrint("Print statement complete", 1);
-    return new PrintNode(valueToken);
+    return arena.make<PrintNode>(value);
 }
 
 ParserNode* Parser::parseAssignment()
@@ -707,7 +739,7 @@ ParserNode* Parser::parseAssignment()
 
     if (tokens[index].text != "set")
     {
-        std::cerr << "Invalid assignment\n";
+        diagnostics << "Invalid assignment\n";
         return nullptr;
     }
     index++;
@@ -715,34 +747,38 @@ ParserNode* Parser::parseAssignment()
     Token varTok = tokens[index];
     if (varTok.type != TokenType::IDENTIFIER)
     {
-        std::cerr << "Invalid assignment\n";
+        diagnostics << "Invalid assignment\n";
         return nullptr;
     }
 
-    debugPrint("Variable to assign: " + varTok.text, 2);
-    VariableNode *var = new VariableNode(varTok);
+    debugPrint("Variable to assign: " + std::string(varTok.text), 2);
+    VariableNode *var = arena.make<VariableNode>(varTok);
     index++;
 
     if (tokens[index].text != "=") 
     {
-        std::cerr << "Expected '='\n";
+        diagnostics << "Expected '='\n";
         return nullptr;
     }
     index++;
 
     debugPrint("Parsing expression for assignment", 2);
     ParserNode *value = expression();
+    if (value == nullptr)
+    {
+        return nullptr;
+    }
     debugPrint("Expression parsed", 2);
 
     if (tokens[index].text != ";")
     {
-        std::cerr << "Expected ';'\n";
+        diagnostics << "Expected ';'\n";
         return nullptr;
     }
     index++;
 
     debugPrint("Created assignment node", 2);
-    return new AssignmentNode(var, value);
+    return arena.make<AssignmentNode>(var, value);
 }
 
 
@@ -781,31 +817,83 @@ ParserNode* Parser::parseStatement()
     {
         index++;
         if (tokens[index].text != ";") {
-            std::cerr << "Expected ';' after break\n";
+            diagnostics << "Expected ';' after break\n";
             return nullptr;
         }
         index++;
-        return new BreakNode();
+        return arena.make<BreakNode>();
     }
     else
     {
-        std::cerr << "Invalid statement at token index " << index << ": " << tokens[index].text << std::endl;
+        diagnostics << "Invalid statement at token index " << index << ": " << tokens[index].text << std::endl;
         return nullptr;
     }
 }
 
-std::vector<ParserNode*> Parser::parseBlock()
+// After a failed statement starting at token 'start', moves past it so the
+// enclosing block can carry on with the next statement. Braces are counted
+// from 'start', so a statement that failed inside its own body (a switch
+// case, say) is skipped up to its own closing '}', together with any
+// else/elif that follows. Stops in front of the '}' closing the enclosing
+// block.
+void Parser::skipStatement(int start)
+{
+    int errorIndex = index;
+    int last = static_cast<int>(tokens.size()) - 1;
+    int depth = 0;
+    index = start;
+    while (index < last)
+    {
+        std::string_view text = tokens[index].text;
+        if (text == "{")
+        {
+            depth++;
+        }
+        else if (text == "}")
+        {
+            if (depth == 0)
+            {
+                return;
+            }
+            depth--;
+            if (depth == 0 && index >= errorIndex && tokens[index + 1].text != "else" && tokens[index + 1].text != "elif")
+            {
+                index++;
+                return;
+            }
+        }
+        else if (text == ";" && depth == 0 && index >= errorIndex)
+        {
+            index++;
+            return;
+        }
+        index++;
+    }
+}
+
+NodeList Parser::parseBlock()
 {
     debugPrint("Parsing code block", 1);
     index++;
-    std::vector<ParserNode*> statements;
+    NodeList statements = arena.list<ParserNode*>();
 
     debugPrint("Parsing statements in block", 2);
-    while (tokens[index].text != "}")
+    int last = static_cast<int>(tokens.size()) - 1;
+    while (index < last && tokens[index].text != "}")
     {
-        statements.push_back(parseStatement());
+        int start = index;
+        ParserNode *statement = parseStatement();
+        if (statement == nullptr)
+        {
+            skipStatement(start);
+            continue;
+        }
+        statements.push_back(statement);
+    }
+    if (index < last)
+    {
+        index++;
     }
-    index++;
 
     debugPrint("Block complete with " + std::to_string(statements.size()) + " statements", 1);
     return statements;
@@ -817,39 +905,47 @@ IfNode* Parser::parseIf()
 
     if (tokens[index].text != "if" && tokens[index].text != "elif")
     {
-        std::cerr << "Unable to parse if statement\n";
+        diagnostics << "Unable to parse if statement\n";
         return nullptr;
     }
     index++;
 
     if (tokens[index].text != "(")
     {
-        std::cerr << "Expected '('\n";
+        diagnostics << "Expected '('\n";
         return nullptr;
     }
     index++;
 
     debugPrint("Parsing condition", 2);
     ParserNode *condition = logic();
+    if (condition == nullptr)
+    {
+        return nullptr;
+    }
     debugPrint("Condition parsed", 2);
 
     if (tokens[index].text != ")")
     {
-        std::cerr << "Expected ')'\n";
+        diagnostics << "Expected ')'\n";
         return nullptr;
     }
     index++;
 
     debugPrint("Parsing 'then' branch", 2);
-    std::vector<ParserNode*> thenBranch = parseBlock();
-    std::vector<ParserNode*> elseBranch;
+    NodeList thenBranch = parseBlock();
+    NodeList elseBranch = arena.list<ParserNode*>();
 
     if (tokens[index].text == "else") 
     {
         debugPrint("Parsing 'else' branch", 2);
         index++;
         if (tokens[index].text == "if") {
-            elseBranch.push_back(parseIf());  // recursive call for else-if
+            IfNode *elseIf = parseIf();  // recursive call for else-if
+            if (elseIf == nullptr) {
+                return nullptr;
+            }
+            elseBranch.push_back(elseIf);
         } else {
             elseBranch = parseBlock();  // regular else block
         }
@@ -857,145 +953,202 @@ IfNode* Parser::parseIf()
     else if (tokens[index].text == "elif")
     {
         debugPrint("Parsing 'elif' branch", 2);
-        elseBranch.push_back(parseIf()); 
+        IfNode *elif = parseIf();
+        if (elif == nullptr)
+        {
+            return nullptr;
+        }
+        elseBranch.push_back(elif);
     }
     debugPrint("If statement complete", 1);
-    return new IfNode(condition, thenBranch, elseBranch);
+    return arena.make<IfNode>(condition, std::move(thenBranch), std::move(elseBranch));
 }
 
-ParserNode* Parser::expression()
+namespace
 {
-    debugPrint("Parsing expression", 2);
-    ParserNode *left = term();
-    OperatorNode *op;
-    ParserNode *right;
 
-    while (tokens[index].type == TokenType::OPERATOR && (tokens[index].text == "+" || tokens[index].text == "-"))
-    {
-        debugPrint("Found operator: " + tokens[index].text, 3);
-        op = new OperatorNode(tokens[index]);
-        index++;
-        debugPrint("Parsing right side of binary operator", 3);
-        right = term();
+// Binding power of each binary operator, in OperatorType order; 0 = not
+// binary. && and || share a level and everything is left-associative, as
+// in the original recursive-descent grammar.
+const int binaryPrecedence[] = {
+    3, 3, 4, 4, 4, 0, 0, // + - * / % ++ --
+    2, 2, 2, 2, 2, 2,    // = != < <= > >=
+    1, 1, 0              // && || !
+};
+static_assert(sizeof(binaryPrecedence) / sizeof(binaryPrecedence[0]) == OperatorType::Not + 1,
+              "one precedence per OperatorType");
 
-        left = new BinOpNode(left, op, right);
-        debugPrint("Created binary operation node", 3);
-    }
+// Prefix operators bind tighter than any binary one
+const int UNARY_PRECEDENCE = 5;
 
-    return left;
+} // namespace
+
+ParserNode* Parser::expression()
+{
+    return parseExpression(3);
 }
 
-ParserNode* Parser::factor()
+ParserNode* Parser::logic()
 {
-    debugPrint("Parsing factor", 2);
-    Token currToken = tokens[index];
+    return parseExpression(1);
+}
 
-    if (currToken.type == TokenType::INTEGER_LITERAL || currToken.type == TokenType::FLOAT_LITERAL)
-    {
-        index++;
-        return new NumberNode(currToken);
-    }
-    else if (currToken.type == TokenType::STRING_LITERAL)
-    {
-        index++;
-        return new StringNode(currToken);
-    }
-    else if (currToken.type == TokenType::CHAR_LITERAL)
-    {
-        index++;
-        return new CharNode(currToken);
-    }
-    else if (currToken.type == TokenType::IDENTIFIER)
-    {
-        index++;
-        return new VariableNode(currToken);
-    }
-    else if (currToken.type == TokenType::BOOL_LITERAL)
-    {
-        index++;
-        return new BooleanNode(currToken);
-    }
-    else if (currToken.type == TokenType::PUNCTUATION)
-    {
-        index++;
-        ParserNode *node = expression();
-        if (tokens[index].type != TokenType::PUNCTUATION)
-        {
-            std::cerr << "Expected ')'\n";
-        }
-        index++;
-        return node;
-    }
-    else
+OperatorNode* Parser::operatorNode(OperatorType type)
+{
+    // Operator nodes are never modified, so every use shares one
+    if (operatorNodes[type] == nullptr)
     {
-        std::cerr << "Syntax Error\n";
-        return nullptr;
+        operatorNodes[type] = arena.make<OperatorNode>(type);
     }
+    return operatorNodes[type];
 }
 
-ParserNode* Parser::term()
+// Pops the top operator and its operand(s) into one node
+void Parser::reduce()
 {
-    debugPrint("Parsing term", 2);
+    PendingOperator op = operatorStack.back();
+    operatorStack.pop_back();
 
-    ParserNode *left = factor();
-    OperatorNode *op; 
-    ParserNode *right;
-    while (tokens[index].type == TokenType::OPERATOR && (tokens[index].text == "*" || tokens[index].text == "/" || tokens[index].text == "%"))
+    ParserNode *right = operandStack.back();
+    operandStack.pop_back();
+    if (op.unary)
     {
-        op = new OperatorNode(tokens[index]);
-        index++;
-        right = factor();
-
-        left = new BinOpNode(left, op, right);
+        operandStack.push_back(arena.make<UnaryNode>(operatorNode(op.type), right));
+        return;
     }
-
-    return left;
+    ParserNode *left = operandStack.back();
+    operandStack.back() = arena.make<BinOpNode>(left, operatorNode(op.type), right);
 }
 
-ParserNode* Parser::comparison()
+// Precedence climbing over explicit operand/operator stacks, so nesting
+// depth costs heap rather than C++ stack. Binary operators weaker
+// than minPrecedence end the expression unless they are inside parentheses.
+ParserNode* Parser::parseExpression(int minPrecedence)
 {
-    debugPrint("Parsing comparison", 2);
+    debugPrint("Parsing expression", 2);
+
+    // Only this call's entries are touched
+    size_t operandBase = operandStack.size();
+    size_t operatorBase = operatorStack.size();
+    int depth = 0;
+
+    // Drops this call's partial expression after an error
+    auto unwind = [&]() {
+        operandStack.resize(operandBase);
+        operatorStack.resize(operatorBase);
+    };
 
-    ParserNode *left = expression();
-    OperatorNode *op;
-    ParserNode *right;
+    auto reduceToParen = [&]() {
+        while (operatorStack.size() > operatorBase && !operatorStack.back().paren)
+        {
+            reduce();
+        }
+    };
 
-    while (tokens[index].type == TokenType::OPERATOR &&
-        (
-            tokens[index].text == "=" ||
-            tokens[index].text == "!=" ||
-            tokens[index].text == "<"  ||
-            tokens[index].text == "<=" ||
-            tokens[index].text == ">"  ||
-            tokens[index].text == ">="
-        )
-    ) 
+    while (true)
     {
-        op = new OperatorNode(tokens[index]);
-        index++;
-        right = expression();
+        // Operand position: prefix operators, '(' or a primary
+        const Token &tok = tokens[index];
+        OperatorType type;
+        if (tok.type == TokenType::OPERATOR && (tok.text == "-" || tok.text == "!"))
+        {
+            operatorFromText(tok.text, type);
+            operatorStack.push_back({type, true, false});
+            index++;
+            continue;
+        }
+        if (tok.type == TokenType::PUNCTUATION && tok.text == "(")
+        {
+            operatorStack.push_back({Add, false, true});
+            depth++;
+            index++;
+            continue;
+        }
 
-        left = new BinOpNode(left, op, right);
-    }
+        switch (tok.type)
+        {
+        case TokenType::INTEGER_LITERAL:
+        case TokenType::FLOAT_LITERAL: {
+            NumberNode *number = arena.make<NumberNode>(tok);
+            if (number->type == NumberType::Int && number->value > INT32_MAX)
+            {
+                // Every backend computes in 32-bit ints, so this cannot be
+                // given a value; the statement is dropped
+                diagnostics << "Number out of range: " << tok.text << "\n";
+                unwind();
+                return nullptr;
+            }
+            if (!std::isfinite(number->value))
+            {
+                diagnostics << "Number out of range: " << tok.text << "\n";
+            }
+            operandStack.push_back(number);
+            index++;
+            break;
+        }
+        case TokenType::STRING_LITERAL:
+            operandStack.push_back(arena.make<StringNode>(tok));
+            index++;
+            break;
+        case TokenType::CHAR_LITERAL:
+            operandStack.push_back(arena.make<CharNode>(tok));
+            index++;
+            break;
+        case TokenType::IDENTIFIER:
+            operandStack.push_back(arena.make<VariableNode>(tok));
+            index++;
+            break;
+        case TokenType::BOOL_LITERAL:
+            operandStack.push_back(arena.make<BooleanNode>(tok));
+            index++;
+            break;
+        default:
+            // Missing operand: drop this call's partial expression and leave
+            // the token for the caller, whose statement is then discarded
+            diagnostics << "Syntax Error\n";
+            unwind();
+            return nullptr;
+        }
 
-    return left;
-}
+        // Operator position: ')' closes a group, a binary operator continues
+        while (depth > 0 && tokens[index].type == TokenType::PUNCTUATION && tokens[index].text == ")")
+        {
+            reduceToParen();
+            operatorStack.pop_back();
+            depth--;
+            index++;
+        }
 
-ParserNode* Parser::logic()
-{
-    debugPrint("Parsing logic", 2);
+        const Token &next = tokens[index];
+        if (next.type != TokenType::OPERATOR || !operatorFromText(next.text, type))
+            break;
+        int precedence = binaryPrecedence[type];
+        if (precedence == 0 || (depth == 0 && precedence < minPrecedence))
+            break;
 
-    ParserNode *left = comparison();
-    OperatorNode *op; 
-    ParserNode *right;
-    while (tokens[index].type == TokenType::OPERATOR && (tokens[index].text == "&&" || tokens[index].text == "||"))
-    {
-        op = new OperatorNode(tokens[index]);
+        while (operatorStack.size() > operatorBase && !operatorStack.back().paren &&
+               (operatorStack.back().unary ? UNARY_PRECEDENCE : binaryPrecedence[operatorStack.back().type]) >= precedence)
+        {
+            reduce();
+        }
+        debugPrint("Found operator: " + std::string(next.text), 3);
+        operatorStack.push_back({type, false, false});
         index++;
-        right = comparison();
+    }
 
-        left = new BinOpNode(left, op, right);
+    // Unclosed groups are reported once each and closed here
+    while (operatorStack.size() > operatorBase)
+    {
+        if (operatorStack.back().paren)
+        {
+            diagnostics << "Expected ')'\n";
+            operatorStack.pop_back();
+            continue;
+        }
+        reduce();
     }
 
-    return left;
+    ParserNode *result = operandStack.back();
+    operandStack.resize(operandBase);
+    return result;
 }
@@ -5,18 +5,61 @@
 #include <string>
 #include <iostream>
 #include "tokenizer.h"
+#include "astArena.h"
 
 // Forward declaration
 class VariableNode;
+class ParserNode;
+struct Type;
+
+// Child lists are allocated from the same arena as the nodes
+using NodeList = ArenaVector<ParserNode*>;
+
+// One tag per concrete node class. Passes switch on it instead of trying
+// dynamic_casts; leave out the default case so -Wswitch flags any pass
+// that misses a newly added kind.
+enum class NodeKind : unsigned char
+{
+	WhileLoop,
+	FunctionDeclaration,
+	FunctionCall,
+	Declaration,
+	Variable,
+	Assignment,
+	If,
+	Print,
+	Boolean,
+	Operator,
+	BinOp,
+	Unary,
+	String,
+	Char,
+	Number,
+	Case,
+	Switch,
+	Break
+};
 
 // Base AST class
 class ParserNode
 {
 public:
+	const NodeKind kind;
+	bool typed = false;               // exprType is set, possibly to nullptr
+	const Type *exprType = nullptr;   // Filled in by SemanticAnalyzer; nullptr if unknown
+
+	explicit ParserNode(NodeKind kind) : kind(kind) {}
 	virtual void print(int indent = 0);
 	virtual ~ParserNode() = default;
 };
 
+// Checked downcast through the kind tag; nullptr if node is not a T
+template <typename T>
+T *node_cast(ParserNode *node)
+{
+	return (node != nullptr && node->kind == T::KIND) ? static_cast<T *>(node) : nullptr;
+}
+
 // Operator types
 enum OperatorType
 {
@@ -41,57 +84,73 @@ enum OperatorType
 class WhileLoopNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::WhileLoop;
+
 	ParserNode *condition;
-	std::vector<ParserNode*> statements;
+	NodeList statements;
 
-	WhileLoopNode(ParserNode *condition, std::vector<ParserNode*> statements);
+	WhileLoopNode(ParserNode *condition, NodeList statements);
 	void print(int indent = 0) override;
 };
 
 class FunctionDeclaration : public ParserNode
 {
 public:
-	std::string name;
-	std::vector<std::string> parameters;
-	std::vector<ParserNode*> body;
+	static constexpr NodeKind KIND = NodeKind::FunctionDeclaration;
+
+	std::string_view name;
+	SymbolId id;
+	std::vector<Token> parameters; // IDENTIFIER tokens
+	NodeList body;
 
-	FunctionDeclaration(std::string name, std::vector<std::string> parameters, std::vector<ParserNode*> body);
+	FunctionDeclaration(const Token &name, std::vector<Token> parameters, NodeList body);
 	void print(int indent = 0) override;
 };
 
 class FunctionCall : public ParserNode
 {
 public:
-	std::string name;
-	std::vector<ParserNode*> arguments;
+	static constexpr NodeKind KIND = NodeKind::FunctionCall;
 
-	FunctionCall(std::string name, std::vector<ParserNode*> arguments);
+	std::string_view name;
+	SymbolId id;
+	NodeList arguments;
+
+	FunctionCall(const Token &name, NodeList arguments);
 	void print(int indent = 0) override;
 };
 
 class DeclarationNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::Declaration;
+
 	std::string type;
-	std::string name;
+	std::string_view name; // Owned by the StringInterner
+	SymbolId id;
 	ParserNode* value = nullptr; // ✅ optional
 
-	DeclarationNode(std::string type, std::string name, ParserNode* value = nullptr);
+	DeclarationNode(std::string type, const Token &identifier, ParserNode* value = nullptr);
 	void print(int indent = 0) override;
 };
 
 class VariableNode : public ParserNode
 {
 public:
-	std::string name;
+	static constexpr NodeKind KIND = NodeKind::Variable;
+
+	std::string_view name; // Owned by the StringInterner
+	SymbolId id;
 
-	VariableNode(Token varTok);
+	VariableNode(const Token &varTok);
 	void print(int indent = 0) override;
 };
 
 class AssignmentNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::Assignment;
+
 	VariableNode *var;
 	ParserNode *value;
 
@@ -102,43 +161,58 @@ public:
 class IfNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::If;
+
 	ParserNode *condition;
-	std::vector<ParserNode*> thenBranch;
-	std::vector<ParserNode*> elseBranch;
+	NodeList thenBranch;
+	NodeList elseBranch;
 
-	IfNode(ParserNode *condition, std::vector<ParserNode*> thenBranch, std::vector<ParserNode*> elseBranch);
+	IfNode(ParserNode *condition, NodeList thenBranch, NodeList elseBranch);
 	void print(int indent = 0) override;
 };
 
 class PrintNode : public ParserNode
 {
 public:
-	Token token;
+	static constexpr NodeKind KIND = NodeKind::Print;
+
+	ParserNode *value; // Any expression; typed by the semantic analyzer
 
-	PrintNode(Token token);
+	PrintNode(ParserNode *value);
 	void print(int indent = 0) override;
 };
 
 class BooleanNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::Boolean;
+
 	bool value;
 
-	BooleanNode(Token token);
+	BooleanNode(const Token &token);
+	explicit BooleanNode(bool value);
 	void print(int indent = 0) override;
 };
 
 class OperatorNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::Operator;
+
 	OperatorType type;
-	OperatorNode(Token opTok);
-	std::string getOperatorString();
+	OperatorNode(const Token &opTok);
+	explicit OperatorNode(OperatorType type);
+	const char *getOperatorString() const;
 };
 
+// Maps operator text to its OperatorType ("=" is Equal); false if unknown
+bool operatorFromText(std::string_view text, OperatorType &type);
+
 class BinOpNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::BinOp;
+
 	ParserNode *left;
 	OperatorNode *op;
 	ParserNode *right;
@@ -147,31 +221,60 @@ public:
 	void print(int indent = 0) override;
 };
 
+// Prefix '-' (Subtract) or '!' (Not)
+class UnaryNode : public ParserNode
+{
+public:
+	static constexpr NodeKind KIND = NodeKind::Unary;
+
+	OperatorNode *op;
+	ParserNode *operand;
+
+	UnaryNode(OperatorNode *op, ParserNode *operand);
+	void print(int indent = 0) override;
+};
+
 class StringNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::String;
+
 	std::string value;
 
-	StringNode(Token str);
+	StringNode(const Token &str);
 	void print(int indent = 0) override;
 };
 
 class CharNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::Char;
+
 	char value;
 
-	CharNode(Token chr);
+	CharNode(const Token &chr);
+	explicit CharNode(char value);
 	void print(int indent = 0) override;
 };
 
+// C++ type of a numeric literal: 1, 1.5f, 1.5
+enum class NumberType : unsigned char
+{
+	Int,
+	Float,
+	Double
+};
+
 class NumberNode : public ParserNode
 {
 public:
-	TokenType type;
-	double value;
+	static constexpr NodeKind KIND = NodeKind::Number;
 
-	NumberNode(Token numTok);
+	NumberType type;
+	double value; // Exactly representable as a float when type is Float
+
+	NumberNode(const Token &numTok);
+	NumberNode(NumberType type, double value); // Computed literal
 	void print(int indent = 0) override;
 };
 
@@ -179,20 +282,24 @@ public:
 class CaseNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::Case;
+
 	ParserNode* value; // nullptr for default
-	std::vector<ParserNode*> body;
+	NodeList body;
 
-	CaseNode(ParserNode* value, std::vector<ParserNode*> body);
+	CaseNode(ParserNode* value, NodeList body);
 	void print(int indent = 0) override;
 };
 
 class SwitchNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::Switch;
+
 	ParserNode* condition;
-	std::vector<CaseNode*> cases;
+	ArenaVector<CaseNode*> cases;
 
-	SwitchNode(ParserNode* condition, std::vector<CaseNode*> cases);
+	SwitchNode(ParserNode* condition, ArenaVector<CaseNode*> cases);
 	void print(int indent = 0) override;
 };
 
@@ -200,29 +307,146 @@ public:
 class BreakNode : public ParserNode
 {
 public:
+	static constexpr NodeKind KIND = NodeKind::Break;
+
+	BreakNode() : ParserNode(KIND) {}
 	void print(int indent = 0) override;
 };
+
+// Nodes holding only pointers and scalars need no destructor record in the arena
+template <> struct ArenaSkipsDestructor<VariableNode> : std::true_type {};
+template <> struct ArenaSkipsDestructor<AssignmentNode> : std::true_type {};
+template <> struct ArenaSkipsDestructor<PrintNode> : std::true_type {};
+template <> struct ArenaSkipsDestructor<BooleanNode> : std::true_type {};
+template <> struct ArenaSkipsDestructor<OperatorNode> : std::true_type {};
+template <> struct ArenaSkipsDestructor<BinOpNode> : std::true_type {};
+template <> struct ArenaSkipsDestructor<UnaryNode> : std::true_type {};
+template <> struct ArenaSkipsDestructor<CharNode> : std::true_type {};
+template <> struct ArenaSkipsDestructor<NumberNode> : std::true_type {};
+template <> struct ArenaSkipsDestructor<BreakNode> : std::true_type {};
+
+// The i-th operand slot of an expression node, left to right: a BinOp's
+// left and right, a Unary's operand or a call's arguments; nullptr past the end
+inline ParserNode **operandSlot(ParserNode *node, size_t i)
+{
+	if (node == nullptr) return nullptr;
+	switch (node->kind)
+	{
+	case NodeKind::BinOp: {
+		auto bin = static_cast<BinOpNode *>(node);
+		return i == 0 ? &bin->left : i == 1 ? &bin->right : nullptr;
+	}
+	case NodeKind::Unary:
+		return i == 0 ? &static_cast<UnaryNode *>(node)->operand : nullptr;
+	case NodeKind::FunctionCall: {
+		auto &args = static_cast<FunctionCall *>(node)->arguments;
+		return i < args.size() ? &args[i] : nullptr;
+	}
+	case NodeKind::WhileLoop:
+	case NodeKind::FunctionDeclaration:
+	case NodeKind::Declaration:
+	case NodeKind::Variable:
+	case NodeKind::Assignment:
+	case NodeKind::If:
+	case NodeKind::Print:
+	case NodeKind::Boolean:
+	case NodeKind::Operator:
+	case NodeKind::String:
+	case NodeKind::Char:
+	case NodeKind::Number:
+	case NodeKind::Case:
+	case NodeKind::Switch:
+	case NodeKind::Break:
+		break;
+	}
+	return nullptr;
+}
+
+// Whether evaluating the node itself, once its operands are evaluated,
+// could fail at runtime: a call, or an integer '/' or '%' by anything but
+// a literal other than 0 and -1. Floating-point division never traps. Reads
+// the type SemanticAnalyzer left on the node; untyped nodes count as int.
+bool mayTrap(ParserNode *node);
+
+// Visits expression trees from an explicit stack, so nesting in any
+// direction costs heap rather than C++ stack. For every slot, enter(site)
+// runs first and returns whether to visit the node's operands; between(site)
+// runs after a BinOp's left operand; exit(site) runs last and may replace
+// *site. Callbacks may start nested walks. Keep one walker per pass so its
+// stack is reused.
+class ExpressionWalker
+{
+public:
+	template <typename Enter, typename Between, typename Exit>
+	void walk(ParserNode **root, Enter &&enter, Between &&between, Exit &&exit)
+	{
+		size_t base = stack.size();
+		stack.push_back({root, enter(root) ? 0 : SKIP});
+		while (stack.size() > base)
+		{
+			size_t top = stack.size() - 1;
+			Frame frame = stack[top];
+			ParserNode **child = frame.next != SKIP ? operandSlot(*frame.site, frame.next) : nullptr;
+			if (child == nullptr)
+			{
+				stack.pop_back();
+				exit(frame.site);
+				continue;
+			}
+			if (frame.next == 1 && (*frame.site)->kind == NodeKind::BinOp) between(frame.site);
+			stack[top].next++;
+			bool descend = enter(child);
+			stack.push_back({child, descend ? 0 : SKIP});
+		}
+	}
+
+private:
+	static constexpr size_t SKIP = static_cast<size_t>(-1);
+
+	struct Frame
+	{
+		ParserNode **site;
+		size_t next; // Operand to visit next, or SKIP
+	};
+	std::vector<Frame> stack;
+};
 // Parser class
 class Parser
 {
 private:
+	// Operator waiting on the expression stack; Not and Subtract can be prefix
+	struct PendingOperator
+	{
+		OperatorType type;
+		bool unary;
+		bool paren; // '(' marker rather than an operator
+	};
+
 	std::vector<Token> &tokens;
+	AstArena &arena;
+	std::ostream &diagnostics;
 	int index;
+	OperatorNode *operatorNodes[OperatorType::Not + 1] = {}; // Shared, one per type
+	std::vector<ParserNode*> operandStack;
+	std::vector<PendingOperator> operatorStack;
+
+	OperatorNode *operatorNode(OperatorType type);
+	void reduce();
 public:
-	Parser(std::vector<Token> &tokens);
+	// Syntax errors go to 'diagnostics'
+	Parser(std::vector<Token> &tokens, AstArena &arena, std::ostream &diagnostics = std::cerr);
 
 	std::vector<ParserNode*> parse();
 	ParserNode *parseDeclaration();
 	ParserNode *parseAssignment();
 	ParserNode *parsePrint();
 	ParserNode *parseStatement();
-	std::vector<ParserNode*> parseBlock();
+	NodeList parseBlock();
+	void skipStatement(int start);
 	IfNode *parseIf();
-	ParserNode *expression();
-	ParserNode *factor();
-	ParserNode *term();
-	ParserNode *comparison();
-	ParserNode *logic();
+	ParserNode *expression(); // Arithmetic only: + - * / % and prefix - !
+	ParserNode *logic();      // Also comparisons, && and ||
+	ParserNode *parseExpression(int minPrecedence);
 	ParserNode *parseFunctionDeclaration();
 	ParserNode *parseWhileLoop();
 	ParserNode *parseSwitch(); // switch/case support
@@ -0,0 +1,422 @@
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <chrono>
+#include <optional>
+#include <filesystem>
+#include "pipeline.h"
+#include "semanticAnalyzer.h"
+#include "tokenizer.h"
+#include "parser.h"
+#include "codegenerator.h"
+#include "ir.h"
+#include "nativeBackend.h"
+#include "sourceBuffer.h"
+#include "bytecodeVM.h"
+#include "optimizer.h"
+#include "compileCache.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+const char *const EXE_SUFFIX = ".exe";
+#else
+const char *const EXE_SUFFIX = "";
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+// Splits "tests\testcase1.cstar" into "tests\" and "testcase1"
+void splitInputPath(const std::string &inputPath, std::string &dir, std::string &base)
+{
+    size_t slash = inputPath.find_last_of("\\/");
+    std::string filename;
+    if (slash == std::string::npos)
+    {
+        dir = "";
+        filename = inputPath;
+    }
+    else
+    {
+        dir = inputPath.substr(0, slash + 1); // e.g. "tests\"
+        filename = inputPath.substr(slash + 1); // e.g. "testcase1.cstar"
+    }
+
+    size_t dot = filename.find_last_of('.');
+    base = (dot == std::string::npos) ? filename : filename.substr(0, dot);
+}
+
+// Run a shell command and copy everything it prints (stdout and stderr)
+// into the given stream, so concurrent compiles never interleave output
+int runCommand(const std::string &command, std::ostream &output)
+{
+    output.flush();
+    FILE *pipe = popen((command + " 2>&1").c_str(), "r");
+    if (!pipe) {
+        return -1;
+    }
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        output.write(buffer, static_cast<std::streamsize>(n));
+    }
+    return pclose(pipe);
+}
+
+// Command line that starts a program g++ built with "-o executable"
+std::string runnable(const std::string &executable)
+{
+#ifdef _WIN32
+    return executable + EXE_SUFFIX;
+#else
+    return executable.find('/') == std::string::npos ? "./" + executable : executable;
+#endif
+}
+
+double timedRun(const std::string &executable, std::ostream &output)
+{
+    auto start = std::chrono::steady_clock::now();
+    runCommand(runnable(executable), output);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void runProgram(const std::string &executable, std::ostream &out)
+{
+    out << "Running generated program:\n\n";
+    out << "\n\n\n\n==================================\n\n\n\n";
+    runCommand(runnable(executable), out);
+    out << "\n\nEnd of file!\n\n==================================\n\n\n\n";
+}
+
+// Profile-guided rebuild of an executable that compileCommand already built:
+// train an instrumented build on one run of the program, then rebuild with
+// the recorded profile. Runtimes of the plain and final builds are reported.
+bool buildWithProfile(const std::string &compileCommand, const std::string &executable,
+                      const std::string &profilePath, std::ostream &out, std::ostream &diagnostics,
+                      TimeReport &report)
+{
+    std::ostringstream programOutput;
+    std::optional<TimeReport::Phase> phase;
+    phase.emplace(report, "pgo_before");
+    double before = timedRun(executable, programOutput);
+
+    // Stale counters from an older build of the same program would be rejected.
+    // The instrumented program may run elsewhere, so give it an absolute path.
+    std::error_code ec;
+    std::string profileDir = fs::absolute(profilePath, ec).string();
+    fs::remove_all(profileDir, ec);
+    fs::create_directories(profileDir, ec);
+
+    phase.emplace(report, "pgo_gen");
+    if (runCommand(compileCommand + " -fprofile-generate=" + profileDir, diagnostics) != 0) {
+        diagnostics << "Instrumented compilation failed!\n";
+        return false;
+    }
+    phase.emplace(report, "pgo_train");
+    programOutput.str("");
+    timedRun(executable, programOutput);
+
+    phase.emplace(report, "pgo_use");
+    if (runCommand(compileCommand + " -fprofile-use=" + profileDir + " -fprofile-correction", diagnostics) != 0) {
+        diagnostics << "Profile-guided compilation failed!\n";
+        return false;
+    }
+    phase.emplace(report, "pgo_after");
+    programOutput.str("");
+    double after = timedRun(executable, programOutput);
+    phase.reset();
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3)
+        << "Profile-guided optimization: " << before << " ms before, " << after << " ms after";
+    if (after > 0) {
+        out << " (" << std::setprecision(2) << before / after << "x)";
+    }
+    out << "\nProfile data: " << profileDir << std::endl;
+    out.flags(flags);
+    return true;
+}
+
+} // namespace
+
+std::string BuildProfile::flags() const
+{
+    std::string result = optLevel;
+    if (!march.empty()) {
+        result += " -march=" + march;
+    }
+    if (lto) {
+        result += " -flto";
+    }
+    return result;
+}
+
+int compileFile(const std::string &inputPath, const CompileOptions &options,
+                std::ostream &out, std::ostream &diagnostics, TimeReport *timeReport)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    TimeReport localReport;
+    TimeReport &report = timeReport ? *timeReport : localReport;
+
+    // Tokens and the AST point into this buffer, keep it alive to the end
+    SourceBuffer source;
+    StringInterner names; // Identifier text for tokens and AST nodes
+    std::vector<Token> tokens;
+    std::optional<TimeReport::Phase> phase;
+    // The front end's only products are files, its diagnostics and the AST
+    // dump, so a cache hit replays those and skips every phase including g++.
+    // Reports that describe the front end itself need it to actually run.
+    bool cached = options.cache && !options.runMode && !options.optReport && !options.arenaStats && !options.emitIr
+        && !options.native;
+    phase.emplace(report, cached ? "cache" : "tokenize");
+    if (!source.open(inputPath)) {
+        diagnostics << "Failed to open file: " << inputPath << "\n";
+        return 1;
+    }
+
+    std::string dir, base;
+    splitInputPath(inputPath, dir, base);
+    // Prepend "_" to the basename, append "_output.cpp", and rejoin
+    std::string outputCpp = dir + "_" + base + "_output.cpp";
+    std::string executable = options.executable.empty() ? dir + "_" + base + "_output" : options.executable;
+
+    // Which g++ settings produced the run, so regressions can be traced to them
+    std::string buildFlags = options.profile.flags();
+    if (!options.runMode) {
+        report.setting("profile", buildFlags);
+    }
+
+    if (!options.runMode && options.pgo) {
+        report.setting("pgo", "on");
+    }
+    // Entries only hold an AST dump if their run printed one
+    std::string backendFlags = (options.optimize ? "opt " : "no-opt ") + buildFlags + (options.pgo ? " pgo" : "")
+        + (options.dumpAst ? " ast" : "");
+
+    std::string cacheKey;
+    std::ostringstream frontEndLog;
+    if (cached) {
+        // The runtime header is compiled into every program, so it is part of the key
+        SourceBuffer runtime;
+        runtime.open((fs::path(options.runtimeDir) / "cstar_runtime.h").string());
+        cacheKey = CompileCache::key(source.view(), backendFlags + '\0' + std::string(runtime.view()));
+        std::string cachedDiagnostics, cachedAst;
+        bool hit = options.cache->fetch(cacheKey, outputCpp, executable + EXE_SUFFIX, cachedDiagnostics, cachedAst);
+        phase->count("hit", hit ? 1 : 0);
+        if (hit) {
+            phase.reset();
+            diagnostics << cachedDiagnostics;
+            std::cout << cachedAst;
+            out << "C++ code written to: " << outputCpp << " (cached)" << std::endl;
+            if (options.runExecutable) {
+                runProgram(executable, out);
+            }
+            return 0;
+        }
+        phase.emplace(report, "tokenize");
+    }
+    std::ostream &frontEnd = cacheKey.empty() ? diagnostics : frontEndLog;
+
+    Tokenizer tokenizer(source.data(), source.size(), names, frontEnd);
+    Token token;
+    do
+    {
+        token = tokenizer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+
+    phase->count("tokens", tokens.size());
+    phase->count("source_bytes", source.size());
+    phase->count("identifiers", names.size());
+
+    // Owns every AST node; released in one shot after code generation
+    phase.emplace(report, "parse");
+    AstArena arena;
+    Parser parser(tokens, arena, frontEnd);
+    std::vector<ParserNode *> parserNodes = parser.parse();
+    phase->count("ast_nodes", arena.stats().objects);
+    phase->count("arena_bytes", arena.stats().bytesReserved);
+
+    phase.emplace(report, "semantic");
+    SemanticAnalyzer sem(frontEnd);
+    sem.analyze(parserNodes);
+    phase->count("symbol_lookups", sem.symbolLookups());
+    diagnostics << frontEndLog.str();
+
+    // Both backends consume the optimized tree
+    if (options.optimize) {
+        phase.emplace(report, "optimize");
+        ConstantFolder folder(arena);
+        folder.run(parserNodes);
+        DeadCodeEliminator eliminator(arena);
+        eliminator.run(parserNodes);
+        CommonSubexpressionEliminator cse(arena, names, sem);
+        cse.run(parserNodes);
+        phase->count("folded_expressions", folder.stats().foldedExpressions);
+        phase->count("propagated_uses", folder.stats().propagatedUses);
+        phase->count("removed_variables", eliminator.stats().unusedDeclarations);
+        phase->count("cse_temporaries", cse.stats().temporaries);
+        if (options.optReport) {
+            std::ostream &optReport = options.runMode ? diagnostics : out;
+            folder.printStats(optReport);
+            eliminator.printStats(optReport);
+            cse.printStats(optReport);
+        }
+    }
+
+    if (options.runMode) {
+        // out carries only the program's own output in this mode
+        auto lowerStart = std::chrono::steady_clock::now();
+        phase.emplace(report, "lower");
+        BytecodeProgram program;
+        BytecodeCompiler bytecodeCompiler(diagnostics);
+        if (!bytecodeCompiler.compile(parserNodes, program)) {
+            return 1;
+        }
+        phase->count("instructions", program.code.size());
+        phase->count("registers", program.registerCount);
+        auto vmStart = std::chrono::steady_clock::now();
+
+        phase.emplace(report, "execute");
+        VirtualMachine vm(out, diagnostics);
+        int exitCode = vm.run(program);
+        phase.reset();
+
+        if (options.runStats) {
+            using ms = std::chrono::duration<double, std::milli>;
+            diagnostics << "Front end: " << ms(lowerStart - startTime).count() << " ms\n";
+            diagnostics << "Lowering: " << ms(vmStart - lowerStart).count() << " ms ("
+                        << program.code.size() << " instructions, "
+                        << program.registerCount << " registers)\n";
+            if (vm.firstOutputMs() >= 0) {
+                diagnostics << "Time to first output: "
+                            << ms(vmStart - startTime).count() + vm.firstOutputMs() << " ms\n";
+            }
+            diagnostics << "Total: " << ms(std::chrono::steady_clock::now() - startTime).count() << " ms\n";
+        }
+        if (options.arenaStats) {
+            arena.printStats(diagnostics);
+        }
+        return exitCode;
+    }
+
+    std::ostringstream astDump;
+    if (options.dumpAst) {
+        phase.emplace(report, "ast_dump");
+        // Nodes print to std::cout; collect the dump for the cache entry.
+        // Only single-file runs dump, so no other thread is printing.
+        std::streambuf *stdoutBuffer = cacheKey.empty() ? nullptr : std::cout.rdbuf(astDump.rdbuf());
+        for (ParserNode *node : parserNodes)
+        {
+            node->print();
+            std::cout << std::endl;
+        }
+        if (stdoutBuffer != nullptr) {
+            std::cout.rdbuf(stdoutBuffer);
+            std::cout << astDump.str();
+        }
+    }
+
+    // The C++ backend reads the program as IR
+    phase.emplace(report, "ir");
+    IrProgram ir;
+    IrBuilder irBuilder(diagnostics);
+    if (!irBuilder.build(parserNodes, ir)) {
+        return 1;
+    }
+    phase->count("ir_blocks", ir.blocks.size());
+    phase->count("ir_instructions", ir.instructionCount());
+    if (options.emitIr) {
+        ir.print(out);
+        out << std::endl;
+    }
+
+    // The native backend turns the IR into the executable itself, no C++ file or g++
+    if (options.native) {
+        phase.emplace(report, "native");
+        NativeBackend backend;
+        std::vector<uint8_t> image = backend.compile(ir);
+        phase->count("code_bytes", backend.stats().codeBytes);
+        phase->count("spilled_registers", backend.stats().spilledRegisters);
+        std::ofstream binary(executable, std::ios::binary);
+        if (!binary.write(reinterpret_cast<const char *>(image.data()), image.size())) {
+            diagnostics << "Failed to write executable: " << executable << "\n";
+            return 1;
+        }
+        binary.close();
+        std::error_code error;
+        fs::permissions(executable, fs::perms::owner_exec | fs::perms::group_exec | fs::perms::others_exec,
+                        fs::perm_options::add, error);
+        phase.reset();
+        out << "Native executable written to: " << executable << std::endl;
+
+        if (options.arenaStats) {
+            arena.printStats(out);
+        }
+        arena.reset();
+        if (options.runExecutable) {
+            runProgram(executable, out);
+        }
+        return 0;
+    }
+
+    out << "Beginning code generation: \n\n\n";
+
+    // Code generation time!
+    std::ofstream outputFile(outputCpp);
+
+    if (!outputFile.is_open()) {
+        diagnostics << "Failed to open output file for writing.\n";
+        return 1;
+    }
+
+    // One pass over the whole program, straight into the output file
+    phase.emplace(report, "codegen");
+    CodeEmitter emitter(outputFile);
+    emitter.emitProgram(ir);
+    phase->count("emitted_bytes", static_cast<uint64_t>(outputFile.tellp()));
+    outputFile.close();
+    phase.reset();
+    out << "C++ code written to: " << outputCpp << std::endl;
+
+    if (options.arenaStats) {
+        arena.printStats(out);
+    }
+    arena.reset();
+
+    // Compile the generated file
+    std::string compileCommand = "g++ -std=c++17 " + buildFlags + " -I" + options.runtimeDir + " " + outputCpp + " -o " + executable;
+    phase.emplace(report, "g++");
+    int compileStatus = runCommand(compileCommand, diagnostics);
+    phase.reset();
+    if (compileStatus != 0) {
+        diagnostics << "Compilation failed!\n";
+        return 1;
+    }
+    if (options.pgo) {
+        // Profiles are kept under the cache entry's key and evicted with it.
+        // Every build retrains: buildWithProfile clears the directory first
+        std::string profileDir = !cacheKey.empty()
+            ? options.cache->profileDir(cacheKey)
+            : dir + "_" + base + "_pgo";
+        if (!buildWithProfile(compileCommand, executable, profileDir, out, diagnostics, report)) {
+            return 1;
+        }
+    }
+    if (!cacheKey.empty()) {
+        phase.emplace(report, "cache_store");
+        options.cache->store(cacheKey, outputCpp, executable + EXE_SUFFIX, frontEndLog.str(), astDump.str());
+        phase.reset();
+    }
+    if (options.runExecutable) {
+        runProgram(executable, out);
+    }
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <string>
+#include <iostream>
+#include "timeReport.h"
+
+class CompileCache;
+
+// How g++ builds the generated C++
+struct BuildProfile
+{
+	std::string optLevel = "-O0"; // -O0, -O1, -O2, -O3 or -Ofast
+	std::string march;            // e.g. "native"; empty = g++ default
+	bool lto = false;
+
+	// Flags for the g++ command line, e.g. "-O3 -march=native -flto"
+	std::string flags() const;
+};
+
+// Flags that shape one run of the pipeline
+struct CompileOptions
+{
+	bool arenaStats = false;
+	bool runMode = false;       // Execute in the bytecode VM instead of going through g++
+	bool runStats = false;
+	bool optimize = true;
+	bool optReport = false;
+	bool dumpAst = true;        // AST nodes print straight to std::cout
+	bool emitIr = false;        // Print the IR the C++ backend is generated from
+	bool native = false;        // Write an x86-64 ELF executable directly instead of going through g++
+	bool runExecutable = true;  // Run the g++ output after building it
+	std::string executable = "generated_output"; // empty = "_<base>_output" next to the input
+	BuildProfile profile;
+	std::string runtimeDir = "."; // where cstar_runtime.h lives, for -I
+	bool pgo = false;           // Rebuild with a profile from one training run
+	CompileCache *cache = nullptr; // null = always run the full pipeline and g++
+};
+
+// Full pipeline for one source file. Everything it touches is local to the
+// call and all text goes to the given streams, so several files can be
+// compiled concurrently on different threads.
+int compileFile(const std::string &inputPath, const CompileOptions &options,
+				std::ostream &out, std::ostream &diagnostics,
+				TimeReport *timeReport = nullptr);
+
+#endif // PIPELINE_H
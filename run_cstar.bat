@@ -2,7 +2,7 @@
 setlocal enabledelayedexpansion
 
 echo Compiling the compiler...
-g++ main.cpp codegenerator.cpp parser.cpp tokenizer.cpp semanticAnalyzer.cpp -o compiler
+g++ main.cpp codegenerator.cpp ir.cpp nativeBackend.cpp parser.cpp tokenizer.cpp semanticAnalyzer.cpp astArena.cpp sourceBuffer.cpp bytecodeVM.cpp optimizer.cpp timeReport.cpp pipeline.cpp batch.cpp compileCache.cpp stringInterner.cpp types.cpp -o compiler
 if errorlevel 1 (
     echo Compilation failed!
     pause
@@ -1,6 +1,43 @@
 #include "semanticAnalyzer.h"
 #include <iostream>
-#include <typeinfo>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// How each OperatorType is checked, in OperatorType order
+enum class OperatorCheck : unsigned char { Arithmetic, Integer, Comparison, Logical, None };
+
+const OperatorCheck operatorChecks[] = {
+    OperatorCheck::Arithmetic, OperatorCheck::Arithmetic, OperatorCheck::Arithmetic, // + - *
+    OperatorCheck::Arithmetic, OperatorCheck::Integer,                               // / %
+    OperatorCheck::None, OperatorCheck::None,                                        // ++ --
+    OperatorCheck::Comparison, OperatorCheck::Comparison, OperatorCheck::Comparison, // == != <
+    OperatorCheck::Comparison, OperatorCheck::Comparison, OperatorCheck::Comparison, // <= > >=
+    OperatorCheck::Logical, OperatorCheck::Logical, OperatorCheck::Logical           // && || !
+};
+static_assert(sizeof(operatorChecks) / sizeof(operatorChecks[0]) == OperatorType::Not + 1,
+              "one check per OperatorType");
+
+// float and double convert into each other implicitly, like in C++
+bool compatible(const Type *a, const Type *b) {
+    return a == b || (a->isFloating() && b->isFloating());
+}
+
+// A double literal, possibly negated, used directly as a float
+NumberNode *doubleLiteral(ParserNode *n) {
+    if (auto unary = node_cast<UnaryNode>(n)) {
+        if (unary->op->type != Subtract) return nullptr;
+        n = unary->operand;
+    }
+    auto num = node_cast<NumberNode>(n);
+    return (num != nullptr && num->type == NumberType::Double) ? num : nullptr;
+}
+
+} // namespace
+
+SemanticAnalyzer::SemanticAnalyzer(std::ostream &diagnostics)
+    : diagnostics(diagnostics), tables(diagnostics) {}
 
 void SemanticAnalyzer::analyze(const std::vector<ParserNode*> &asts) {
     tables.enterScope(); // global
@@ -8,69 +45,127 @@ void SemanticAnalyzer::analyze(const std::vector<ParserNode*> &asts) {
     tables.exitScope();
 }
 
+const Type *SemanticAnalyzer::typeOf(ParserNode *n) const {
+    return n != nullptr ? n->exprType : nullptr;
+}
+
 void SemanticAnalyzer::visit(ParserNode *node) {
-    if (auto d = dynamic_cast<DeclarationNode*>(node))     visitDecl(d);
-    else if (auto a = dynamic_cast<AssignmentNode*>(node)) visitAsgn(a);
-    else if (auto v = dynamic_cast<VariableNode*>(node))   visitVar(v);
-    else if (auto b = dynamic_cast<BinOpNode*>(node))      visitBinOp(b);
-    else if (auto i = dynamic_cast<IfNode*>(node))         visitIf(i);
-    else if (auto w = dynamic_cast<WhileLoopNode*>(node))  visitWhile(w);
-    else if (auto f = dynamic_cast<FunctionDeclaration*>(node)) visitFuncDecl(f);
-    else if (auto c = dynamic_cast<FunctionCall*>(node))   visitFuncCall(c);
+    if (node == nullptr) return; // statement that failed to parse
+
+    switch (node->kind) {
+    case NodeKind::Declaration:         visitDecl(static_cast<DeclarationNode*>(node)); break;
+    case NodeKind::Assignment:          visitAsgn(static_cast<AssignmentNode*>(node)); break;
+    case NodeKind::Variable:            visitVar(static_cast<VariableNode*>(node)); break;
+    case NodeKind::BinOp:               exprType(node); break;
+    case NodeKind::Unary:               exprType(node); break;
+    case NodeKind::If:                  visitIf(static_cast<IfNode*>(node)); break;
+    case NodeKind::WhileLoop:           visitWhile(static_cast<WhileLoopNode*>(node)); break;
+    case NodeKind::FunctionDeclaration: visitFuncDecl(static_cast<FunctionDeclaration*>(node)); break;
+    case NodeKind::FunctionCall:        visitFuncCall(static_cast<FunctionCall*>(node)); break;
+    case NodeKind::Print:               visitPrint(static_cast<PrintNode*>(node)); break;
     // literals / others: no action
+    case NodeKind::Boolean:
+    case NodeKind::Operator:
+    case NodeKind::String:
+    case NodeKind::Char:
+    case NodeKind::Number:
+    case NodeKind::Case:
+    case NodeKind::Switch:
+    case NodeKind::Break:
+        break;
+    }
 }
 
 void SemanticAnalyzer::visitDecl(DeclarationNode *d) {
-    tables.declare(d->type, d->name);
+    const Type *type = types::fromName(d->type);
+    if (d->value != nullptr) literalAs(d->value, exprType(d->value), type);
+    tables.declare(type, d->id, d->name);
 }
 
 void SemanticAnalyzer::visitAsgn(AssignmentNode *a) {
-    auto lhsType = tables.lookup(a->var->name);
-    if (lhsType.empty()) {
-        std::cerr << "Semantic error: use of undeclared variable '"
+    const Type *lhsType = tables.lookup(a->var->id);
+    if (lhsType == nullptr) {
+        diagnostics << "Semantic error: use of undeclared variable '"
                   << a->var->name << "'\n";
         return;
     }
-    auto rhsType = exprType(a->value);
-    if (rhsType.empty()) return;
-    if (lhsType != rhsType) {
-        std::cerr << "Type error: cannot assign '" << rhsType
-                  << "' to '" << lhsType << "'\n";
+    const Type *rhsType = literalAs(a->value, exprType(a->value), lhsType);
+    if (rhsType == nullptr) return;
+    if (!compatible(lhsType, rhsType)) {
+        diagnostics << "Type error: cannot assign '" << rhsType->name
+                  << "' to '" << lhsType->name << "'\n";
     }
 }
 
 void SemanticAnalyzer::visitVar(VariableNode *v) {
-    if (tables.lookup(v->name).empty()) {
-        std::cerr << "Semantic error: undeclared variable '"
+    if (!tables.contains(v->id)) {
+        diagnostics << "Semantic error: undeclared variable '"
                   << v->name << "'\n";
     }
 }
 
-void SemanticAnalyzer::visitBinOp(BinOpNode *b) {
-    auto lt = exprType(b->left), rt = exprType(b->right);
-    auto op = b->op->getOperatorString();
-    if (lt.empty() || rt.empty()) return;
-    if ((op=="+"||op=="-"||op=="*"||op=="/"||op=="%")) {
-        if ((lt!="int" && lt!="float") || rt!=lt) {
-            std::cerr << "Type error: operator '"<<op
-                      <<"' requires two numeric operands of same type\n";
+// Checks operand types and returns the result type of the operation.
+// Each child is typed exactly once, so long chains stay linear.
+const Type *SemanticAnalyzer::visitBinOp(BinOpNode *b) {
+    const Type *lt = exprType(b->left), *rt = exprType(b->right);
+    OperatorCheck check = operatorChecks[b->op->type];
+    if (check == OperatorCheck::Arithmetic || check == OperatorCheck::Comparison) {
+        rt = literalAs(b->right, rt, lt);
+        lt = literalAs(b->left, lt, rt);
+    }
+    bool arithmetic = check == OperatorCheck::Arithmetic || check == OperatorCheck::Integer;
+    const Type *result = arithmetic ? lt : &types::Bool;
+    if (lt == nullptr || rt == nullptr) return result;
+    switch (check) {
+    case OperatorCheck::Arithmetic:
+        if (!lt->isNumeric() || !compatible(lt, rt)) {
+            diagnostics << "Type error: operator '" << b->op->getOperatorString()
+                      << "' requires two numeric operands of same type\n";
+        } else if (rt == &types::Double) {
+            result = rt; // float op double is double
+        }
+        break;
+    case OperatorCheck::Integer:
+        if (lt != &types::Int || rt != &types::Int) {
+            diagnostics << "Type error: operator '" << b->op->getOperatorString()
+                      << "' requires two int operands\n";
         }
-    } else if (op=="="||op=="!="||op=="<"||op=="<="||op==">"||op==">=") {
-        if (lt!=rt) {
-            std::cerr << "Type error: comparison '"<<op
-                      <<"' between incompatible types\n";
+        break;
+    case OperatorCheck::Comparison:
+        if (!compatible(lt, rt)) {
+            diagnostics << "Type error: comparison '" << b->op->getOperatorString()
+                      << "' between incompatible types\n";
         }
-    } else if (op=="&&"||op=="||"||op=="!") {
-        if (lt!="bool" || rt!="bool") {
-            std::cerr << "Type error: logical '"<<op
-                      <<"' requires boolean operands\n";
+        break;
+    case OperatorCheck::Logical:
+        if (lt != &types::Bool || rt != &types::Bool) {
+            diagnostics << "Type error: logical '" << b->op->getOperatorString()
+                      << "' requires boolean operands\n";
         }
+        break;
+    case OperatorCheck::None:
+        break;
     }
+    return result;
+}
+
+const Type *SemanticAnalyzer::visitUnary(UnaryNode *u) {
+    const Type *t = exprType(u->operand);
+    if (u->op->type == Not) {
+        if (t != nullptr && t != &types::Bool) {
+            diagnostics << "Type error: logical '!' requires a boolean operand\n";
+        }
+        return &types::Bool;
+    }
+    if (t != nullptr && !t->isNumeric()) {
+        diagnostics << "Type error: operator '-' requires a numeric operand\n";
+    }
+    return t;
 }
 
 void SemanticAnalyzer::visitIf(IfNode *i) {
-    if (exprType(i->condition) != "bool") {
-        std::cerr << "Type error: if-condition not boolean\n";
+    if (exprType(i->condition) != &types::Bool) {
+        diagnostics << "Type error: if-condition not boolean\n";
     }
     tables.enterScope();
     for (auto stmt : i->thenBranch) visit(stmt);
@@ -83,50 +178,109 @@ void SemanticAnalyzer::visitIf(IfNode *i) {
 }
 
 void SemanticAnalyzer::visitWhile(WhileLoopNode *w) {
-    if (exprType(w->condition) != "bool") {
-        std::cerr << "Type error: while-condition not boolean\n";
+    if (exprType(w->condition) != &types::Bool) {
+        diagnostics << "Type error: while-condition not boolean\n";
     }
     tables.enterScope();
     for (auto stmt : w->statements) visit(stmt);
     tables.exitScope();
 }
 
+void SemanticAnalyzer::visitPrint(PrintNode *p) {
+    if (p->value->kind == NodeKind::Variable) {
+        visitVar(static_cast<VariableNode*>(p->value));
+    }
+    exprType(p->value);
+}
+
 void SemanticAnalyzer::visitFuncDecl(FunctionDeclaration *f) {
-    tables.declare("func", f->name);
+    tables.declare(&types::Function, f->id, f->name);
     tables.enterScope();
     for (auto &p : f->parameters)
-        tables.declare("param", p);
+        tables.declare(&types::Param, p.symbol, p.text);
     for (auto stmt : f->body) visit(stmt);
     tables.exitScope();
 }
 
 void SemanticAnalyzer::visitFuncCall(FunctionCall *c) {
-    if (tables.lookup(c->name).empty()) {
-        std::cerr << "Semantic error: call to undefined function '"
+    if (!tables.contains(c->id)) {
+        diagnostics << "Semantic error: call to undefined function '"
                   << c->name << "'\n";
     }
     for (auto arg : c->arguments) exprType(arg);
 }
 
-std::string SemanticAnalyzer::exprType(ParserNode *n) {
-    if (auto num = dynamic_cast<NumberNode*>(n)) {
-        return num->type==TokenType::FLOAT_LITERAL ? "float" : "int";
+// Double literals meeting a float become float literals (2.5 -> 2.5f), so
+// float code is not promoted to double arithmetic. Returns n's type.
+// A literal too large for a float is reported and stays a double.
+const Type *SemanticAnalyzer::literalAs(ParserNode *n, const Type *type, const Type *target) {
+    if (type != &types::Double || target != &types::Float) return type;
+    NumberNode *num = doubleLiteral(n);
+    if (num == nullptr) return type;
+    if (std::fabs(num->value) > std::numeric_limits<float>::max()) {
+        diagnostics << "Number out of range for float: " << num->value << "\n";
+        return type;
     }
-    if (auto str = dynamic_cast<StringNode*>(n)) { return "string"; }
-    if (auto ch  = dynamic_cast<CharNode*>(n))   { return "char";   }
-    if (auto b   = dynamic_cast<BooleanNode*>(n)){ return "bool";   }
-    if (auto v   = dynamic_cast<VariableNode*>(n)) {
-        return tables.lookup(v->name);
-    }
-    if (auto bin = dynamic_cast<BinOpNode*>(n)) {
-        visitBinOp(bin);
-        auto lt = exprType(bin->left), op = bin->op->getOperatorString();
-        if (op=="+"||op=="-"||op=="*"||op=="/"||op=="%") return lt;
-        return "bool";
-    }
-    if (auto call = dynamic_cast<FunctionCall*>(n)) {
-        visitFuncCall(call);
-        return "int"; // no return-type tracking yet
+    num->type = NumberType::Float;
+    num->value = static_cast<float>(num->value);
+    num->typed = n->typed = true;
+    num->exprType = n->exprType = target;
+    return target;
+}
+
+// Memoized on the node: every expression is typed once and read back
+// afterwards. Operands are typed before the node holding them, from the
+// walker's stack, so deep nesting does not recurse.
+const Type *SemanticAnalyzer::exprType(ParserNode *n) {
+    if (n == nullptr) return nullptr;
+    if (n->typed) return n->exprType;
+    walker.walk(&n,
+        [](ParserNode **site) { return *site != nullptr && !(*site)->typed; },
+        [](ParserNode **) {},
+        [this](ParserNode **site) {
+            ParserNode *node = *site;
+            if (node == nullptr || node->typed) return;
+            node->exprType = computeExprType(node); // Operands are already typed
+            node->typed = true;
+        });
+    return n->exprType;
+}
+
+const Type *SemanticAnalyzer::computeExprType(ParserNode *n) {
+    if (n == nullptr) return nullptr;
+
+    switch (n->kind) {
+    case NodeKind::Number:
+        switch (static_cast<NumberNode*>(n)->type) {
+        case NumberType::Int:    return &types::Int;
+        case NumberType::Float:  return &types::Float;
+        case NumberType::Double: return &types::Double;
+        }
+        break;
+    case NodeKind::String:  return &types::String;
+    case NodeKind::Char:    return &types::Char;
+    case NodeKind::Boolean: return &types::Bool;
+    case NodeKind::Variable:
+        return tables.lookup(static_cast<VariableNode*>(n)->id);
+    case NodeKind::BinOp:
+        return visitBinOp(static_cast<BinOpNode*>(n));
+    case NodeKind::Unary:
+        return visitUnary(static_cast<UnaryNode*>(n));
+    case NodeKind::FunctionCall:
+        visitFuncCall(static_cast<FunctionCall*>(n));
+        return &types::Int; // no return-type tracking yet
+    // statements are not expressions
+    case NodeKind::WhileLoop:
+    case NodeKind::FunctionDeclaration:
+    case NodeKind::Declaration:
+    case NodeKind::Assignment:
+    case NodeKind::If:
+    case NodeKind::Print:
+    case NodeKind::Operator:
+    case NodeKind::Case:
+    case NodeKind::Switch:
+    case NodeKind::Break:
+        break;
     }
-    return "";
+    return nullptr;
 }
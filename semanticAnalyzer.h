@@ -2,17 +2,28 @@
 #define SEMANTICANALYZER_H
 
 #include <vector>
-#include <string>
 #include "parser.h"
 #include "symbolTable.h"
+#include "types.h"
 
 class SemanticAnalyzer {
 public:
+    // Errors go to 'diagnostics'
+    explicit SemanticAnalyzer(std::ostream &diagnostics = std::cerr);
+
     // Analyze the AST, reporting any semantic errors
     void analyze(const std::vector<ParserNode*> &asts);
 
+    // Type computed for an expression node during analyze(); nullptr if unknown
+    const Type *typeOf(ParserNode *n) const;
+
+    // Symbol table lookups performed so far
+    size_t symbolLookups() const { return tables.lookupCount(); }
+
 private:
+    std::ostream &diagnostics;
     SymbolTableStack tables;
+    ExpressionWalker walker;
 
     // Dispatch to the right visitor
     void visit(ParserNode *node);
@@ -21,15 +32,18 @@ private:
     void visitDecl(DeclarationNode *d);
     void visitAsgn(AssignmentNode *a);
     void visitVar(VariableNode *v);
-    void visitBinOp(BinOpNode *b);
+    const Type *visitBinOp(BinOpNode *b);
+    const Type *visitUnary(UnaryNode *u);
     void visitIf(IfNode *i);
     void visitWhile(WhileLoopNode *w);
+    void visitPrint(PrintNode *p);
     void visitFuncDecl(FunctionDeclaration *f);
     void visitFuncCall(FunctionCall *c);
 
     // Helpers
-    std::string exprType(ParserNode *n);
+    const Type *exprType(ParserNode *n);
+    const Type *literalAs(ParserNode *n, const Type *type, const Type *target);
+    const Type *computeExprType(ParserNode *n);
 };
 
 #endif // SEMANTICANALYZER_H
-
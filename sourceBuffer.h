@@ -0,0 +1,39 @@
+#ifndef SOURCEBUFFER_H
+#define SOURCEBUFFER_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+// Read-only view of a whole source file, memory-mapped where possible.
+// Tokens produced from it point straight into the mapping, so it must
+// outlive the token vector and every AST built from it.
+class SourceBuffer
+{
+public:
+	SourceBuffer() = default;
+	~SourceBuffer();
+
+	SourceBuffer(const SourceBuffer &) = delete;
+	SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+	// Map the file; returns false if it cannot be opened
+	bool open(const std::string &path);
+	void close();
+
+	const char *data() const { return bytes; }
+	size_t size() const { return length; }
+	std::string_view view() const { return std::string_view(bytes, length); }
+
+private:
+	const char *bytes = "";
+	size_t length = 0;
+	bool mapped = false;
+	std::string fallback; // Used when mapping is unavailable (e.g. empty files)
+#ifdef _WIN32
+	void *fileHandle = nullptr;
+	void *mappingHandle = nullptr;
+#endif
+};
+
+#endif // SOURCEBUFFER_H
@@ -0,0 +1,78 @@
+#include <cstring>
+#include "stringInterner.h"
+
+namespace
+{
+
+constexpr size_t BLOCK_SIZE = 4096;
+
+// FNV-1a; identifiers are short, so this beats anything fancier
+uint32_t hashName(std::string_view text)
+{
+    uint32_t hash = 2166136261u;
+    for (char c : text)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
+
+StringInterner::StringInterner() : slots(64, NO_SYMBOL)
+{
+
+}
+
+SymbolId StringInterner::intern(std::string_view text)
+{
+    uint32_t hash = hashName(text);
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        SymbolId id = slots[i];
+        if (id == NO_SYMBOL)
+        {
+            id = static_cast<SymbolId>(names.size());
+            names.push_back(std::string_view(store(text), text.size()));
+            hashes.push_back(hash);
+            slots[i] = id;
+            // Keep the load factor at or below one half
+            if (names.size() * 2 > slots.size())
+                grow();
+            return id;
+        }
+        if (hashes[id] == hash && names[id] == text)
+            return id;
+    }
+}
+
+// Copies the text into the current block, starting a new one when it is full
+const char *StringInterner::store(std::string_view text)
+{
+    if (text.size() > blockSize - blockUsed)
+    {
+        blockSize = text.size() > BLOCK_SIZE ? text.size() : BLOCK_SIZE;
+        blocks.push_back(std::make_unique<char[]>(blockSize));
+        blockUsed = 0;
+    }
+    char *copy = blocks.back().get() + blockUsed;
+    if (!text.empty())
+        std::memcpy(copy, text.data(), text.size());
+    blockUsed += text.size();
+    return copy;
+}
+
+void StringInterner::grow()
+{
+    slots.assign(slots.size() * 2, NO_SYMBOL);
+    size_t mask = slots.size() - 1;
+    for (SymbolId id = 0; id < names.size(); id++)
+    {
+        size_t i = hashes[id] & mask;
+        while (slots[i] != NO_SYMBOL)
+            i = (i + 1) & mask;
+        slots[i] = id;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef STRINGINTERNER_H
+#define STRINGINTERNER_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Dense ID of an interned identifier
+using SymbolId = uint32_t;
+constexpr SymbolId NO_SYMBOL = UINT32_MAX;
+
+// Per-compilation identifier table. The tokenizer interns every identifier
+// once, handing out IDs 0, 1, 2, ... in order of first appearance; later
+// phases compare and index by ID and only go back to the text for output.
+// Each distinct name is stored exactly once, and the views returned by
+// name() stay valid for the interner's lifetime.
+class StringInterner
+{
+public:
+	StringInterner();
+	StringInterner(const StringInterner &) = delete;
+	StringInterner &operator=(const StringInterner &) = delete;
+
+	SymbolId intern(std::string_view text);
+	std::string_view name(SymbolId id) const { return names[id]; }
+	size_t size() const { return names.size(); }
+
+private:
+	std::vector<std::string_view> names; // Indexed by ID
+	std::vector<uint32_t> hashes;        // Indexed by ID, reused when growing
+	std::vector<SymbolId> slots;         // Open addressing, NO_SYMBOL = empty
+	std::vector<std::unique_ptr<char[]>> blocks;
+	size_t blockUsed = 0;
+	size_t blockSize = 0;
+
+	const char *store(std::string_view text);
+	void grow();
+};
+
+#endif // STRINGINTERNER_H
@@ -1,103 +1,88 @@
 #ifndef SYMBOLTABLE_H
 #define SYMBOLTABLE_H
 
-#include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 #include <iostream>
+#include "stringInterner.h"
+#include "types.h"
 
-// Single symbol entry
-struct Symbol {
-    std::string type;
-    std::string name;
-    Symbol() : type(""), name("") {}
-    Symbol(const std::string &type, const std::string &name)
-      : type(type), name(name) {}
-};
-
-class SymbolTable {
-public:
-    // add a new symbol; reports error and returns false on redeclaration
-    bool addSymbol(const std::string &type, const std::string &name) {
-        if (table.find(name) != table.end()) {
-            std::cerr << "Semantic error: redeclaration of '" << name << "'\n";
-            return false;
-        }
-        table[name] = Symbol(type, name);
-        return true;
-    }
-
-    // remove a symbol; reports error if not found
-    void deleteSymbol(const std::string &name) {
-        if (table.find(name) == table.end()) {
-            std::cerr << "Semantic error: delete of unknown variable '" << name << "'\n";
-            return;
-        }
-        table.erase(name);
-    }
-
-    // lookup a symbol’s type; empty string if not found
-    std::string lookup(const std::string &name) const {
-        auto it = table.find(name);
-        if (it != table.end()) return it->second.type;
-        return "";
-    }
-
-    // check existence without retrieving type
-    bool contains(const std::string &name) const {
-        return table.find(name) != table.end();
-    }
-
-private:
-    std::unordered_map<std::string, Symbol> table;
-};
-
+// Scoped symbol table in the LeBlanc-Cook style. There is one table for all
+// scopes: each SymbolId maps straight to its innermost binding, and every
+// binding links to the one it shadows. The bindings themselves form the
+// undo log, so leaving a scope pops its bindings and restores what they
+// shadowed. Lookups are O(1) at any nesting depth, and once the vectors
+// have grown, entering and leaving scopes never allocates.
 class SymbolTableStack {
 public:
+    // errors from every scope go to 'diagnostics'
+    explicit SymbolTableStack(std::ostream &diagnostics = std::cerr) : diagnostics(&diagnostics) {}
+
     // enter a new (inner) scope
     void enterScope() {
-        stack.emplace_back();
+        scopeStarts.push_back(bindings.size());
     }
 
-    // exit current scope
+    // exit current scope, unshadowing everything it declared
     void exitScope() {
-        if (!stack.empty()) stack.pop_back();
-    }
-
-    // declare in current scope
-    bool declare(const std::string &type, const std::string &name) {
-        if (stack.empty()) enterScope();
-        return stack.back().addSymbol(type, name);
+        if (scopeStarts.empty()) return;
+        size_t start = scopeStarts.back();
+        scopeStarts.pop_back();
+        while (bindings.size() > start) {
+            const Binding &b = bindings.back();
+            innermost[b.id] = b.shadowed;
+            bindings.pop_back();
+        }
     }
 
-    // delete from current scope
-    void deleteCurrent(const std::string &name) {
-        if (stack.empty()) {
-            std::cerr << "Semantic error: no scope to delete from\n";
-        } else {
-            stack.back().deleteSymbol(name);
+    // declare in current scope; reports error and returns false on redeclaration
+    bool declare(const Type *type, SymbolId id, std::string_view name) {
+        if (scopeStarts.empty()) enterScope();
+        if (id >= innermost.size()) innermost.resize(id + 1, NONE);
+        int32_t current = innermost[id];
+        if (current != NONE && static_cast<size_t>(current) >= scopeStarts.back()) {
+            *diagnostics << "Semantic error: redeclaration of '" << name << "'\n";
+            return false;
         }
+        innermost[id] = static_cast<int32_t>(bindings.size());
+        bindings.push_back({type, id, current});
+        return true;
     }
 
-    // lookup a name’s type from innermost to outermost; empty if not found
-    std::string lookup(const std::string &name) const {
-        for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
-            auto t = it->lookup(name);
-            if (!t.empty()) return t;
-        }
-        return "";
+    // lookup the type of the innermost binding; nullptr if not found
+    const Type *lookup(SymbolId id) const {
+        lookups++;
+        int32_t b = binding(id);
+        return b == NONE ? nullptr : bindings[b].type;
     }
 
     // check existence in any scope
-    bool contains(const std::string &name) const {
-        for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
-            if (it->contains(name)) return true;
-        }
-        return false;
+    bool contains(SymbolId id) const {
+        lookups++;
+        return binding(id) != NONE;
     }
 
+    // number of lookup/contains calls so far (for --time-report)
+    size_t lookupCount() const { return lookups; }
+
 private:
-    std::vector<SymbolTable> stack;
+    static constexpr int32_t NONE = -1;
+
+    struct Binding {
+        const Type *type;
+        SymbolId id;
+        int32_t shadowed; // Binding this one hides, or NONE
+    };
+
+    std::vector<Binding> bindings;   // Every live binding, outermost scope first
+    std::vector<int32_t> innermost;  // Indexed by SymbolId
+    std::vector<size_t> scopeStarts; // First binding of each open scope
+    std::ostream *diagnostics;
+    mutable size_t lookups = 0;
+
+    int32_t binding(SymbolId id) const {
+        return id < innermost.size() ? innermost[id] : NONE;
+    }
 };
 
 #endif // SYMBOLTABLE_H
@@ -50,7 +50,7 @@ if not exist "%GEN_CPP%" (
 )
 
 rem 3) compile the generated C++
-g++ -std=c++11 "%GEN_CPP%" -o "%TMPDIR%\%FNAME%.exe" >"%TMPDIR%\build.log" 2>&1
+g++ -std=c++17 -I. "%GEN_CPP%" -o "%TMPDIR%\%FNAME%.exe" >"%TMPDIR%\build.log" 2>&1
 if errorlevel 1 (
   echo   [FAIL] generated code failed to compile
   type "%TMPDIR%\build.log"
@@ -75,4 +75,19 @@ if errorlevel 1 (
   echo   [PASS]
 )
 
+rem 6) run the same script in the bytecode VM, no g++ involved
+"%COMPILER%" "%FULLPATH%" --run >"%TMPDIR%\vm.log" 2>"%TMPDIR%\vm_err.log"
+if errorlevel 1 (
+  echo   [FAIL] --run error
+  type "%TMPDIR%\vm_err.log"
+  goto :EOF
+)
+fc /N "%EXPECT%" "%TMPDIR%\vm.log" >nul
+if errorlevel 1 (
+  echo   [FAIL] --run output mismatch
+  fc /N "%EXPECT%" "%TMPDIR%\vm.log"
+) else (
+  echo   [PASS] --run
+)
+
 goto :EOF
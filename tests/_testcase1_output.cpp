@@ -1,27 +1,20 @@
 #include <iostream>
+#include <string>
+#include "cstar_runtime.h"
 
 int main() {
-
-    int a = 5;
-    
+    int a;
     int b;
-    
+    int mult;
+    int mod;
+    a = 5;
+    b = 0;
     b = (a + 10);
-    
-    std::cout << a << std::endl;
-    
-    std::cout << b << std::endl;
-    
-    int c = 10;
-    
-    int mult = (c * b);
-    
-    std::cout << mult << std::endl;
-    
+    cstar::print(a, "\n", b, "\n");
+    mult = (10 * b);
+    cstar::println(mult);
     a = 4;
-    
-    int mod = (a % 4);
-    
-    std::cout << mod << std::endl;
+    mod = (a % 4);
+    cstar::println(mod);
     return 0;
 }
@@ -1,23 +1,26 @@
 #include <iostream>
+#include <string>
+#include "cstar_runtime.h"
 
 int main() {
-
-    int i = 0;
-    
-    while ((i < 5)) {
-        switch (i) {
-          case 0:
-            std::cout << '0' << std::endl;
-            break;
-          case 1:
-            std::cout << "one" << std::endl;
-            break;
-          default:
-            break;
-        }
-        i = (i + 1);
+    int i;
+    i = 0;
+L1:
+    if (!(i < 5)) goto L6;
+    switch (i) {
+    case 0: goto L3;
+    case 1: goto L4;
+    default: goto L5;
     }
-    
-    std::cout << "All done!" << std::endl;
+L3:
+    cstar::print("0\n");
+    goto L5;
+L4:
+    cstar::print("one\n");
+L5:
+    i = (i + 1);
+    goto L1;
+L6:
+    cstar::print("All done!\n");
     return 0;
 }
@@ -0,0 +1,12 @@
+#include <iostream>
+#include <string>
+#include "cstar_runtime.h"
+
+int main() {
+    int count;
+    count = 4;
+    cstar::print((count + 1), "\nthen\n", ((count * 3) - 2), "\nx\n1\n");
+    count = (count + 3);
+    cstar::print((count % 5), "\n", ((count + 1) * 2), "\n", (count > 3), "\n", ((count == 3) && false), "\n");
+    return 0;
+}
@@ -0,0 +1,18 @@
+#include <iostream>
+#include <string>
+#include "cstar_runtime.h"
+
+int main() {
+    int x;
+    x = 2;
+    cstar::println(x);
+    if (!(x > 1)) goto L2;
+    cstar::print((x * 3), "\n99\n", x, "\n");
+L2:
+    if (!(x > 0)) goto L4;
+    x = (x - 1);
+    goto L2;
+L4:
+    cstar::println((x - 1));
+    return 0;
+}
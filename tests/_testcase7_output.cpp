@@ -0,0 +1,13 @@
+#include <iostream>
+#include <string>
+#include "cstar_runtime.h"
+
+int main() {
+    std::string s;
+    s = "tab:\t|";
+    cstar::print(s, "\ntwo\nlines\nback\\slash\noctal \101 and hex \x42\n");
+    if (!(std::string("\x41\102") == "AB")) goto L2;
+    cstar::print("escapes compare decoded\n");
+L2:
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <utility>
+#include "timeReport.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+
+std::atomic<uint64_t> allocations{0};
+std::atomic<uint64_t> allocationBytes{0};
+
+// Phase names and counter names are plain identifiers, but quote safely anyway
+void writeJsonString(std::ostream &out, const std::string &text)
+{
+    out << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        }
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+// Counting replacements for the global allocation functions. The array
+// and sized forms forward to these, so every heap allocation is seen.
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size != 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+uint64_t TimeReport::allocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t TimeReport::allocatedBytes()
+{
+    return allocationBytes.load(std::memory_order_relaxed);
+}
+
+uint64_t TimeReport::peakRssKb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize / 1024;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss) / 1024; // bytes on macOS
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss); // kilobytes on Linux
+#endif
+#endif
+}
+
+TimeReport::TimeReport() : created(std::chrono::steady_clock::now())
+{
+
+}
+
+double TimeReport::totalMs() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - created).count();
+}
+
+TimeReport::Phase::Phase(TimeReport &report, std::string name)
+    : report(report), start(std::chrono::steady_clock::now()),
+      startAllocations(allocationCount()), startBytes(allocatedBytes())
+{
+    record.name = std::move(name);
+}
+
+TimeReport::Phase::~Phase()
+{
+    record.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    record.allocations = allocationCount() - startAllocations;
+    record.allocatedBytes = allocatedBytes() - startBytes;
+    record.peakRssKb = peakRssKb();
+    report.records.push_back(std::move(record));
+}
+
+void TimeReport::setting(std::string name, std::string value)
+{
+    for (auto &entry : settings)
+    {
+        if (entry.first == name)
+        {
+            entry.second = std::move(value);
+            return;
+        }
+    }
+    settings.emplace_back(std::move(name), std::move(value));
+}
+
+void TimeReport::Phase::count(std::string name, uint64_t value)
+{
+    record.counters.push_back({std::move(name), value});
+}
+
+void TimeReport::printTable(std::ostream &out) const
+{
+    std::ios::fmtflags flags = out.flags();
+    out << "\n===== TIME REPORT =====\n";
+    for (const auto &entry : settings)
+        out << entry.first << ": " << entry.second << "\n";
+    out << std::left << std::setw(12) << "Phase" << std::right
+        << std::setw(12) << "Time (ms)" << std::setw(10) << "Allocs"
+        << std::setw(14) << "Alloc bytes" << std::setw(14) << "Peak RSS KB"
+        << "  Counters\n";
+
+    double phaseTotal = 0;
+    for (const PhaseRecord &phase : records)
+    {
+        phaseTotal += phase.ms;
+        out << std::left << std::setw(12) << phase.name << std::right
+            << std::setw(12) << std::fixed << std::setprecision(3) << phase.ms
+            << std::setw(10) << phase.allocations << std::setw(14) << phase.allocatedBytes
+            << std::setw(14) << phase.peakRssKb << " ";
+        for (const Counter &counter : phase.counters)
+            out << " " << counter.name << "=" << counter.value;
+        out << "\n";
+    }
+
+    double total = totalMs();
+    out << std::left << std::setw(12) << "(other)" << std::right
+        << std::setw(12) << std::fixed << std::setprecision(3) << total - phaseTotal << "\n";
+    out << std::left << std::setw(12) << "Total" << std::right
+        << std::setw(12) << total << std::setw(10) << allocationCount()
+        << std::setw(14) << allocatedBytes() << std::setw(14) << peakRssKb() << "\n";
+    out.flags(flags);
+}
+
+void TimeReport::printJson(std::ostream &out) const
+{
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"settings\":{";
+    for (size_t i = 0; i < settings.size(); i++)
+    {
+        out << (i > 0 ? "," : "");
+        writeJsonString(out, settings[i].first);
+        out << ":";
+        writeJsonString(out, settings[i].second);
+    }
+    out << "},\"phases\":[";
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const PhaseRecord &phase = records[i];
+        out << (i > 0 ? "," : "") << "{\"name\":";
+        writeJsonString(out, phase.name);
+        out << ",\"ms\":" << phase.ms
+            << ",\"allocations\":" << phase.allocations
+            << ",\"allocated_bytes\":" << phase.allocatedBytes
+            << ",\"peak_rss_kb\":" << phase.peakRssKb
+            << ",\"counters\":{";
+        for (size_t j = 0; j < phase.counters.size(); j++)
+        {
+            out << (j > 0 ? "," : "");
+            writeJsonString(out, phase.counters[j].name);
+            out << ":" << phase.counters[j].value;
+        }
+        out << "}}";
+    }
+    out << "],\"total_ms\":" << totalMs()
+        << ",\"allocations\":" << allocationCount()
+        << ",\"allocated_bytes\":" << allocatedBytes()
+        << ",\"peak_rss_kb\":" << peakRssKb() << "}\n";
+    out.flags(flags);
+}
@@ -0,0 +1,75 @@
+#ifndef TIMEREPORT_H
+#define TIMEREPORT_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+
+// Per-phase instrumentation for --time-report: wall time, heap allocations
+// (every operator new in the process is counted) and peak RSS, plus any
+// counters a phase adds (tokens, AST nodes, emitted bytes, ...).
+class TimeReport
+{
+public:
+	struct Counter
+	{
+		std::string name;
+		uint64_t value;
+	};
+
+	struct PhaseRecord
+	{
+		std::string name;
+		double ms = 0;
+		uint64_t allocations = 0;    // operator new calls during the phase
+		uint64_t allocatedBytes = 0; // bytes requested by those calls
+		uint64_t peakRssKb = 0;      // process high-water mark when the phase ended
+		std::vector<Counter> counters;
+	};
+
+	// Times one phase from construction to destruction
+	class Phase
+	{
+	public:
+		Phase(TimeReport &report, std::string name);
+		~Phase();
+
+		Phase(const Phase &) = delete;
+		Phase &operator=(const Phase &) = delete;
+
+		void count(std::string name, uint64_t value);
+
+	private:
+		TimeReport &report;
+		PhaseRecord record;
+		std::chrono::steady_clock::time_point start;
+		uint64_t startAllocations;
+		uint64_t startBytes;
+	};
+
+	TimeReport();
+
+	// Build settings the run used, printed above the phases
+	void setting(std::string name, std::string value);
+
+	const std::vector<PhaseRecord> &phases() const { return records; }
+	void printTable(std::ostream &out) const;
+	void printJson(std::ostream &out) const;
+
+	// Process-wide figures, also usable outside a phase
+	static uint64_t allocationCount();
+	static uint64_t allocatedBytes();
+	static uint64_t peakRssKb(); // 0 where the platform cannot tell
+
+private:
+	std::vector<PhaseRecord> records;
+	std::vector<std::pair<std::string, std::string>> settings;
+	std::chrono::steady_clock::time_point created;
+
+	double totalMs() const;
+};
+
+#endif // TIMEREPORT_H
@@ -2,56 +2,168 @@
 #include <string>
 #include <vector>
 #include <sstream>
-#include <set>
-#include <algorithm>
-#include <cctype>
+#include <array>
+#include <cstdint>
 #include "tokenizer.h"
 #include "parser.h"
 
 // Lexical Specification Data
+// All tables below are built at compile time: words are classified through
+// a perfect hash (one probe, one compare) and characters through a
+// 256-entry class table, so classifying a token never allocates.
 
-const std::set<std::string> KEYWORDS = {
-    "if", "elif", "else", "switch", "case", "default",
-    "while", "for", "break", "continue", "return", "set",
-    "class", "struct", "interface", "private", "protected",
-    "public", "static", "true", "false", "const",
-    "int", "float", "double", "char", "bool", "void",
-    "string", "new", "base", "extends","print"};
+namespace
+{
+
+struct WordEntry
+{
+    std::string_view text;
+    TokenType type;
+};
 
-const std::set<std::string> DATA_TYPES = {"int", "float", "double", "char", "bool", "void", "string"};
+constexpr WordEntry KEYWORDS[] = {
+    {"if", TokenType::KEYWORD}, {"elif", TokenType::KEYWORD}, {"else", TokenType::KEYWORD},
+    {"switch", TokenType::KEYWORD}, {"case", TokenType::KEYWORD}, {"default", TokenType::KEYWORD},
+    {"while", TokenType::KEYWORD}, {"for", TokenType::KEYWORD}, {"break", TokenType::KEYWORD},
+    {"continue", TokenType::KEYWORD}, {"return", TokenType::KEYWORD}, {"set", TokenType::KEYWORD},
+    {"class", TokenType::KEYWORD}, {"struct", TokenType::KEYWORD}, {"interface", TokenType::KEYWORD},
+    {"private", TokenType::KEYWORD}, {"protected", TokenType::KEYWORD}, {"public", TokenType::KEYWORD},
+    {"static", TokenType::KEYWORD}, {"const", TokenType::KEYWORD}, {"new", TokenType::KEYWORD},
+    {"base", TokenType::KEYWORD}, {"extends", TokenType::KEYWORD}, {"print", TokenType::KEYWORD},
+    {"true", TokenType::BOOL_LITERAL}, {"false", TokenType::BOOL_LITERAL},
+    // Data types are a subset of the keywords
+    {"int", TokenType::DATA_TYPE}, {"float", TokenType::DATA_TYPE}, {"double", TokenType::DATA_TYPE},
+    {"char", TokenType::DATA_TYPE}, {"bool", TokenType::DATA_TYPE}, {"void", TokenType::DATA_TYPE},
+    {"string", TokenType::DATA_TYPE}};
 
 // Note: Ambiguity of '=' handled by listing it here. 'set' is treated as keyword.
-const std::set<std::string> OPERATORS = {
-    "+",
-    "-",
-    "*",
-    "/",
-    "%",
-    "++",
-    "--",
-    "=",
-    "!=",
-    "<",
-    ">",
-    "<=",
-    ">=",
-    "&&",
-    "||",
-    "!",
-    ".",
+constexpr WordEntry OPERATORS[] = {
+    {"+", TokenType::OPERATOR}, {"-", TokenType::OPERATOR}, {"*", TokenType::OPERATOR},
+    {"/", TokenType::OPERATOR}, {"%", TokenType::OPERATOR}, {"++", TokenType::OPERATOR},
+    {"--", TokenType::OPERATOR}, {"=", TokenType::OPERATOR}, {"!=", TokenType::OPERATOR},
+    {"<", TokenType::OPERATOR}, {">", TokenType::OPERATOR}, {"<=", TokenType::OPERATOR},
+    {">=", TokenType::OPERATOR}, {"&&", TokenType::OPERATOR}, {"||", TokenType::OPERATOR},
+    {"!", TokenType::OPERATOR}, {".", TokenType::OPERATOR}};
+
+constexpr std::string_view PUNCTUATION = ";(){},:";
+constexpr std::string_view OPERATOR_START = "+-*/%<>=!&|.";
+
+// Seeded FNV-1a folded down to the table size (a power of two)
+constexpr uint32_t wordHash(std::string_view text, uint32_t seed, uint32_t mask)
+{
+    uint32_t h = 2166136261u ^ seed;
+    for (char c : text)
+    {
+        h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return (h ^ (h >> 15)) & mask;
+}
+
+template <size_t Size>
+struct PerfectHashTable
+{
+    uint32_t seed = 0;
+    std::array<WordEntry, Size> slots{};
+
+    const WordEntry &find(std::string_view text) const
+    {
+        return slots[wordHash(text, seed, Size - 1)];
+    }
+};
+
+// Tries seeds until every word lands in its own slot
+template <size_t Size, size_t N>
+constexpr PerfectHashTable<Size> buildPerfectHash(const WordEntry (&words)[N])
+{
+    static_assert((Size & (Size - 1)) == 0, "table size must be a power of two");
+    PerfectHashTable<Size> table;
+    for (uint32_t seed = 1; seed < 100000; seed++)
+    {
+        table.seed = seed;
+        table.slots = {};
+        bool collision = false;
+        for (size_t i = 0; i < N && !collision; i++)
+        {
+            WordEntry &slot = table.slots[wordHash(words[i].text, seed, Size - 1)];
+            collision = !slot.text.empty();
+            slot = words[i];
+        }
+        if (!collision)
+            return table;
+    }
+    table.seed = 0; // Reported by the static_asserts below
+    return table;
+}
+
+constexpr auto KEYWORD_TABLE = buildPerfectHash<128>(KEYWORDS);
+constexpr auto OPERATOR_TABLE = buildPerfectHash<64>(OPERATORS);
+static_assert(KEYWORD_TABLE.seed != 0, "no perfect hash found for KEYWORDS");
+static_assert(OPERATOR_TABLE.seed != 0, "no perfect hash found for OPERATORS");
+
+// Character classes, one byte per possible char value
+enum CharClass : uint8_t
+{
+    CC_SPACE = 1 << 0,
+    CC_DIGIT = 1 << 1,
+    CC_IDENT_START = 1 << 2, // letter or '_'
+    CC_IDENT = 1 << 3,       // letter, digit or '_'
+    CC_OPERATOR = 1 << 4,    // may start an operator
+    CC_PUNCT = 1 << 5
 };
 
-const std::set<char> PUNCTUATION = {';', '(', ')', '{', '}', ',', ':'};
+constexpr std::array<uint8_t, 256> buildCharClasses()
+{
+    std::array<uint8_t, 256> classes{};
+    for (unsigned c : std::string_view(" \t\n\v\f\r"))
+        classes[c] |= CC_SPACE;
+    for (unsigned c = '0'; c <= '9'; c++)
+        classes[c] |= CC_DIGIT | CC_IDENT;
+    for (unsigned c = 'a'; c <= 'z'; c++)
+        classes[c] |= CC_IDENT_START | CC_IDENT;
+    for (unsigned c = 'A'; c <= 'Z'; c++)
+        classes[c] |= CC_IDENT_START | CC_IDENT;
+    classes['_'] |= CC_IDENT_START | CC_IDENT;
+    for (unsigned char c : OPERATOR_START)
+        classes[c] |= CC_OPERATOR;
+    for (unsigned char c : PUNCTUATION)
+        classes[c] |= CC_PUNCT;
+    return classes;
+}
+
+constexpr std::array<uint8_t, 256> CHAR_CLASSES = buildCharClasses();
+
+inline bool hasClass(char c, uint8_t cls)
+{
+    return (CHAR_CLASSES[static_cast<unsigned char>(c)] & cls) != 0;
+}
+
+} // namespace
 
 // Helper Functions
 
-bool is_operator_char(char c)
+bool is_operator_char(char c) { return hasClass(c, CC_OPERATOR); }
+
+bool is_punctuation(char c) { return hasClass(c, CC_PUNCT); }
+
+bool is_space(char c) { return hasClass(c, CC_SPACE); }
+
+bool is_digit(char c) { return hasClass(c, CC_DIGIT); }
+
+bool is_identifier_start(char c) { return hasClass(c, CC_IDENT_START); }
+
+bool is_identifier_char(char c) { return hasClass(c, CC_IDENT); }
+
+// KEYWORD, DATA_TYPE or BOOL_LITERAL for reserved words, IDENTIFIER otherwise
+TokenType classifyWord(std::string_view text)
 {
-    // Check for characters that might start an operator
-    return std::string("+-*/%<>=!&|.").find(c) != std::string::npos;
+    const WordEntry &entry = KEYWORD_TABLE.find(text);
+    return (!text.empty() && entry.text == text) ? entry.type : TokenType::IDENTIFIER;
 }
 
-bool is_punctuation(char c) { return PUNCTUATION.count(c); }
+bool is_operator(std::string_view text)
+{
+    return !text.empty() && OPERATOR_TABLE.find(text).text == text;
+}
 
 // Token methods
 std::string Token::typeToString() const
@@ -89,7 +201,22 @@ std::string Token::typeToString() const
 
 // Tokenizer
 
-Tokenizer::Tokenizer(std::istream &inputStream) : input(inputStream), lineIndex(0), charIndex(0), eofReached(false)
+Tokenizer::Tokenizer(std::istream &inputStream, std::ostream &diagnostics) : names(ownedNames), diagnostics(diagnostics)
+{
+    std::ostringstream contents;
+    contents << inputStream.rdbuf();
+    ownedSource = contents.str();
+    source = ownedSource.data();
+    sourceSize = ownedSource.size();
+}
+
+Tokenizer::Tokenizer(const char *data, size_t size, std::ostream &diagnostics)
+    : names(ownedNames), diagnostics(diagnostics), source(data), sourceSize(size)
+{
+}
+
+Tokenizer::Tokenizer(const char *data, size_t size, StringInterner &names, std::ostream &diagnostics)
+    : names(names), diagnostics(diagnostics), source(data), sourceSize(size)
 {
 }
 
@@ -100,10 +227,11 @@ Token Tokenizer::getNextToken()
 
     char c = peek();
     int currentTokenLine = lineIndex; // Line num before consuming
+    int currentTokenColumn = static_cast<int>(pos - lineStart) + 1;
 
     if (c == '\0')
     {
-        return {TokenType::END_OF_FILE, "", currentTokenLine};
+        return {TokenType::END_OF_FILE, "", currentTokenLine, currentTokenColumn};
     }
 
     Token resultToken;
@@ -111,7 +239,9 @@ Token Tokenizer::getNextToken()
     // (Order of checks matters here)
     if (is_punctuation(c))
     {
-        resultToken = {TokenType::PUNCTUATION, std::string(1, consume()), currentTokenLine};
+        size_t start = pos;
+        consume();
+        resultToken = makeToken(TokenType::PUNCTUATION, start, currentTokenLine);
     }
     else if (c == '"')
     {
@@ -121,15 +251,15 @@ Token Tokenizer::getNextToken()
     {
         resultToken = readCharLiteral();
     }
-    else if (std::isdigit(c))
+    else if (is_digit(c))
     {
         resultToken = readNumberLiteral();
     }
-    else if (c == '.' && charIndex + 1 < currentLine.length() && std::isdigit(currentLine[charIndex + 1]))
+    else if (c == '.' && is_digit(peekNext()))
     {
         resultToken = readNumberLiteral();
     }
-    else if (std::isalpha(c) || c == '_')
+    else if (is_identifier_start(c))
     {
         resultToken = readIdentifierOrKeyword();
     }
@@ -140,17 +270,19 @@ Token Tokenizer::getNextToken()
     else
     {
         // If nothing else matched . . .
-        resultToken = {TokenType::UNKNOWN, std::string(1, consume()), currentTokenLine};
+        size_t start = pos;
+        consume();
+        resultToken = makeToken(TokenType::UNKNOWN, start, currentTokenLine);
     }
+    resultToken.column = currentTokenColumn;
 
-    // If nonempty token generated, record line num
-    if (resultToken.type != TokenType::END_OF_FILE && resultToken.type != TokenType::UNKNOWN)
+    // If nonempty token generated, record line num (tokens arrive in line order)
+    bool counts = resultToken.type != TokenType::END_OF_FILE &&
+                  (resultToken.type != TokenType::UNKNOWN || !resultToken.text.empty());
+    if (counts && resultToken.line != lastTokenLine)
     {
-        linesWithTokens.insert(resultToken.line);
-    }
-    else if (resultToken.type == TokenType::UNKNOWN && !resultToken.text.empty())
-    {
-        linesWithTokens.insert(resultToken.line); // Count line even if token unknown to keep track
+        lastTokenLine = resultToken.line;
+        effectiveLines++;
     }
 
     return resultToken;
@@ -159,42 +291,43 @@ Token Tokenizer::getNextToken()
 // Get the count of lines that contained actual tokens
 int Tokenizer::getEffectiveLineCount() const
 {
-    return linesWithTokens.size();
+    return effectiveLines;
 }
 
-// Get next char, handling line breaks
-char Tokenizer::peek()
+// Get next char without consuming; '\0' at end of input
+char Tokenizer::peek() const
 {
-    if (eofReached)
-        return '\0';
-
-    while (charIndex >= currentLine.length())
-    {
-        if (!std::getline(input, currentLine))
-        {
-            // If the very last line had content ending without newline, lineIndex might be right; fine if empty
-            eofReached = true;
-            return '\0';
-        }
+    return pos < sourceSize ? source[pos] : '\0';
+}
 
-        lineIndex++;
-        charIndex = 0;
-        currentLine += '\n'; // Add newline to handle it like whitespace
-    }
-    return currentLine[charIndex];
+// Character after the next one
+char Tokenizer::peekNext() const
+{
+    return pos + 1 < sourceSize ? source[pos + 1] : '\0';
 }
 
-// Consumes char + increments charIndex
+// Consumes char, tracking line + column as we go
 char Tokenizer::consume()
 {
     char c = peek();
     if (c != '\0')
     {
-        charIndex++;
+        pos++;
+        if (c == '\n')
+        {
+            lineIndex++;
+            lineStart = pos;
+        }
     }
     return c;
 }
 
+// Token whose text is the source range [start, pos); no bytes are copied
+Token Tokenizer::makeToken(TokenType type, size_t start, int line) const
+{
+    return {type, std::string_view(source + start, pos - start), line};
+}
+
 // Skips whitespace + comments
 void Tokenizer::skipWhitespaceAndComments()
 {
@@ -205,14 +338,14 @@ void Tokenizer::skipWhitespaceAndComments()
             return; // End of file
 
         // Whitespace
-        if (std::isspace(c))
+        if (is_space(c))
         {
             consume();
             continue;
         }
 
         // Single-line comment
-        if (c == '/' && charIndex + 1 < currentLine.length() && currentLine[charIndex + 1] == '/')
+        if (c == '/' && peekNext() == '/')
         {
             while (peek() != '\n' && peek() != '\0')
             {
@@ -222,7 +355,7 @@ void Tokenizer::skipWhitespaceAndComments()
         }
 
         // Multi-line comment
-        if (c == '/' && charIndex + 1 < currentLine.length() && currentLine[charIndex + 1] == '*')
+        if (c == '/' && peekNext() == '*')
         {
             consume(); // Consume '/'
             consume(); // Consume '*'
@@ -231,9 +364,8 @@ void Tokenizer::skipWhitespaceAndComments()
                 char next = consume();
                 if (next == '\0')
                 {
-                    std::cerr << "Warning: Unterminated multi-line comment at line " << lineIndex << std::endl;
-                    eofReached = true; // Basically treat as end of file
-                    return;
+                    diagnostics << "Warning: Unterminated multi-line comment at line " << lineIndex << std::endl;
+                    return; // Input is exhausted, treat as end of file
                 }
                 if (next == '*' && peek() == '/')
                 {
@@ -252,45 +384,36 @@ void Tokenizer::skipWhitespaceAndComments()
 // Reads an identifier or keyword
 Token Tokenizer::readIdentifierOrKeyword()
 {
-    std::string text;
+    size_t start = pos;
     int startLine = lineIndex;
-    while (true)
+    // Identifier chars never include '\n', so the line cannot change here
+    while (is_identifier_char(peek()))
     {
-        char c = peek();
-        if (c == '\0' || (!std::isalnum(c) && c != '_'))
-        {
-            break;
-        }
-        text += consume();
+        pos++;
     }
+    std::string_view text(source + start, pos - start);
 
-    if (KEYWORDS.count(text))
+    // Validate identifier format (basic check, must start with letter or underscore)
+    if (text.empty() || !is_identifier_start(text[0]))
     {
-        if (DATA_TYPES.count(text))
-        {
-            return {TokenType::DATA_TYPE, text, startLine};
-        }
-        if (text == "true" || text == "false")
-        {
-            return {TokenType::BOOL_LITERAL, text, startLine};
-        }
-        return {TokenType::KEYWORD, text, startLine};
+        // Doesn't match keyword/identifier rules
+        return makeToken(TokenType::UNKNOWN, start, startLine);
     }
 
-    // Validate identifier format (basic check, must start with letter or underscore)
-    if (!text.empty() && (std::isalpha(text[0]) || text[0] == '_'))
+    // Keywords, data types and true/false come out of one table probe
+    Token token = makeToken(classifyWord(text), start, startLine);
+    if (token.type == TokenType::IDENTIFIER)
     {
-        return {TokenType::IDENTIFIER, text, startLine};
+        token.symbol = names.intern(text);
+        token.text = names.name(token.symbol);
     }
-
-    // Doesn't match keyword/identifier rules
-    return {TokenType::UNKNOWN, text, startLine};
+    return token;
 }
 
 // Reads a number literal (integer/float/double)
 Token Tokenizer::readNumberLiteral()
 {
-    std::string text;
+    size_t start = pos;
     int startLine = lineIndex;
     bool hasDecimal = false;
     bool isFloat = false; // '.', 'f' seen
@@ -300,27 +423,28 @@ Token Tokenizer::readNumberLiteral()
         // Already confirmed in getNextToken that this '.' is followed by a digit
         hasDecimal = true;
         isFloat = true;
-        text += consume(); // Consume the leading '.'
+        consume(); // Consume the leading '.'
     }
 
     // Now consume digits and potentially 1 more '.' (which shouldn't happen if started with '.')
     while (true)
     {
         char c = peek();
-        if (std::isdigit(c))
+        size_t length = pos - start;
+        if (is_digit(c))
         {
-            text += consume();
+            consume();
         }
         else if (c == '.' && !hasDecimal)
         {
             hasDecimal = true;
             isFloat = true;
-            text += consume();
+            consume();
         }
-        else if (c == 'f' && !text.empty() && text != ".")
+        else if (c == 'f' && length > 0 && !(length == 1 && source[start] == '.'))
         {
             isFloat = true;
-            text += consume();
+            consume();
             break; // Assume 'f' ends the float literal
         }
         else
@@ -330,81 +454,131 @@ Token Tokenizer::readNumberLiteral()
     }
 
     // Determine type based on whether a decimal point or 'f' was encountered
-    return {isFloat ? TokenType::FLOAT_LITERAL : TokenType::INTEGER_LITERAL, text, startLine};
+    return makeToken(isFloat ? TokenType::FLOAT_LITERAL : TokenType::INTEGER_LITERAL, start, startLine);
 }
 
-// Reads a string literal
+// Reads a string literal (text excludes the quotes)
 Token Tokenizer::readStringLiteral()
 {
-    std::string text;
     int startLine = lineIndex;
     consume(); // Consume opening '"'
+    size_t start = pos;
     while (peek() != '"')
     {
-        char c = consume();
+        char c = peek();
         if (c == '\0' || c == '\n')
         {
             // Check for unterminated string
-            std::cerr << "Warning: Unterminated string literal at line " << startLine << std::endl;
-            return {TokenType::UNKNOWN, text, startLine};
+            diagnostics << "Warning: Unterminated string literal at line " << startLine << std::endl;
+            Token unterminated = makeToken(TokenType::UNKNOWN, start, startLine);
+            consume();
+            return unterminated;
         }
         // (Basic ver: doesn't handle escape sequences like \")
-        text += c;
+        consume();
     }
+    Token result = makeToken(TokenType::STRING_LITERAL, start, startLine);
     consume(); // Consume closing '"'
-    return {TokenType::STRING_LITERAL, text, startLine};
+    return result;
 }
 
-// Reads a char literal
+// Reads a char literal (text excludes the quotes)
 Token Tokenizer::readCharLiteral()
 {
-    std::string text;
     int startLine = lineIndex;
     consume();            // Consume opening '''
+    size_t start = pos;
     char val = consume(); // Get the character
     if (val == '\0' || val == '\n')
     {
-        std::cerr << "Warning: Unterminated char literal at line " << startLine << std::endl;
+        diagnostics << "Warning: Unterminated char literal at line " << startLine << std::endl;
         return {TokenType::UNKNOWN, "", startLine};
     }
 
     // (Basic ver: doesn't handle escape sequences like \')
-    text += val;
+    Token result = makeToken(TokenType::CHAR_LITERAL, start, startLine);
     if (peek() != '\'')
     {
-        std::cerr << "Warning: Multi-character char literal or unterminated char literal at line " << startLine << std::endl;
+        diagnostics << "Warning: Multi-character char literal or unterminated char literal at line " << startLine << std::endl;
         // Consume until ' or newline/EOF for basic recovery
         while (peek() != '\'' && peek() != '\n' && peek() != '\0')
             consume();
         if (peek() == '\'')
             consume(); // Consume closing quote if found
-        return {TokenType::UNKNOWN, text, startLine};
+        result.type = TokenType::UNKNOWN;
+        return result;
     }
 
     consume(); // Consume closing '''
-    return {TokenType::CHAR_LITERAL, text, startLine};
+    return result;
 }
 
 // Reads an operator
 Token Tokenizer::readOperator()
 {
-    std::string text;
+    size_t start = pos;
     int startLine = lineIndex;
-    char c1 = consume();
-    text += c1;
+    consume();
 
     // Check for two-character operators
-    char c2 = peek();
-    std::string twoCharOp = text + c2;
-    if (OPERATORS.count(twoCharOp))
+    if (pos < sourceSize && is_operator(std::string_view(source + start, 2)))
     {
-        text += consume(); // Consume second char
+        consume(); // Consume second char
     }
-    else if (!OPERATORS.count(text))
+    else if (!is_operator(std::string_view(source + start, 1)))
     {
         // If the single char wasn't an operator either (rare case!)
-        return {TokenType::UNKNOWN, text, startLine};
+        return makeToken(TokenType::UNKNOWN, start, startLine);
     }
 
-    return {TokenType::OPERATOR, text, startLine};
+    return makeToken(TokenType::OPERATOR, start, startLine);
+}
+
+// The bytes a C++ compiler would store for a string literal's escapes
+std::string decodeEscapes(std::string_view text)
+{
+    std::string out;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        if (text[i] != '\\' || i + 1 == text.size())
+        {
+            out += text[i];
+            continue;
+        }
+        char e = text[++i];
+        switch (e)
+        {
+        case 'n': out += '\n'; break;
+        case 't': out += '\t'; break;
+        case 'r': out += '\r'; break;
+        case 'a': out += '\a'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'v': out += '\v'; break;
+        case 'x': {
+            unsigned value = 0;
+            while (i + 1 < text.size() && std::isxdigit(static_cast<unsigned char>(text[i + 1])))
+            {
+                char h = text[++i];
+                value = value * 16 + (h <= '9' ? h - '0' : (h | 0x20) - 'a' + 10);
+            }
+            out += static_cast<char>(value);
+            break;
+        }
+        default:
+            if (e >= '0' && e <= '7')
+            {
+                unsigned value = e - '0';
+                for (int digits = 1; digits < 3 && i + 1 < text.size() && text[i + 1] >= '0' && text[i + 1] <= '7'; digits++)
+                    value = value * 8 + (text[++i] - '0');
+                out += static_cast<char>(value);
+            }
+            else
+            {
+                out += e; // \\ \" \' \?
+            }
+            break;
+        }
+    }
+    return out;
 }
@@ -2,12 +2,14 @@
 #define TOKENIZER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <set>
 #include <iostream>
 #include <sstream>
 #include <cctype>
 #include <algorithm>
+#include "stringInterner.h"
 
 // Define categories for tokens
 enum class TokenType
@@ -30,30 +32,49 @@ enum class TokenType
 struct Token
 {
     TokenType type;
-    std::string text;
+    std::string_view text; // Points into the tokenizer's source buffer, or the interner for identifiers
     int line;
+    int column = 0;
+    SymbolId symbol = NO_SYMBOL; // Interned ID, set for IDENTIFIER tokens only
 
     std::string typeToString() const;
 };
 
 // Tokenizer class
+// Lexes straight out of one contiguous buffer: token text is a view into
+// that buffer, so the buffer must outlive every token handed out.
+// Identifiers are interned as they are read; pass a StringInterner to share
+// the IDs with later phases, otherwise the tokenizer keeps its own.
 class Tokenizer
 {
 public:
-	Tokenizer(std::istream &inputStream);
+	// Warnings go to 'diagnostics'
+	Tokenizer(std::istream &inputStream, std::ostream &diagnostics = std::cerr); // Reads the whole stream into an owned buffer
+	Tokenizer(const char *data, size_t size, std::ostream &diagnostics = std::cerr); // Caller-owned buffer, e.g. a SourceBuffer
+	Tokenizer(const char *data, size_t size, StringInterner &names, std::ostream &diagnostics = std::cerr);
+	Tokenizer(const Tokenizer &) = delete;
+	Tokenizer &operator=(const Tokenizer &) = delete;
+
 	Token getNextToken();
 	int getEffectiveLineCount() const;
 
 private:
-	std::istream &input;
-	std::string currentLine;
-	int lineIndex = 0; // Current line number (1-based for reporting)
-	int charIndex = 0; // Current character index within currentLine
-	bool eofReached = false;
-	std::set<int> linesWithTokens; // Keep track of lines that generated tokens
+	std::string ownedSource; // Only used by the istream constructor
+	StringInterner ownedNames; // Used unless the caller passes an interner
+	StringInterner &names;
+	std::ostream &diagnostics;
+	const char *source;
+	size_t sourceSize;
+	size_t pos = 0;       // Offset of the next unread character
+	size_t lineStart = 0; // Offset of the first character of the current line
+	int lineIndex = 1;    // Current line number (1-based for reporting)
+	int effectiveLines = 0; // Lines that generated tokens
+	int lastTokenLine = 0;
 
-	char peek();
+	char peek() const;
+	char peekNext() const;
 	char consume();
+	Token makeToken(TokenType type, size_t start, int line) const;
 	void skipWhitespaceAndComments();
 	Token readIdentifierOrKeyword();
 	Token readNumberLiteral();
@@ -62,12 +83,20 @@ private:
 	Token readOperator();
 };
 
-extern const std::set<std::string> KEYWORDS;
-extern const std::set<std::string> DATA_TYPES;
-extern const std::set<std::string> OPERATORS;
-extern const std::set<char> PUNCTUATION;
-
+// Character classes (256-entry lookup table)
 bool is_operator_char(char c);
 bool is_punctuation(char c);
+bool is_space(char c);
+bool is_digit(char c);
+bool is_identifier_start(char c);
+bool is_identifier_char(char c);
+
+// Reserved-word and operator lookups (compile-time perfect hashes)
+TokenType classifyWord(std::string_view text);
+bool is_operator(std::string_view text);
+
+// The bytes a C++ compiler would store for a string literal's escapes.
+// String tokens keep their source text, which the C++ backend copies as is.
+std::string decodeEscapes(std::string_view text);
 
 #endif // TOKENIZER_H
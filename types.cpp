@@ -0,0 +1,27 @@
+#include "types.h"
+
+namespace types
+{
+
+const Type Int{TypeKind::Int, "int"};
+const Type Float{TypeKind::Float, "float"};
+const Type Double{TypeKind::Double, "double"};
+const Type Bool{TypeKind::Bool, "bool"};
+const Type Char{TypeKind::Char, "char"};
+const Type String{TypeKind::String, "string"};
+const Type Void{TypeKind::Void, "void"};
+const Type Function{TypeKind::Function, "func"};
+const Type Param{TypeKind::Param, "param"};
+
+const Type *fromName(std::string_view name)
+{
+    static const Type *const builtins[] = {&Int, &Float, &Double, &Bool, &Char, &String, &Void};
+    for (const Type *type : builtins)
+    {
+        if (name == type->name)
+            return type;
+    }
+    return nullptr;
+}
+
+} // namespace types
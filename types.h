@@ -0,0 +1,50 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+#include <string_view>
+
+enum class TypeKind : unsigned char
+{
+	Int,
+	Float,
+	Double,
+	Bool,
+	Char,
+	String,
+	Void,
+	Function,
+	Param // Function parameter; parameters carry no declared type yet
+};
+
+// Interned type descriptor. There is exactly one Type per distinct type, so
+// two types are equal iff their pointers are, and passes hold them as
+// 'const Type *' with nullptr meaning "unknown". 'element' is unused by the
+// builtin types and is there for compound types (arrays, function
+// signatures) that will be interned next to them.
+struct Type
+{
+	TypeKind kind;
+	const char *name;
+	const Type *element = nullptr;
+
+	bool isNumeric() const { return kind == TypeKind::Int || kind == TypeKind::Float || kind == TypeKind::Double; }
+	bool isFloating() const { return kind == TypeKind::Float || kind == TypeKind::Double; }
+};
+
+namespace types
+{
+	extern const Type Int;
+	extern const Type Float;
+	extern const Type Double;
+	extern const Type Bool;
+	extern const Type Char;
+	extern const Type String;
+	extern const Type Void;
+	extern const Type Function;
+	extern const Type Param;
+
+	// Builtin type for a DATA_TYPE keyword; nullptr if there is none
+	const Type *fromName(std::string_view name);
+}
+
+#endif // TYPES_H